@@ -1,14 +1,35 @@
-#include <algorithm>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
+#include <future>
 #include <iostream>
-#include <sstream>
+#include <limits>
+#include <map>
+#include <optional>
 #include <string>
 #include <vector>
 #include <cstdlib>
+#include "core/closure/closure.h"
+#include "core/codegen/build_profile.h"
 #include "core/codegen/codegen.h"
-#include "core/lexer/lexer.h"
-#include "core/parser/parser.h"
+#include "core/codegen/runtime.h"
+#include "core/interpreter/interpreter.h"
+#include "core/jit/jit.h"
+#include "core/process/compile_cache.h"
+#include "core/process/memory_file.h"
+#include "core/process/precompiled_header.h"
+#include "core/process/process.h"
+#include "core/process/workspace.h"
+#include "core/tools/batch.h"
+#include "core/tools/benchmark.h"
+#include "core/tools/compile_batch.h"
+#include "core/tools/heatmap.h"
+#include "core/tools/line_profile.h"
+#include "core/tools/native_build.h"
+#include "core/tools/opcode_profile.h"
+#include "core/tools/pgo.h"
+#include "core/tools/sessions.h"
+#include "core/tools/tool_support.h"
+#include "core/vm/vm.h"
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -16,9 +37,53 @@
 #endif
 
 namespace fs = std::filesystem;
+using bearlang::ClosureEngine;
 using bearlang::CodeGenerator;
-using bearlang::Lexer;
-using bearlang::Parser;
+using bearlang::CodegenOptions;
+using bearlang::Interpreter;
+using bearlang::Jit;
+using bearlang::VirtualMachine;
+
+enum class RunMode {
+    // Execute the program inside bearlang_app right away.
+    Interpret,
+    // Same, but every node compiled once into a type-specialised closure.
+    Closures,
+    // Same, but compiled to register bytecode first (for heavy loops).
+    Vm,
+    // Bytecode translated to x86-64 machine code in-process.
+    Jit,
+    // Compile the generated C++ with g++ and run the binary.
+    Native,
+    // Interpret right away while g++ builds in the background; later runs
+    // of the same program use the binary.
+    Tiered,
+};
+
+// Size sweepWorkspaceRoot keeps the job directories of stale runs under.
+constexpr std::uintmax_t kWorkRootLimitBytes = 512ull * 1024 * 1024;
+// Size of out/cache beyond which the least recently used binaries go.
+constexpr std::uintmax_t kCompileCacheLimitBytes = 256ull * 1024 * 1024;
+
+struct AppOptions {
+    RunMode mode = RunMode::Interpret;
+    CodegenOptions codegen;
+    // Under Tiered: once an in-process run of a program took this long, the
+    // next run waits for its binary instead of interpreting again.
+    double promoteAfterMs = 500.0;
+    // Where every g++ build gets its own JobWorkspace.
+    fs::path workRoot;
+    // Binaries of earlier builds; null with --no-cache.
+    bearlang::CompileCache* compileCache = nullptr;
+    // Under Native: compile and run without files (compileInMemoryAndRun).
+    bool diskless = false;
+    // The minimal runtime as a precompiled header; null with --no-pch and
+    // --diskless.
+    bearlang::PrecompiledHeader* runtimeHeader = nullptr;
+    // --build-profile; unset, every program gets the one chooseBuildProfile
+    // picks for it.
+    std::optional<bearlang::BuildProfile> buildProfile;
+};
 
 fs::path executableDir() {
 #ifdef _WIN32
@@ -60,75 +125,295 @@ fs::path findProjectRoot(const fs::path& startDir) {
     return startDir;
 }
 
-std::string readAll(const fs::path& path) {
-    std::ifstream in(path, std::ios::binary);
-    if (!in) {
-        throw std::runtime_error("Не удалось открыть файл: " + path.string());
+// The copy learners open. Another terminal may be saving its own program at
+// the same moment; the last one wins, but the file is never a mix of both.
+void saveGeneratedSource(const std::string& cppSource, const fs::path& workspace) {
+    fs::create_directories(workspace);
+    fs::path cppPath = workspace / "generated_program.cpp";
+    bearlang::writeFileAtomically(cppPath, cppSource);
+    std::cout << "C++ код сохранён в: " << cppPath << "\n";
+}
+
+bool runExecutable(const fs::path& exePath) {
+    std::cout << "\n--- Результат программы ---\n";
+    std::cout.flush();
+    bearlang::ProcessResult run = bearlang::runProcess({exePath.string()});
+    std::cout << "\n---------------------------\n";
+    if (!run.succeeded()) {
+        std::cout << "Программа завершилась с ошибкой: " << bearlang::describeExit(run) << "\n";
     }
-    std::ostringstream buffer;
-    buffer << in.rdbuf();
-    return buffer.str();
+    return run.succeeded();
 }
 
-std::vector<fs::path> loadExamples(const fs::path& examplesDir) {
-    std::vector<fs::path> files;
-    if (!fs::exists(examplesDir)) {
-        return files;
+// --diskless: nothing is written to out/ or the work directory, and the
+// compile cache is neither read nor filled.
+bool compileInMemoryAndRun(const std::string& cppSource, const std::vector<std::string>& flags) {
+    bearlang::MemoryFile binary;
+    std::cout << "Компиляция в памяти...\n";
+    bearlang::ProcessResult build = bearlang::compileInMemory(cppSource, binary, flags);
+    if (!build.succeeded()) {
+        bearlang::reportCompileFailure(build);
+        return false;
     }
-    for (const auto& entry : fs::directory_iterator(examplesDir)) {
-        if (!entry.is_regular_file()) {
-            continue;
-        }
-        if (entry.path().extension() == ".txt") {
-            files.push_back(entry.path());
-        }
+    std::cout << build.output << build.errors << "g++: " << bearlang::formatTimes(build)
+              << ", программа в памяти: " << binary.size() / 1024 << " КБ\n";
+    auto start = std::chrono::steady_clock::now();
+    bool ok = runExecutable(binary.executablePath());
+    std::cout << "Запуск: " << bearlang::millisecondsSince(start) << " мс\n";
+    return ok;
+}
+
+bool compileAndRun(const std::string& cppSource, const std::vector<std::string>& flags, const AppOptions& options) {
+    bearlang::JobWorkspace job(options.workRoot);
+    fs::path exePath = bearlang::executablePath(job);
+
+    auto start = std::chrono::steady_clock::now();
+    bearlang::NativeBuild build =
+        bearlang::buildNative(cppSource, flags, job.file("program.cpp"), exePath, options.compileCache);
+    if (!build.succeeded()) {
+        bearlang::reportCompileFailure(build.compile);
+        return false;
     }
-    std::sort(files.begin(), files.end());
-    return files;
+    if (build.fromCache) {
+        std::cout << "g++: не нужен, программа из кэша сборок (" << bearlang::millisecondsSince(start)
+                  << " мс)\n";
+    } else {
+        std::cout << build.compile.output << build.compile.errors << "g++: "
+                  << bearlang::formatTimes(build.compile) << "\n";
+    }
+    if (options.compileCache != nullptr) {
+        bearlang::printCacheStats(*options.compileCache);
+    }
+
+    start = std::chrono::steady_clock::now();
+    bool ok = runExecutable(exePath);
+    std::cout << "Запуск: " << bearlang::millisecondsSince(start) << " мс\n";
+    return ok;
 }
 
-bool compileAndRun(const std::string& cppSource, const fs::path& workspace) {
-    fs::create_directories(workspace);
-    fs::path cppPath = workspace / "generated_program.cpp";
-    fs::path exePath = workspace / "generated_program";
-#ifdef _WIN32
-    exePath += ".exe";
-#endif
+// std::cin as the running program sees it. Remembers whether the program
+// tried to read, so the menu knows to drop the rest of that line: the '\n'
+// after a number, or the token a failed read did not consume.
+class ProgramInput : public std::streambuf {
+public:
+    explicit ProgramInput(std::streambuf* source) : source_(source) {}
 
-    std::ofstream out(cppPath);
-    out << cppSource;
-    out.close();
+    bool used() const {
+        return used_;
+    }
 
-    std::cout << "C++ код сохранён в: " << cppPath << "\n";
+protected:
+    int_type underflow() override {
+        used_ = true;
+        return source_->sgetc();
+    }
 
-    std::string compileCommand = "g++ -std=gnu++11 \"" + cppPath.string() + "\" -o \"" + exePath.string() + "\"";
-    std::cout << "Компиляция...\n";
-    int compileResult = std::system(compileCommand.c_str());
-    if (compileResult != 0) {
-        std::cerr << "Компилятор вернул ошибку." << std::endl;
-        return false;
+    int_type uflow() override {
+        used_ = true;
+        return source_->sbumpc();
+    }
+
+    int_type pbackfail(int_type) override {
+        return source_->sungetc();
     }
 
+private:
+    std::streambuf* source_;
+    bool used_ = false;
+};
+
+// Runs the program in-process with the engine selected by the run mode.
+void runInProcess(const bearlang::Program& program,
+                  std::istream& in,
+                  std::ostream& out,
+                  const AppOptions& options) {
+    if (options.mode == RunMode::Closures) {
+        bearlang::ClosureOptions closureOptions;
+        closureOptions.bufferedOutput = options.codegen.bufferedOutput;
+        ClosureEngine::run(program, in, out, closureOptions);
+        return;
+    }
+    if (options.mode == RunMode::Vm) {
+        bearlang::VmOptions vmOptions;
+        vmOptions.bufferedOutput = options.codegen.bufferedOutput;
+        VirtualMachine::run(program, in, out, vmOptions);
+        return;
+    }
+    if (options.mode == RunMode::Jit) {
+        bearlang::JitOptions jitOptions;
+        jitOptions.bufferedOutput = options.codegen.bufferedOutput;
+        Jit::run(program, in, out, jitOptions);
+        return;
+    }
+    bearlang::InterpreterOptions interpreterOptions;
+    interpreterOptions.bufferedOutput = options.codegen.bufferedOutput;
+    Interpreter::run(program, in, out, interpreterOptions);
+}
+
+bool interpret(const bearlang::Program& program, const AppOptions& options) {
     std::cout << "\n--- Результат программы ---\n";
-#ifdef _WIN32
-    std::string runCommand = "\"" + exePath.string() + "\"";
-#else
-    std::string runCommand = "\"" + exePath.string() + "\"";
-#endif
-    int runResult = std::system(runCommand.c_str());
+    ProgramInput input(std::cin.rdbuf());
+    std::istream programInput(&input);
+    bool ok = true;
+    try {
+        runInProcess(program, programInput, std::cout, options);
+    } catch (const bearlang::RuntimeError& ex) {
+        std::cout.flush();
+        std::cerr << "Ошибка выполнения: " << ex.what() << std::endl;
+        ok = false;
+    }
+    if (input.used()) {
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
     std::cout << "\n---------------------------\n";
-    return runResult == 0;
+    return ok;
+}
+
+// Tier 1 is the in-process interpreter, tier 2 the g++ binary. Builds are
+// keyed by the generated C++, so an edited program starts a new build, and
+// each run reports which tier ran and how long every tier took. Every build
+// has its own JobWorkspace under `workRoot`.
+class TieredRunner {
+public:
+    explicit TieredRunner(fs::path workRoot) : workRoot_(std::move(workRoot)) {}
+
+    TieredRunner(const TieredRunner&) = delete;
+    TieredRunner& operator=(const TieredRunner&) = delete;
+
+    // Waits for builds still running; their workspaces go with builds_.
+    ~TieredRunner() {
+        for (auto& entry : builds_) {
+            entry.second.result.wait();
+        }
+    }
+
+    bool run(const bearlang::Program& program,
+             const std::string& cppSource,
+             const std::vector<std::string>& flags,
+             const AppOptions& options) {
+        Build& build = buildFor(cppSource, flags, options.compileCache);
+        bool ready = build.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (!ready && build.inProcessMs >= options.promoteAfterMs) {
+            std::cout << "Программа работает долго: ждём, пока g++ её соберёт..." << std::endl;
+            build.result.wait();
+            ready = true;
+        }
+
+        if (ready && build.result.get().compiled) {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = runExecutable(build.exePath);
+            std::cout << "Уровень: машинный код g++, запуск " << bearlang::millisecondsSince(start) << " мс (";
+            if (build.result.get().fromCache) {
+                std::cout << "из кэша сборок";
+            } else {
+                std::cout << "сборка " << build.result.get().milliseconds << " мс шла в фоне";
+            }
+            std::cout << ")" << std::endl;
+            return ok;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = interpret(program, options);
+        build.inProcessMs = bearlang::millisecondsSince(start);
+        std::cout << "Уровень: интерпретатор, " << build.inProcessMs << " мс; g++: ";
+        if (!ready) {
+            std::cout << "ещё собирает";
+        } else {
+            std::cout << "ошибка сборки, остаёмся в интерпретаторе";
+        }
+        std::cout << std::endl;
+        return ok;
+    }
+
+private:
+    struct BuildResult {
+        bool compiled;
+        bool fromCache;
+        double milliseconds;
+    };
+
+    struct Build {
+        std::optional<bearlang::JobWorkspace> job;
+        fs::path exePath;
+        std::shared_future<BuildResult> result;
+        // Duration of the last interpreted run, compared with promoteAfterMs.
+        double inProcessMs = 0.0;
+    };
+
+    Build& buildFor(const std::string& cppSource,
+                    const std::vector<std::string>& flags,
+                    bearlang::CompileCache* cache) {
+        std::string key = cppSource;
+        for (const auto& flag : flags) {
+            key += "\n" + flag;
+        }
+        auto found = builds_.find(key);
+        if (found != builds_.end()) {
+            return found->second;
+        }
+        Build build;
+        build.job.emplace(workRoot_);
+        build.exePath = bearlang::executablePath(*build.job);
+        fs::path cppPath = build.job->file("program.cpp");
+        // A cached binary is ready for the very first run.
+        auto start = std::chrono::steady_clock::now();
+        if (bearlang::fetchCachedBuild(cache, cppSource, flags, build.exePath)) {
+            std::promise<BuildResult> cached;
+            cached.set_value(BuildResult{true, true, bearlang::millisecondsSince(start)});
+            build.result = cached.get_future().share();
+        } else {
+            build.result = std::async(std::launch::async, [cppSource, flags, cppPath, exePath = build.exePath, cache, start]() {
+                               bool compiled =
+                                   bearlang::compileAndCache(cache, cppSource, flags, cppPath, exePath).succeeded();
+                               return BuildResult{compiled, false, bearlang::millisecondsSince(start)};
+                           }).share();
+        }
+        return builds_.emplace(key, std::move(build)).first->second;
+    }
+
+    fs::path workRoot_;
+    std::map<std::string, Build> builds_;
+};
+
+// The --build-profile override, or else the profile the program's estimated
+// work calls for; says which and why.
+bearlang::BuildProfile selectBuildProfile(const bearlang::Program& program, const AppOptions& options) {
+    if (options.buildProfile) {
+        std::cout << "Профиль сборки: " << bearlang::buildProfileName(*options.buildProfile)
+                  << " (задан --build-profile)\n";
+        return *options.buildProfile;
+    }
+    bearlang::WorkEstimate estimate = bearlang::estimateWork(program);
+    bearlang::BuildProfile profile = bearlang::chooseBuildProfile(estimate);
+    std::cout << "Профиль сборки: " << bearlang::buildProfileName(profile) << " (вложенность циклов "
+              << estimate.loopDepth << ", операций ≈ " << estimate.operations << ")\n";
+    return profile;
 }
 
-bool translateAndRun(const fs::path& sourcePath, const fs::path& workspace) {
+bool translateAndRun(const fs::path& sourcePath,
+                     const fs::path& workspace,
+                     const AppOptions& options,
+                     TieredRunner& tiered) {
     try {
-        std::string source = readAll(sourcePath);
-        Lexer lexer(source);
-        auto tokens = lexer.tokenize();
-        Parser parser(std::move(tokens));
-        bearlang::Program program = parser.parseProgram();
-        std::string cppSource = CodeGenerator::generate(program);
-        return compileAndRun(cppSource, workspace);
+        bearlang::Program program = bearlang::parseFile(sourcePath);
+        std::string cppSource = CodeGenerator::generate(program, options.codegen);
+        if (options.mode == RunMode::Native || options.mode == RunMode::Tiered) {
+            bearlang::BuildProfile profile = selectBuildProfile(program, options);
+            const std::vector<std::string>& flags = bearlang::profileFlags(profile);
+            bearlang::PrecompiledHeader* runtimeHeader =
+                profile == bearlang::BuildProfile::Instant ? options.runtimeHeader : nullptr;
+            std::string nativeSource = bearlang::buildSource(program, options.codegen, runtimeHeader);
+            if (options.diskless) {
+                return compileInMemoryAndRun(nativeSource, flags);
+            }
+            saveGeneratedSource(cppSource, workspace);
+            if (options.mode == RunMode::Native) {
+                return compileAndRun(nativeSource, flags, options);
+            }
+            return tiered.run(program, nativeSource, flags, options);
+        }
+        saveGeneratedSource(cppSource, workspace);
+        return interpret(program, options);
     } catch (const std::exception& ex) {
         std::cerr << "Ошибка: " << ex.what() << std::endl;
         return false;
@@ -143,17 +428,230 @@ void printMenu() {
     std::cout << "Выбор: ";
 }
 
-int main() {
+void printUsage() {
+    std::cout << "Использование: bearlang_app [--closures | --vm | --jit | --native | --diskless | --tiered [мс]]"
+              << " [--unbuffered] [--work-dir <папка>] [--cache-dir <папка> | --no-cache] [--no-pch]"
+              << " [--build-profile instant|fast]" << std::endl;
+    std::cout << "               bearlang_app --cache-stats" << std::endl;
+    std::cout << "               bearlang_app --benchmark <файл.txt> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --opcode-profile <файл.txt> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --line-profile <файл.txt> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --heatmap <файл.txt> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --sessions <N> <файл.txt> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --batch <N> <файл.txt> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --compile-batch <папка> [файл ввода]" << std::endl;
+    std::cout << "               bearlang_app --pgo <файл.txt> [файлы ввода...]" << std::endl;
+    std::cout << "  --closures    компилировать программу в дерево замыканий под типы переменных"
+              << std::endl;
+    std::cout << "  --vm          запускать через байткод-машину (быстрее на долгих циклах)" << std::endl;
+    std::cout << "  --jit         переводить байткод в машинный код x86-64 (самые долгие циклы)"
+              << std::endl;
+    std::cout << "  --native      компилировать C++ через g++ вместо мгновенного запуска" << std::endl;
+    std::cout << "  --diskless    как --native, но без файлов: C++ в g++ через канал, программа в памяти"
+              << std::endl;
+    std::cout << "  --tiered      запускать сразу, а g++ собирать в фоне для следующих запусков;"
+              << std::endl;
+    std::cout << "                после запуска дольше [мс] (500) следующий ждёт сборку" << std::endl;
+    std::cout << "  --unbuffered  сбрасывать вывод после каждой строки (для интерактивных уроков)"
+              << std::endl;
+    std::cout << "  --work-dir    где создавать папки сборок g++ (или BEARLANG_WORK_DIR; по умолчанию out/jobs)"
+              << std::endl;
+    std::cout << "  --cache-dir   кэш собранных программ (или BEARLANG_CACHE_DIR; по умолчанию out/cache)"
+              << std::endl;
+    std::cout << "  --no-cache    всегда собирать заново через g++" << std::endl;
+    std::cout << "  --no-pch      не брать среду выполнения из предкомпилированного заголовка"
+              << std::endl;
+    std::cout << "  --build-profile  instant: быстрая сборка (-O0), fast: быстрая программа (-O2, static);"
+              << " по умолчанию выбирается по циклам программы" << std::endl;
+    std::cout << "  --cache-stats попадания, промахи и размер кэша сборок" << std::endl;
+    std::cout << "  --benchmark   сравнить время интерпретатора, байткода и g++ на одной программе"
+              << std::endl;
+    std::cout << "  --opcode-profile  время и число выполнений каждого опкода байткода" << std::endl;
+    std::cout << "  --line-profile    время и число операций каждой строки программы и каждого цикла"
+              << std::endl;
+    std::cout << "  --heatmap     сколько раз выполнилась каждая строка в программе, собранной g++"
+              << std::endl;
+    std::cout << "  --sessions    N копий программы по очереди в одном потоке, ввод построчно"
+              << std::endl;
+    std::cout << "  --batch       N запусков подряд через g++ и на пуле из 1..64 потоков" << std::endl;
+    std::cout << "  --compile-batch  все программы папки одной сборкой g++ на ядро; программ в секунду"
+              << std::endl;
+    std::cout << "  --pgo         сборка -O2 по профилю запусков на примерах ввода; ускорение против -O2"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
 #ifdef _WIN32
     SetConsoleCP(CP_UTF8);
     SetConsoleOutputCP(CP_UTF8);
 #endif
+    AppOptions options;
+    // `--benchmark`, `--opcode-profile`, `--line-profile`, `--heatmap`,
+    // `--sessions`, `--batch` and `--pgo` measure one program and exit;
+    // `--compile-batch` takes a folder of them in `toolSource`.
+    std::string tool;
+    fs::path toolSource;
+    fs::path toolInput;
+    // Sample inputs of `--pgo` after the first, which is `toolInput`.
+    std::vector<fs::path> pgoInputs;
+    // N of `--sessions` / `--batch`.
+    std::size_t runCount = 0;
+    fs::path cacheDir;
+    bool useCache = true;
+    bool usePch = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--native") {
+            options.mode = RunMode::Native;
+        } else if (arg == "--closures") {
+            options.mode = RunMode::Closures;
+        } else if (arg == "--vm") {
+            options.mode = RunMode::Vm;
+        } else if (arg == "--jit") {
+            options.mode = RunMode::Jit;
+        } else if (arg == "--tiered") {
+            options.mode = RunMode::Tiered;
+            if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                try {
+                    options.promoteAfterMs = std::stod(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "Ожидалось число миллисекунд после --tiered" << std::endl;
+                    return 1;
+                }
+            }
+        } else if ((arg == "--benchmark" || arg == "--opcode-profile" || arg == "--line-profile" ||
+                    arg == "--heatmap" || arg == "--sessions" || arg == "--batch" ||
+                    arg == "--compile-batch" || arg == "--pgo") &&
+                   i + 1 < argc) {
+            tool = arg;
+            if (arg == "--sessions" || arg == "--batch") {
+                try {
+                    runCount = std::stoul(argv[++i]);
+                } catch (const std::exception&) {
+                    std::cerr << "Ожидалось число запусков после " << arg << std::endl;
+                    return 1;
+                }
+                if (i + 1 >= argc) {
+                    printUsage();
+                    return 1;
+                }
+            }
+            toolSource = argv[++i];
+            if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                toolInput = argv[++i];
+            }
+            // `--pgo` takes any number of sample inputs.
+            while (arg == "--pgo" && i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                pgoInputs.push_back(argv[++i]);
+            }
+        } else if (arg == "--unbuffered") {
+            options.codegen.bufferedOutput = false;
+        } else if (arg == "--work-dir" && i + 1 < argc) {
+            options.workRoot = argv[++i];
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--diskless") {
+            if (!bearlang::MemoryFile::available()) {
+                std::cerr << "--diskless работает только в Linux" << std::endl;
+                return 1;
+            }
+            options.mode = RunMode::Native;
+            options.diskless = true;
+        } else if (arg == "--no-cache") {
+            useCache = false;
+        } else if (arg == "--no-pch") {
+            usePch = false;
+        } else if (arg == "--build-profile" && i + 1 < argc) {
+            bearlang::BuildProfile profile;
+            if (!bearlang::parseBuildProfile(argv[++i], profile)) {
+                std::cerr << "Ожидалось instant или fast после --build-profile" << std::endl;
+                return 1;
+            }
+            options.buildProfile = profile;
+        } else if (arg == "--cache-stats") {
+            tool = arg;
+        } else {
+            std::cerr << "Неизвестный параметр: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
     fs::path root = findProjectRoot(executableDir());
     fs::path examplesDir = root / "examples";
     fs::path buildDir = root / "out";
     fs::create_directories(buildDir);
+    if (options.workRoot.empty()) {
+        const char* configured = std::getenv("BEARLANG_WORK_DIR");
+        options.workRoot = configured != nullptr && *configured != '\0' ? fs::path(configured) : buildDir / "jobs";
+    }
+    std::error_code workRootError;
+    fs::create_directories(options.workRoot, workRootError);
+    if (workRootError) {
+        std::cerr << "Не удалось создать папку для сборок " << options.workRoot << ": "
+                  << workRootError.message() << std::endl;
+        return 1;
+    }
+    // Jobs of crashed runs leave their directories behind; the next start
+    // removes them before the root grows past the limit.
+    bearlang::sweepWorkspaceRoot(options.workRoot, kWorkRootLimitBytes);
+    if (cacheDir.empty()) {
+        const char* configured = std::getenv("BEARLANG_CACHE_DIR");
+        cacheDir = configured != nullptr && *configured != '\0' ? fs::path(configured) : buildDir / "cache";
+    }
+    std::optional<bearlang::CompileCache> compileCache;
+    if (useCache) {
+        compileCache.emplace(cacheDir, kCompileCacheLimitBytes);
+        options.compileCache = &*compileCache;
+    }
+    // Beside the cache, but --no-cache still uses it.
+    std::optional<bearlang::PrecompiledHeader> runtimeHeader;
+    if (usePch && !options.diskless) {
+        runtimeHeader.emplace(cacheDir / "pch", bearlang::gppCommand({}), bearlang::compilerIdentity(),
+                              bearlang::runtimeHeader());
+        options.runtimeHeader = &*runtimeHeader;
+    }
+
+    if (tool == "--cache-stats") {
+        if (!compileCache) {
+            compileCache.emplace(cacheDir, kCompileCacheLimitBytes);
+        }
+        std::cout << compileCache->directory().string() << "\n";
+        bearlang::printCacheStats(*compileCache);
+        return 0;
+    }
+
+    if (tool == "--benchmark") {
+        return bearlang::runBenchmark(toolSource, toolInput, options.workRoot, options.runtimeHeader);
+    }
+    if (tool == "--opcode-profile") {
+        return bearlang::runOpcodeProfile(toolSource, toolInput);
+    }
+    if (tool == "--line-profile") {
+        return bearlang::runLineProfile(toolSource, toolInput);
+    }
+    if (tool == "--heatmap") {
+        return bearlang::runHeatMap(toolSource, toolInput, options.workRoot, options.runtimeHeader);
+    }
+    if (tool == "--sessions") {
+        return bearlang::runSessions(runCount, toolSource, toolInput);
+    }
+    if (tool == "--batch") {
+        return bearlang::runBatch(runCount, toolSource, toolInput, options.workRoot, options.compileCache,
+                                  options.runtimeHeader);
+    }
+    if (tool == "--compile-batch") {
+        return bearlang::runCompileBatch(toolSource, toolInput, options.workRoot, options.runtimeHeader);
+    }
+    if (tool == "--pgo") {
+        if (!toolInput.empty()) {
+            pgoInputs.insert(pgoInputs.begin(), toolInput);
+        }
+        return bearlang::runPgo(toolSource, pgoInputs, options.workRoot, options.compileCache);
+    }
 
     std::cout << "Добро пожаловать! Напишите программу на BearLang и увидьте, как она превращается в C++." << std::endl;
+    TieredRunner tiered(options.workRoot);
 
     while (true) {
         printMenu();
@@ -161,9 +659,8 @@ int main() {
         if (!std::getline(std::cin, choice)) {
             break;
         }
-
         if (choice == "1") {
-            auto examples = loadExamples(examplesDir);
+            auto examples = bearlang::loadExamples(examplesDir);
             if (examples.empty()) {
                 std::cout << "Примеры не найдены." << std::endl;
                 continue;
@@ -189,7 +686,7 @@ int main() {
                 std::cout << "Неверный номер." << std::endl;
                 continue;
             }
-            translateAndRun(examples[index - 1], buildDir);
+            translateAndRun(examples[index - 1], buildDir, options, tiered);
         } else if (choice == "2") {
             std::cout << "Введите путь до .txt файла: ";
             std::string path;
@@ -202,7 +699,7 @@ int main() {
                 std::cout << "Файл не найден." << std::endl;
                 continue;
             }
-            translateAndRun(userPath, buildDir);
+            translateAndRun(userPath, buildDir, options, tiered);
         } else if (choice == "3" || choice == "q" || choice == "Q") {
             std::cout << "До новых встреч!" << std::endl;
             break;
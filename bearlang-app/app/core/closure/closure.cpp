@@ -0,0 +1,703 @@
+#include "closure.h"
+
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/interpreter/value.h"
+#include "core/semantic/typing.h"
+
+namespace bearlang {
+
+namespace {
+
+using IntFn = std::function<int()>;
+using DoubleFn = std::function<double()>;
+using BoolFn = std::function<bool()>;
+// Strings are returned by reference: to a variable, a literal or the buffer
+// of a concatenation.
+using StringFn = std::function<const std::string&()>;
+using StmtFn = std::function<void()>;
+
+// Operand shapes the binary closures are instantiated for. A variable or a
+// literal operand is read inline instead of through another closure.
+struct IntSlot {
+    const int* slot;
+    int operator()() const { return *slot; }
+};
+
+struct IntConst {
+    int value;
+    int operator()() const { return value; }
+};
+
+struct DoubleSlot {
+    const double* slot;
+    double operator()() const { return *slot; }
+};
+
+struct DoubleConst {
+    double value;
+    double operator()() const { return value; }
+};
+
+// An int variable in a double operation, e.g. the counter in `1.0 / j`.
+struct IntSlotAsDouble {
+    const int* slot;
+    double operator()() const { return *slot; }
+};
+
+bool isIntLike(ValueType type) {
+    return type == ValueType::Integer || type == ValueType::Boolean;
+}
+
+bool isComparison(const std::string& op) {
+    return op == "==" || op == "<" || op == "<=" || op == ">" || op == ">=";
+}
+
+// Out-of-range literals wrap, as g++ narrows them to int.
+int literalInt(const LiteralExpr& literal) {
+    if (literal.type == ValueType::Boolean) {
+        return literal.boolValue ? 1 : 0;
+    }
+    return static_cast<int>(std::stoll(literal.text));
+}
+
+template <typename Result, typename Left, typename Right, typename Op>
+std::function<Result()> combine(Left left, Right right, Op op) {
+    return [left, right, op]() { return op(left(), right()); };
+}
+
+// Closure of a comparison between two operands of one C++ type.
+template <typename Left, typename Right>
+BoolFn comparison(const std::string& op, Left left, Right right) {
+    if (op == "==") {
+        return combine<bool>(left, right, [](const auto& a, const auto& b) { return a == b; });
+    }
+    if (op == "<") {
+        return combine<bool>(left, right, [](const auto& a, const auto& b) { return a < b; });
+    }
+    if (op == "<=") {
+        return combine<bool>(left, right, [](const auto& a, const auto& b) { return a <= b; });
+    }
+    if (op == ">") {
+        return combine<bool>(left, right, [](const auto& a, const auto& b) { return a > b; });
+    }
+    return combine<bool>(left, right, [](const auto& a, const auto& b) { return a >= b; });
+}
+
+// A frame variable. Integers and booleans (as 0 / 1) share the int storage.
+struct Variable {
+    ValueType type = ValueType::Unknown;
+    int* integer = nullptr;
+    double* number = nullptr;
+    std::string* text = nullptr;
+};
+
+class ClosureCompiler {
+public:
+    ClosureCompiler(std::istream& in, std::ostream& out, const ClosureOptions& options)
+        : in_(in), out_(out), options_(options) {
+        scopes_.emplace_back();
+    }
+
+    StmtFn compileProgram(const Program& program) {
+        return compileStatements(program.statements);
+    }
+
+private:
+    // Every declaration gets its own slot. std::deque keeps the addresses the
+    // closures hold stable while later declarations are added.
+    Variable declare(const std::string& name, ValueType type) {
+        Variable variable;
+        variable.type = type;
+        if (type == ValueType::Double) {
+            doubles_.push_back(0.0);
+            variable.number = &doubles_.back();
+        } else if (type == ValueType::String) {
+            strings_.emplace_back();
+            variable.text = &strings_.back();
+        } else {
+            ints_.push_back(0);
+            variable.integer = &ints_.back();
+        }
+        scopes_.back()[name] = variable;
+        return variable;
+    }
+
+    Variable lookup(const std::string& name) const {
+        for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) {
+                return found->second;
+            }
+        }
+        return Variable{};
+    }
+
+    ValueType typeOfExpr(const Expression& expr) const {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return static_cast<const LiteralExpr&>(expr).type;
+            case ExpressionKind::Variable:
+                return lookup(static_cast<const VariableExpr&>(expr).name).type;
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                return unaryResultType(unary.op, typeOfExpr(*unary.operand));
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return binaryResultType(binary.op, typeOfExpr(*binary.left),
+                                        typeOfExpr(*binary.right));
+            }
+        }
+        return ValueType::Unknown;
+    }
+
+    bool reads(const Expression& expr, const std::string& name) const {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return false;
+            case ExpressionKind::Variable:
+                return static_cast<const VariableExpr&>(expr).name == name;
+            case ExpressionKind::Unary:
+                return reads(*static_cast<const UnaryExpr&>(expr).operand, name);
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return reads(*binary.left, name) || reads(*binary.right, name);
+            }
+        }
+        return false;
+    }
+
+    // --- Statements -------------------------------------------------------
+
+    StmtFn compileStatements(const std::vector<StmtPtr>& statements) {
+        std::vector<StmtFn> compiled;
+        for (const auto& stmt : statements) {
+            compiled.push_back(compileStatement(*stmt));
+        }
+        if (compiled.size() == 1) {
+            return std::move(compiled.front());
+        }
+        return [compiled]() {
+            for (const auto& stmt : compiled) {
+                stmt();
+            }
+        };
+    }
+
+    StmtFn compileBlock(const std::vector<StmtPtr>& statements) {
+        scopes_.emplace_back();
+        StmtFn block = compileStatements(statements);
+        scopes_.pop_back();
+        return block;
+    }
+
+    StmtFn compileStatement(const Statement& statement) {
+        switch (statement.kind()) {
+            case StatementKind::VarDecl: {
+                const auto& decl = static_cast<const VarDeclStmt&>(statement);
+                // Declared before the initializer is compiled, as in the
+                // generated C++; an initializer that reads the variable sees
+                // its default value, also when the declaration runs again.
+                Variable variable = declare(decl.name, decl.type);
+                if (!decl.initializer) {
+                    return resetter(variable);
+                }
+                StmtFn store = compileStore(variable, *decl.initializer);
+                if (!reads(*decl.initializer, decl.name)) {
+                    return store;
+                }
+                StmtFn reset = resetter(variable);
+                return [reset, store]() {
+                    reset();
+                    store();
+                };
+            }
+            case StatementKind::Assign: {
+                const auto& assign = static_cast<const AssignStmt&>(statement);
+                return compileStore(lookup(assign.name), *assign.value);
+            }
+            case StatementKind::Input:
+                return compileInput(lookup(static_cast<const InputStmt&>(statement).name));
+            case StatementKind::Output:
+                return compileOutput(*static_cast<const OutputStmt&>(statement).value);
+            case StatementKind::If:
+                return compileIf(static_cast<const IfStmt&>(statement));
+            case StatementKind::While: {
+                const auto& loop = static_cast<const WhileStmt&>(statement);
+                BoolFn condition = compileBool(*loop.condition);
+                StmtFn body = compileBlock(loop.body);
+                return [condition, body]() {
+                    while (condition()) {
+                        body();
+                    }
+                };
+            }
+            case StatementKind::ForRange:
+                return compileFor(static_cast<const ForRangeStmt&>(statement));
+        }
+        return []() {};
+    }
+
+    StmtFn resetter(Variable variable) {
+        if (variable.type == ValueType::Double) {
+            double* slot = variable.number;
+            return [slot]() { *slot = 0.0; };
+        }
+        if (variable.type == ValueType::String) {
+            std::string* slot = variable.text;
+            return [slot]() { slot->clear(); };
+        }
+        int* slot = variable.integer;
+        return [slot]() { *slot = 0; };
+    }
+
+    // Evaluates expr into a variable with the implicit conversion of a C++
+    // assignment.
+    StmtFn compileStore(Variable variable, const Expression& expr) {
+        ValueType type = typeOfExpr(expr);
+        switch (variable.type) {
+            case ValueType::Double: {
+                double* slot = variable.number;
+                DoubleFn value = compileDouble(expr);
+                return [slot, value]() { *slot = value(); };
+            }
+            case ValueType::String:
+                return compileStringStore(variable.text, expr);
+            case ValueType::Boolean: {
+                int* slot = variable.integer;
+                BoolFn value = compileBool(expr);
+                return [slot, value]() { *slot = value() ? 1 : 0; };
+            }
+            case ValueType::Integer:
+            case ValueType::Unknown:
+            default: {
+                int* slot = variable.integer;
+                if (type == ValueType::Double) {
+                    DoubleFn value = compileDouble(expr);
+                    return [slot, value]() { *slot = static_cast<int>(value()); };
+                }
+                IntFn value = compileInt(expr);
+                return [slot, value]() { *slot = value(); };
+            }
+        }
+    }
+
+    // `s = s + x + ...` appends to s in place when no later piece reads s.
+    StmtFn compileStringStore(std::string* slot, const Expression& expr) {
+        std::vector<const Expression*> pieces;
+        flattenConcat(expr, pieces);
+        bool appends = pieces.size() > 1 && pieces.front()->kind() == ExpressionKind::Variable &&
+                       lookup(static_cast<const VariableExpr&>(*pieces.front()).name).text == slot;
+        for (std::size_t i = 1; i < pieces.size() && appends; ++i) {
+            appends = !readsSlot(*pieces[i], slot);
+        }
+        if (appends) {
+            std::vector<StringFn> rest;
+            for (std::size_t i = 1; i < pieces.size(); ++i) {
+                rest.push_back(compileString(*pieces[i]));
+            }
+            return [slot, rest]() {
+                for (const auto& piece : rest) {
+                    *slot += piece();
+                }
+            };
+        }
+        StringFn value = compileString(expr);
+        return [slot, value]() { *slot = value(); };
+    }
+
+    bool readsSlot(const Expression& expr, const std::string* slot) const {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return false;
+            case ExpressionKind::Variable:
+                return lookup(static_cast<const VariableExpr&>(expr).name).text == slot;
+            case ExpressionKind::Unary:
+                return readsSlot(*static_cast<const UnaryExpr&>(expr).operand, slot);
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return readsSlot(*binary.left, slot) || readsSlot(*binary.right, slot);
+            }
+        }
+        return false;
+    }
+
+    StmtFn compileInput(Variable variable) {
+        std::istream& in = in_;
+        std::ostream& out = out_;
+        switch (variable.type) {
+            case ValueType::Double: {
+                double* slot = variable.number;
+                return [&in, &out, slot]() {
+                    out.flush();
+                    in >> *slot;
+                };
+            }
+            case ValueType::String: {
+                std::string* slot = variable.text;
+                return [&in, &out, slot]() {
+                    out.flush();
+                    in >> *slot;
+                };
+            }
+            case ValueType::Boolean: {
+                int* slot = variable.integer;
+                return [&in, &out, slot]() {
+                    out.flush();
+                    bool value = *slot != 0;
+                    in >> value;
+                    *slot = value;
+                };
+            }
+            case ValueType::Integer:
+            case ValueType::Unknown:
+            default: {
+                int* slot = variable.integer;
+                return [&in, &out, slot]() {
+                    out.flush();
+                    in >> *slot;
+                };
+            }
+        }
+    }
+
+    StmtFn compileOutput(const Expression& value) {
+        // String chains are printed operand by operand, like the generated C++.
+        std::vector<const Expression*> pieces;
+        flattenConcat(value, pieces);
+        std::vector<StmtFn> printers;
+        std::ostream& out = out_;
+        for (const Expression* piece : pieces) {
+            ValueType type = typeOfExpr(*piece);
+            if (type == ValueType::String) {
+                StringFn text = compileString(*piece);
+                printers.push_back([&out, text]() { out << text(); });
+            } else if (type == ValueType::Double) {
+                DoubleFn number = compileDouble(*piece);
+                printers.push_back([&out, number]() { out << number(); });
+            } else {
+                IntFn number = compileInt(*piece);
+                printers.push_back([&out, number]() { out << number(); });
+            }
+        }
+        bool buffered = options_.bufferedOutput;
+        return [&out, printers, buffered]() {
+            for (const auto& print : printers) {
+                print();
+            }
+            if (buffered) {
+                out << '\n';
+            } else {
+                out << std::endl;
+            }
+        };
+    }
+
+    StmtFn compileIf(const IfStmt& ifStmt) {
+        std::vector<std::pair<BoolFn, StmtFn>> branches;
+        for (const auto& branch : ifStmt.branches) {
+            BoolFn condition = compileBool(*branch.condition);
+            branches.emplace_back(condition, compileBlock(branch.body));
+        }
+        StmtFn otherwise = ifStmt.hasElse ? compileBlock(ifStmt.elseBranch) : StmtFn([]() {});
+        if (branches.size() == 1) {
+            BoolFn condition = branches.front().first;
+            StmtFn then = branches.front().second;
+            return [condition, then, otherwise]() {
+                if (condition()) {
+                    then();
+                } else {
+                    otherwise();
+                }
+            };
+        }
+        return [branches, otherwise]() {
+            for (const auto& branch : branches) {
+                if (branch.first()) {
+                    branch.second();
+                    return;
+                }
+            }
+            otherwise();
+        };
+    }
+
+    StmtFn compileFor(const ForRangeStmt& loop) {
+        scopes_.emplace_back();
+        Variable counter = declare(loop.name, loop.type);
+        StmtFn start = compileStore(counter, *loop.from);
+        ValueType boundType = typeOfExpr(*loop.to);
+        StmtFn body = compileBlock(loop.body);
+        scopes_.pop_back();
+
+        // The bound is re-evaluated on every iteration, like the condition of
+        // the emitted C++ `for`.
+        if (loop.type == ValueType::Integer && isIntLike(boundType)) {
+            int* slot = counter.integer;
+            return withInt(*loop.to, [&](auto bound) -> StmtFn {
+                return [start, slot, bound, body]() {
+                    for (start(); *slot <= bound(); *slot = wrapAdd(*slot, 1)) {
+                        body();
+                    }
+                };
+            });
+        }
+
+        BoolFn condition;
+        StmtFn step;
+        if (loop.type == ValueType::Double) {
+            double* slot = counter.number;
+            DoubleFn bound = compileDouble(*loop.to);
+            condition = [slot, bound]() { return *slot <= bound(); };
+            step = [slot]() { *slot += 1.0; };
+        } else {
+            int* slot = counter.integer;
+            if (boundType == ValueType::Double) {
+                DoubleFn bound = compileDouble(*loop.to);
+                condition = [slot, bound]() { return *slot <= bound(); };
+            } else {
+                IntFn bound = compileInt(*loop.to);
+                condition = [slot, bound]() { return *slot <= bound(); };
+            }
+            if (loop.type == ValueType::Boolean) {
+                // ++ on a bool always yields true.
+                step = [slot]() { *slot = 1; };
+            } else {
+                step = [slot]() { *slot = wrapAdd(*slot, 1); };
+            }
+        }
+        return [start, condition, step, body]() {
+            for (start(); condition(); step()) {
+                body();
+            }
+        };
+    }
+
+    // --- Expressions ------------------------------------------------------
+
+    // Calls make with the operand in its cheapest shape: an int literal, an
+    // int variable or a closure.
+    template <typename Make>
+    auto withInt(const Expression& expr, Make make) -> decltype(make(IntConst{})) {
+        if (expr.kind() == ExpressionKind::Literal) {
+            return make(IntConst{literalInt(static_cast<const LiteralExpr&>(expr))});
+        }
+        if (expr.kind() == ExpressionKind::Variable) {
+            return make(IntSlot{lookup(static_cast<const VariableExpr&>(expr).name).integer});
+        }
+        return make(compileInt(expr));
+    }
+
+    // Same for double operands; int literals and variables are converted
+    // inline.
+    template <typename Make>
+    auto withDouble(const Expression& expr, Make make) -> decltype(make(DoubleConst{})) {
+        if (expr.kind() == ExpressionKind::Literal) {
+            const auto& literal = static_cast<const LiteralExpr&>(expr);
+            double value = literal.type == ValueType::Double
+                               ? std::stod(literal.text)
+                               : static_cast<double>(literalInt(literal));
+            return make(DoubleConst{value});
+        }
+        if (expr.kind() == ExpressionKind::Variable) {
+            Variable variable = lookup(static_cast<const VariableExpr&>(expr).name);
+            if (variable.type == ValueType::Double) {
+                return make(DoubleSlot{variable.number});
+            }
+            return make(IntSlotAsDouble{variable.integer});
+        }
+        return make(compileDouble(expr));
+    }
+
+    template <typename Op>
+    IntFn intBinary(const BinaryExpr& binary, Op op) {
+        return withInt(*binary.left, [&](auto left) {
+            return withInt(*binary.right, [&](auto right) { return combine<int>(left, right, op); });
+        });
+    }
+
+    template <typename Op>
+    DoubleFn doubleBinary(const BinaryExpr& binary, Op op) {
+        return withDouble(*binary.left, [&](auto left) {
+            return withDouble(*binary.right,
+                              [&](auto right) { return combine<double>(left, right, op); });
+        });
+    }
+
+    // An expression of type Integer or Boolean, as an int.
+    IntFn compileInt(const Expression& expr) {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal: {
+                int value = literalInt(static_cast<const LiteralExpr&>(expr));
+                return [value]() { return value; };
+            }
+            case ExpressionKind::Variable: {
+                const int* slot = lookup(static_cast<const VariableExpr&>(expr).name).integer;
+                return [slot]() { return *slot; };
+            }
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                if (unary.op == "!") {
+                    break;
+                }
+                return withInt(*unary.operand, [](auto operand) -> IntFn {
+                    return [operand]() { return wrapNeg(operand()); };
+                });
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                const std::string& op = binary.op;
+                if (op == "+") return intBinary(binary, [](int a, int b) { return wrapAdd(a, b); });
+                if (op == "-") return intBinary(binary, [](int a, int b) { return wrapSub(a, b); });
+                if (op == "*") return intBinary(binary, [](int a, int b) { return wrapMul(a, b); });
+                if (op == "/") return intBinary(binary, [](int a, int b) { return divideInts(a, b); });
+                if (op == "%") return intBinary(binary, [](int a, int b) { return moduloInts(a, b); });
+                break;
+            }
+        }
+        // Conditions, comparisons and logic yield 0 or 1.
+        BoolFn value = compileBool(expr);
+        return [value]() { return value() ? 1 : 0; };
+    }
+
+    // Any numeric expression, as a double.
+    DoubleFn compileDouble(const Expression& expr) {
+        ValueType type = typeOfExpr(expr);
+        if (isIntLike(type)) {
+            IntFn value = compileInt(expr);
+            return [value]() { return static_cast<double>(value()); };
+        }
+        switch (expr.kind()) {
+            case ExpressionKind::Literal: {
+                double value = std::stod(static_cast<const LiteralExpr&>(expr).text);
+                return [value]() { return value; };
+            }
+            case ExpressionKind::Variable: {
+                const double* slot = lookup(static_cast<const VariableExpr&>(expr).name).number;
+                return [slot]() { return *slot; };
+            }
+            case ExpressionKind::Unary: {
+                DoubleFn operand = compileDouble(*static_cast<const UnaryExpr&>(expr).operand);
+                return [operand]() { return -operand(); };
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                const std::string& op = binary.op;
+                if (op == "+") return doubleBinary(binary, [](double a, double b) { return a + b; });
+                if (op == "-") return doubleBinary(binary, [](double a, double b) { return a - b; });
+                if (op == "*") return doubleBinary(binary, [](double a, double b) { return a * b; });
+                if (op == "/") return doubleBinary(binary, [](double a, double b) { return a / b; });
+                return doubleBinary(binary, [](double a, double b) { return std::pow(a, b); });
+            }
+        }
+        return []() { return 0.0; };
+    }
+
+    // The truth value of any numeric expression.
+    BoolFn compileBool(const Expression& expr) {
+        if (expr.kind() == ExpressionKind::Binary) {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            const std::string& op = binary.op;
+            if (op == "&&" || op == "||") {
+                BoolFn left = compileBool(*binary.left);
+                BoolFn right = compileBool(*binary.right);
+                if (op == "&&") {
+                    return [left, right]() { return left() && right(); };
+                }
+                return [left, right]() { return left() || right(); };
+            }
+            if (isComparison(op)) {
+                ValueType left = typeOfExpr(*binary.left);
+                ValueType right = typeOfExpr(*binary.right);
+                if (left == ValueType::String) {
+                    return comparison(op, compileString(*binary.left), compileString(*binary.right));
+                }
+                if (left == ValueType::Double || right == ValueType::Double) {
+                    return withDouble(*binary.left, [&](auto a) {
+                        return withDouble(*binary.right, [&](auto b) { return comparison(op, a, b); });
+                    });
+                }
+                return withInt(*binary.left, [&](auto a) {
+                    return withInt(*binary.right, [&](auto b) { return comparison(op, a, b); });
+                });
+            }
+        }
+        if (expr.kind() == ExpressionKind::Unary && static_cast<const UnaryExpr&>(expr).op == "!") {
+            BoolFn operand = compileBool(*static_cast<const UnaryExpr&>(expr).operand);
+            return [operand]() { return !operand(); };
+        }
+        if (typeOfExpr(expr) == ValueType::Double) {
+            DoubleFn value = compileDouble(expr);
+            return [value]() { return value() != 0.0; };
+        }
+        return withInt(expr, [](auto value) -> BoolFn { return [value]() { return value() != 0; }; });
+    }
+
+    void flattenConcat(const Expression& expr, std::vector<const Expression*>& pieces) const {
+        if (expr.kind() == ExpressionKind::Binary && static_cast<const BinaryExpr&>(expr).op == "+" &&
+            typeOfExpr(expr) == ValueType::String) {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            flattenConcat(*binary.left, pieces);
+            flattenConcat(*binary.right, pieces);
+            return;
+        }
+        pieces.push_back(&expr);
+    }
+
+    StringFn compileString(const Expression& expr) {
+        if (expr.kind() == ExpressionKind::Literal) {
+            std::string text = static_cast<const LiteralExpr&>(expr).text;
+            return [text]() -> const std::string& { return text; };
+        }
+        if (expr.kind() == ExpressionKind::Variable) {
+            const std::string* slot = lookup(static_cast<const VariableExpr&>(expr).name).text;
+            return [slot]() -> const std::string& { return *slot; };
+        }
+        // `a + b + c`: one buffer per concatenation, reused between runs.
+        std::vector<const Expression*> pieces;
+        flattenConcat(expr, pieces);
+        std::vector<StringFn> parts;
+        for (const Expression* piece : pieces) {
+            parts.push_back(compileString(*piece));
+        }
+        std::string buffer;
+        return [parts, buffer]() mutable -> const std::string& {
+            buffer.clear();
+            for (const auto& part : parts) {
+                buffer += part();
+            }
+            return buffer;
+        };
+    }
+
+    std::istream& in_;
+    std::ostream& out_;
+    const ClosureOptions& options_;
+    std::vector<std::unordered_map<std::string, Variable>> scopes_;
+    std::deque<int> ints_;
+    std::deque<double> doubles_;
+    std::deque<std::string> strings_;
+};
+
+}  // namespace
+
+void ClosureEngine::run(const Program& program,
+                        std::istream& in,
+                        std::ostream& out,
+                        const ClosureOptions& options) {
+    ClosureCompiler compiler(in, out, options);
+    StmtFn main = compiler.compileProgram(program);
+    main();
+    out.flush();
+}
+
+}  // namespace bearlang
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <iosfwd>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+struct ClosureOptions {
+    // Same meaning as InterpreterOptions::bufferedOutput.
+    bool bufferedOutput = true;
+};
+
+// Compiles every expression and statement once into a callable specialised
+// for its static types and runs the result. `целое + целое` becomes a closure
+// that adds two ints, a variable becomes a pointer into the frame, and
+// conversions are fixed at compile time, so running the program never looks
+// at a type. Results, input handling and RuntimeError conditions are the same
+// as in Interpreter; the program must likewise have passed checkProgram.
+class ClosureEngine {
+public:
+    static void run(const Program& program,
+                    std::istream& in,
+                    std::ostream& out,
+                    const ClosureOptions& options = {});
+};
+
+}  // namespace bearlang
@@ -0,0 +1,129 @@
+#include "build_profile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace bearlang {
+
+namespace {
+
+// Statements at which an unoptimised binary runs for about as long as -O2
+// and static linking add to g++ (≈0.1 s): from there on -O2 pays off.
+constexpr double kFastOperations = 1e7;
+
+// The value of an integer literal, or of `-` applied to one.
+bool integerLiteral(const Expression* expr, double& value) {
+    if (expr == nullptr) {
+        return false;
+    }
+    if (expr->kind() == ExpressionKind::Unary) {
+        const auto& unary = static_cast<const UnaryExpr&>(*expr);
+        if (unary.op != "-" || !integerLiteral(unary.operand.get(), value)) {
+            return false;
+        }
+        value = -value;
+        return true;
+    }
+    if (expr->kind() != ExpressionKind::Literal) {
+        return false;
+    }
+    const auto& literal = static_cast<const LiteralExpr&>(*expr);
+    if (literal.type != ValueType::Integer) {
+        return false;
+    }
+    value = std::strtod(literal.text.c_str(), nullptr);
+    return true;
+}
+
+// `i < N`, `N > i` and the like: a counter from zero is the common case.
+double whileTrips(const WhileStmt& loop) {
+    const Expression* condition = loop.condition.get();
+    if (condition == nullptr || condition->kind() != ExpressionKind::Binary) {
+        return kUnknownTrips;
+    }
+    const auto& binary = static_cast<const BinaryExpr&>(*condition);
+    if (binary.op != "<" && binary.op != "<=" && binary.op != ">" && binary.op != ">=") {
+        return kUnknownTrips;
+    }
+    double bound = 0.0;
+    if (integerLiteral(binary.right.get(), bound) || integerLiteral(binary.left.get(), bound)) {
+        return std::max(1.0, std::fabs(bound));
+    }
+    return kUnknownTrips;
+}
+
+double forTrips(const ForRangeStmt& loop) {
+    double from = 0.0;
+    double to = 0.0;
+    if (integerLiteral(loop.from.get(), from) && integerLiteral(loop.to.get(), to)) {
+        // Both bounds are inclusive.
+        return std::max(0.0, to - from + 1.0);
+    }
+    return kUnknownTrips;
+}
+
+// Adds the statements of `statements`, run `times` times at nesting `depth`.
+void estimateStatements(const std::vector<StmtPtr>& statements,
+                        double times,
+                        std::size_t depth,
+                        WorkEstimate& estimate) {
+    for (const auto& stmt : statements) {
+        estimate.operations += times;
+        switch (stmt->kind()) {
+            case StatementKind::If: {
+                // Every branch counted in full: an upper bound.
+                const auto& ifStmt = static_cast<const IfStmt&>(*stmt);
+                for (const auto& branch : ifStmt.branches) {
+                    estimateStatements(branch.body, times, depth, estimate);
+                }
+                estimateStatements(ifStmt.elseBranch, times, depth, estimate);
+                break;
+            }
+            case StatementKind::While: {
+                const auto& loop = static_cast<const WhileStmt&>(*stmt);
+                estimate.loopDepth = std::max(estimate.loopDepth, depth + 1);
+                estimateStatements(loop.body, times * whileTrips(loop), depth + 1, estimate);
+                break;
+            }
+            case StatementKind::ForRange: {
+                const auto& loop = static_cast<const ForRangeStmt&>(*stmt);
+                estimate.loopDepth = std::max(estimate.loopDepth, depth + 1);
+                estimateStatements(loop.body, times * forTrips(loop), depth + 1, estimate);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+}  // namespace
+
+WorkEstimate estimateWork(const Program& program) {
+    WorkEstimate estimate;
+    estimateStatements(program.statements, 1.0, 0, estimate);
+    return estimate;
+}
+
+BuildProfile chooseBuildProfile(const WorkEstimate& estimate) {
+    return estimate.operations >= kFastOperations ? BuildProfile::Fast : BuildProfile::Instant;
+}
+
+const char* buildProfileName(BuildProfile profile) {
+    return profile == BuildProfile::Fast ? "fast" : "instant";
+}
+
+bool parseBuildProfile(const std::string& name, BuildProfile& profile) {
+    if (name == "instant") {
+        profile = BuildProfile::Instant;
+        return true;
+    }
+    if (name == "fast") {
+        profile = BuildProfile::Fast;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace bearlang
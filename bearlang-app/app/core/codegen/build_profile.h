@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// How g++ builds a program; app.cpp maps each profile to its flags.
+enum class BuildProfile {
+    // Shortest compile: no optimisation, the precompiled minimal runtime.
+    // For the programs that finish in moments anyway.
+    Instant,
+    // Fastest run: -O2 for this CPU, linked statically. Costs a few hundred
+    // milliseconds more of g++, which long loops win back.
+    Fast,
+};
+
+// A guess at a program's work from its text alone.
+struct WorkEstimate {
+    // Deepest nesting of `пока` / `для` loops.
+    std::size_t loopDepth = 0;
+    // Statements executed, each loop body counted as many times as the loop
+    // is expected to turn: the range of a `для` with literal bounds, the
+    // literal of a `пока` that compares against one (`пока (i < 3000000)`),
+    // and kUnknownTrips for any other loop.
+    double operations = 0.0;
+};
+
+// Turns assumed for a loop whose bounds are not literals.
+constexpr double kUnknownTrips = 100.0;
+
+WorkEstimate estimateWork(const Program& program);
+
+// Fast once the estimate is large enough for the shorter run to repay the
+// longer compile.
+BuildProfile chooseBuildProfile(const WorkEstimate& estimate);
+
+// "instant" or "fast".
+const char* buildProfileName(BuildProfile profile);
+
+// The reverse of buildProfileName; false for any other name.
+bool parseBuildProfile(const std::string& name, BuildProfile& profile);
+
+}  // namespace bearlang
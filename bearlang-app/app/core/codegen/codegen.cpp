@@ -1,10 +1,15 @@
 #include "codegen.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "core/semantic/typing.h"
+#include "cse.h"
+#include "runtime.h"
+
 namespace bearlang {
 
 namespace {
@@ -25,36 +30,74 @@ public:
         }
     }
 
-    std::string declare(const std::string& original) {
+    std::string declare(const std::string& original, ValueType type) {
         std::string renamed = "vr_" + std::to_string(++counter_);
-        scopes_.back()[original] = renamed;
+        scopes_.back()[original] = Binding{renamed, type};
         return renamed;
     }
 
     std::string resolve(const std::string& original) const {
+        const Binding* binding = find(original);
+        return binding ? binding->name : original;
+    }
+
+    ValueType resolveType(const std::string& original) const {
+        const Binding* binding = find(original);
+        return binding ? binding->type : ValueType::Unknown;
+    }
+
+    std::string temporary() {
+        return "tmp_" + std::to_string(++temporaryCounter_);
+    }
+
+private:
+    struct Binding {
+        std::string name;
+        ValueType type;
+    };
+
+    const Binding* find(const std::string& original) const {
         for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
             auto found = it->find(original);
             if (found != it->end()) {
-                return found->second;
+                return &found->second;
             }
         }
-        return original;
+        return nullptr;
     }
 
-private:
     std::size_t counter_ = 0;
-    std::vector<std::unordered_map<std::string, std::string>> scopes_;
+    std::size_t temporaryCounter_ = 0;
+    std::vector<std::unordered_map<std::string, Binding>> scopes_;
+};
+
+// Names of the common-subexpression temporaries of the block being emitted.
+struct BlockTemps {
+    const CsePlan* plan = nullptr;
+    std::vector<std::string> names;
+
+    // Temporary already holding the value of expr, or nullptr.
+    const std::string* nameFor(const Expression* expr) const {
+        if (!plan) {
+            return nullptr;
+        }
+        auto use = plan->uses.find(expr);
+        if (use == plan->uses.end() || names[use->second].empty()) {
+            return nullptr;
+        }
+        return &names[use->second];
+    }
 };
 
 std::string indent(std::size_t level) {
     return std::string(level * 4, ' ');
 }
 
-std::string cppType(ValueType type) {
+std::string cppType(ValueType type, const CodegenOptions& options) {
     switch (type) {
         case ValueType::Integer: return "int";
         case ValueType::Double: return "double";
-        case ValueType::String: return "std::string";
+        case ValueType::String: return options.minimalRuntime ? "bl_string" : "std::string";
         case ValueType::Boolean: return "bool";
         case ValueType::Unknown: default: return "auto";
     }
@@ -75,24 +118,234 @@ std::string escapeString(const std::string& value) {
     return escaped;
 }
 
-std::string emitExpression(const ExprPtr& expr, const NameMangler& mangler);
+// Statement that bumps the counter of a line, or "" when not counting.
+std::string lineCounter(std::size_t line, const CodegenOptions& options) {
+    if (options.lineCountsPath.empty() || line == 0) {
+        return {};
+    }
+    return "++bl_line_counts[" + std::to_string(line) + "]";
+}
+
+// A loop or `иначе если` condition that also counts its line.
+std::string countedCondition(const std::string& condition,
+                             std::size_t line,
+                             const CodegenOptions& options) {
+    std::string counter = lineCounter(line, options);
+    return counter.empty() ? condition : "(" + counter + ", " + condition + ")";
+}
+
+std::string emitExpression(const Expression* expr,
+                           const NameMangler& mangler,
+                           const BlockTemps& temps,
+                           const CodegenOptions& options);
 void emitStatements(const std::vector<StmtPtr>& statements,
                     std::size_t indentLevel,
                     std::ostringstream& out,
                     NameMangler& mangler,
+                    const CodegenOptions& options,
                     bool createNewScope);
 
+ValueType expressionType(const Expression* expr, const NameMangler& mangler) {
+    if (!expr) {
+        return ValueType::Unknown;
+    }
+    switch (expr->kind()) {
+        case ExpressionKind::Literal:
+            return static_cast<const LiteralExpr&>(*expr).type;
+        case ExpressionKind::Variable:
+            return mangler.resolveType(static_cast<const VariableExpr&>(*expr).name);
+        case ExpressionKind::Unary: {
+            const auto& unary = static_cast<const UnaryExpr&>(*expr);
+            return unaryResultType(unary.op, expressionType(unary.operand.get(), mangler));
+        }
+        case ExpressionKind::Binary: {
+            const auto& binary = static_cast<const BinaryExpr&>(*expr);
+            return binaryResultType(binary.op,
+                                    expressionType(binary.left.get(), mangler),
+                                    expressionType(binary.right.get(), mangler));
+        }
+    }
+    return ValueType::Unknown;
+}
+
+bool isStringLiteral(const Expression* expr) {
+    return expr && expr->kind() == ExpressionKind::Literal &&
+           static_cast<const LiteralExpr&>(*expr).type == ValueType::String;
+}
+
+bool isConcatenation(const Expression* expr, const NameMangler& mangler, const BlockTemps& temps) {
+    return expr && expr->kind() == ExpressionKind::Binary &&
+           static_cast<const BinaryExpr&>(*expr).op == "+" && !temps.nameFor(expr) &&
+           expressionType(expr, mangler) == ValueType::String;
+}
+
+void flattenConcatenation(const Expression* expr,
+                          const NameMangler& mangler,
+                          const BlockTemps& temps,
+                          std::vector<const Expression*>& operands) {
+    if (!isConcatenation(expr, mangler, temps)) {
+        operands.push_back(expr);
+        return;
+    }
+    const auto& binary = static_cast<const BinaryExpr&>(*expr);
+    flattenConcatenation(binary.left.get(), mangler, temps, operands);
+    flattenConcatenation(binary.right.get(), mangler, temps, operands);
+}
+
+// Operands of a `+` chain on strings, left to right; empty for anything else.
+std::vector<const Expression*> concatOperands(const Expression* expr,
+                                              const NameMangler& mangler,
+                                              const BlockTemps& temps) {
+    std::vector<const Expression*> operands;
+    if (isConcatenation(expr, mangler, temps)) {
+        flattenConcatenation(expr, mangler, temps, operands);
+    }
+    return operands;
+}
+
+bool refersTo(const Expression* expr, const std::string& cppName, const NameMangler& mangler) {
+    return expr->kind() == ExpressionKind::Variable &&
+           mangler.resolve(static_cast<const VariableExpr&>(*expr).name) == cppName;
+}
+
+// Builds a string chain in one pre-sized buffer instead of nesting operator+,
+// which allocates a temporary std::string per `+`. Appends in place when the
+// chain starts with the target itself (`s = s + ...`). Returns false when an
+// operand is not a plain name or literal and so cannot be measured up front.
+bool emitConcatAssignment(const std::string& target,
+                          bool declaration,
+                          const std::vector<const Expression*>& operands,
+                          std::size_t indentLevel,
+                          std::ostringstream& out,
+                          NameMangler& mangler,
+                          const BlockTemps& temps,
+                          const CodegenOptions& options) {
+    std::size_t literalBytes = 0;
+    std::vector<std::string> measured;
+    std::size_t selfReferences = 0;
+    for (const Expression* operand : operands) {
+        if (const std::string* temp = temps.nameFor(operand)) {
+            measured.push_back(*temp + ".size()");
+        } else if (operand->kind() == ExpressionKind::Literal) {
+            literalBytes += static_cast<const LiteralExpr&>(*operand).text.size();
+        } else if (operand->kind() == ExpressionKind::Variable) {
+            measured.push_back(emitExpression(operand, mangler, temps, options) + ".size()");
+            if (refersTo(operand, target, mangler)) {
+                ++selfReferences;
+            }
+        } else {
+            return false;
+        }
+    }
+    if (declaration && selfReferences > 0) {
+        return false;
+    }
+
+    auto appendAll = [&](const std::string& buffer, std::size_t first) {
+        out << indent(indentLevel) << buffer;
+        for (std::size_t i = first; i < operands.size(); ++i) {
+            out << ".append(" << emitExpression(operands[i], mangler, temps, options) << ")";
+        }
+        out << ";\n";
+    };
+
+    if (!declaration && selfReferences == 1 && !temps.nameFor(operands.front()) &&
+        refersTo(operands.front(), target, mangler)) {
+        appendAll(target, 1);
+        return true;
+    }
+
+    std::string buffer = target;
+    if (declaration) {
+        out << indent(indentLevel) << cppType(ValueType::String, options) << " " << target << ";\n";
+    } else if (selfReferences == 0) {
+        out << indent(indentLevel) << target << ".clear();\n";
+    } else {
+        buffer = mangler.temporary();
+        out << indent(indentLevel) << cppType(ValueType::String, options) << " " << buffer << ";\n";
+    }
+    if (literalBytes > 0 || measured.empty()) {
+        measured.insert(measured.begin(), std::to_string(literalBytes));
+    }
+    out << indent(indentLevel) << buffer << ".reserve(";
+    for (std::size_t i = 0; i < measured.size(); ++i) {
+        out << (i == 0 ? "" : " + ") << measured[i];
+    }
+    out << ");\n";
+    appendAll(buffer, 0);
+    if (buffer != target) {
+        // bl_string has no <utility> for std::move.
+        out << indent(indentLevel) << target << " = "
+            << (options.minimalRuntime ? "static_cast<bl_string&&>(" : "std::move(") << buffer
+            << ");\n";
+    }
+    return true;
+}
+
+// Writes one or more consecutive `вывод` statements as a single stream
+// expression, one continuation line per statement, or as bl_write calls with
+// the minimal runtime.
+void emitOutputs(const std::vector<const OutputStmt*>& outputs,
+                 std::size_t indentLevel,
+                 std::ostringstream& out,
+                 const NameMangler& mangler,
+                 const BlockTemps& temps,
+                 const CodegenOptions& options) {
+    if (options.minimalRuntime) {
+        for (const OutputStmt* output : outputs) {
+            auto operands = concatOperands(output->value.get(), mangler, temps);
+            if (operands.empty()) {
+                operands.push_back(output->value.get());
+            }
+            for (const Expression* operand : operands) {
+                out << indent(indentLevel) << "bl_write("
+                    << emitExpression(operand, mangler, temps, options) << ");\n";
+            }
+            out << indent(indentLevel)
+                << (options.bufferedOutput ? "bl_line();\n" : "bl_endl();\n");
+        }
+        return;
+    }
+    const char* lineEnd = options.bufferedOutput ? "'\\n'" : "std::endl";
+    out << indent(indentLevel) << "std::cout";
+    for (std::size_t i = 0; i < outputs.size(); ++i) {
+        if (i > 0) {
+            out << "\n" << indent(indentLevel) << "         ";
+        }
+        // A string chain is streamed piece by piece instead of being
+        // concatenated into a temporary first.
+        auto operands = concatOperands(outputs[i]->value.get(), mangler, temps);
+        if (operands.empty()) {
+            operands.push_back(outputs[i]->value.get());
+        }
+        for (const Expression* operand : operands) {
+            out << " << " << emitExpression(operand, mangler, temps, options);
+        }
+        out << " << " << lineEnd;
+    }
+    out << ";\n";
+}
+
 void emitStatement(const Statement& statement,
                    std::size_t indentLevel,
                    std::ostringstream& out,
-                   NameMangler& mangler) {
+                   NameMangler& mangler,
+                   const CodegenOptions& options,
+                   const BlockTemps& temps) {
     switch (statement.kind()) {
         case StatementKind::VarDecl: {
             const auto& decl = static_cast<const VarDeclStmt&>(statement);
-            const std::string cppName = mangler.declare(decl.name);
-            out << indent(indentLevel) << cppType(decl.type) << " " << cppName;
+            const std::string cppName = mangler.declare(decl.name, decl.type);
+            if (decl.type == ValueType::String) {
+                const auto operands = concatOperands(decl.initializer.get(), mangler, temps);
+                if (!operands.empty() && emitConcatAssignment(cppName, true, operands, indentLevel,
+                                                              out, mangler, temps, options)) {
+                    break;
+                }
+            }
+            out << indent(indentLevel) << cppType(decl.type, options) << " " << cppName;
             if (decl.initializer) {
-                out << " = " << emitExpression(decl.initializer, mangler);
+                out << " = " << emitExpression(decl.initializer.get(), mangler, temps, options);
             } else {
                 out << "{}";
             }
@@ -101,53 +354,79 @@ void emitStatement(const Statement& statement,
         }
         case StatementKind::Assign: {
             const auto& assign = static_cast<const AssignStmt&>(statement);
-            out << indent(indentLevel) << mangler.resolve(assign.name) << " = "
-                << emitExpression(assign.value, mangler) << ";\n";
+            const std::string target = mangler.resolve(assign.name);
+            if (mangler.resolveType(assign.name) == ValueType::String) {
+                const auto operands = concatOperands(assign.value.get(), mangler, temps);
+                if (!operands.empty() && emitConcatAssignment(target, false, operands, indentLevel,
+                                                              out, mangler, temps, options)) {
+                    break;
+                }
+            }
+            out << indent(indentLevel) << target << " = "
+                << emitExpression(assign.value.get(), mangler, temps, options) << ";\n";
             break;
         }
         case StatementKind::Input: {
             const auto& input = static_cast<const InputStmt&>(statement);
-            out << indent(indentLevel) << "std::cin >> " << mangler.resolve(input.name) << ";\n";
+            if (options.minimalRuntime) {
+                out << indent(indentLevel) << "bl_read(" << mangler.resolve(input.name) << ");\n";
+            } else {
+                out << indent(indentLevel) << "std::cin >> " << mangler.resolve(input.name)
+                    << ";\n";
+            }
             break;
         }
         case StatementKind::Output: {
             const auto& outputStmt = static_cast<const OutputStmt&>(statement);
-            out << indent(indentLevel) << "std::cout << "
-                << emitExpression(outputStmt.value, mangler) << " << std::endl;\n";
+            emitOutputs({&outputStmt}, indentLevel, out, mangler, temps, options);
             break;
         }
         case StatementKind::If: {
             const auto& ifStmt = static_cast<const IfStmt&>(statement);
             for (std::size_t i = 0; i < ifStmt.branches.size(); ++i) {
                 const auto& branch = ifStmt.branches[i];
-                out << indent(indentLevel) << (i == 0 ? "if" : "else if") << " ("
-                    << emitExpression(branch.condition, mangler) << ") {\n";
-                emitStatements(branch.body, indentLevel + 1, out, mangler, true);
+                std::string condition =
+                    emitExpression(branch.condition.get(), mangler, temps, options);
+                if (i > 0) {
+                    condition = countedCondition(condition, branch.line, options);
+                }
+                out << indent(indentLevel) << (i == 0 ? "if" : "else if") << " (" << condition
+                    << ") {\n";
+                emitStatements(branch.body, indentLevel + 1, out, mangler, options, true);
                 out << indent(indentLevel) << "}\n";
             }
             if (ifStmt.hasElse) {
                 out << indent(indentLevel) << "else {\n";
-                emitStatements(ifStmt.elseBranch, indentLevel + 1, out, mangler, true);
+                emitStatements(ifStmt.elseBranch, indentLevel + 1, out, mangler, options, true);
                 out << indent(indentLevel) << "}\n";
             }
             break;
         }
         case StatementKind::While: {
             const auto& loop = static_cast<const WhileStmt&>(statement);
-            out << indent(indentLevel) << "while (" << emitExpression(loop.condition, mangler)
+            // Loop headers are re-evaluated every iteration, so they never
+            // reuse temporaries computed before the loop.
+            out << indent(indentLevel) << "while ("
+                << countedCondition(
+                       emitExpression(loop.condition.get(), mangler, BlockTemps{}, options),
+                       loop.line, options)
                 << ") {\n";
-            emitStatements(loop.body, indentLevel + 1, out, mangler, true);
+            emitStatements(loop.body, indentLevel + 1, out, mangler, options, true);
             out << indent(indentLevel) << "}\n";
             break;
         }
         case StatementKind::ForRange: {
             const auto& loop = static_cast<const ForRangeStmt&>(statement);
             mangler.pushScope();
-            const std::string loopName = mangler.declare(loop.name);
-            out << indent(indentLevel) << "for (" << cppType(loop.type) << " " << loopName << " = "
-                << emitExpression(loop.from, mangler) << "; " << loopName << " <= "
-                << emitExpression(loop.to, mangler) << "; ++" << loopName << ") {\n";
-            emitStatements(loop.body, indentLevel + 1, out, mangler, true);
+            const std::string loopName = mangler.declare(loop.name, loop.type);
+            out << indent(indentLevel) << "for (" << cppType(loop.type, options) << " " << loopName << " = "
+                << emitExpression(loop.from.get(), mangler, BlockTemps{}, options) << "; "
+                << countedCondition(
+                       loopName + " <= " +
+                           emitExpression(loop.to.get(), mangler, BlockTemps{}, options),
+                       loop.line, options)
+                << "; ++" << loopName << ") {\n";
+            emitStatements(loop.body, indentLevel + 1, out, mangler, options, true);
             out << indent(indentLevel) << "}\n";
             mangler.popScope();
             break;
@@ -155,10 +434,16 @@ void emitStatement(const Statement& statement,
     }
 }
 
-std::string emitExpression(const ExprPtr& expr, const NameMangler& mangler) {
+std::string emitExpression(const Expression* expr,
+                           const NameMangler& mangler,
+                           const BlockTemps& temps,
+                           const CodegenOptions& options) {
     if (!expr) {
         return "0";
     }
+    if (const std::string* temp = temps.nameFor(expr)) {
+        return *temp;
+    }
     switch (expr->kind()) {
         case ExpressionKind::Literal: {
             const auto& literal = static_cast<const LiteralExpr&>(*expr);
@@ -181,16 +466,30 @@ std::string emitExpression(const ExprPtr& expr, const NameMangler& mangler) {
         }
         case ExpressionKind::Unary: {
             const auto& unary = static_cast<const UnaryExpr&>(*expr);
-            return unary.op + "(" + emitExpression(unary.operand, mangler) + ")";
+            return unary.op + "(" + emitExpression(unary.operand.get(), mangler, temps, options) +
+                   ")";
         }
         case ExpressionKind::Binary: {
             const auto& binary = static_cast<const BinaryExpr&>(*expr);
             if (binary.op == "^") {
-                return std::string("std::pow(") + emitExpression(binary.left, mangler) + ", " +
-                       emitExpression(binary.right, mangler) + ")";
+                std::string function = "std::pow";
+                if (options.minimalRuntime) {
+                    bool integers =
+                        expressionType(binary.left.get(), mangler) == ValueType::Integer &&
+                        expressionType(binary.right.get(), mangler) == ValueType::Integer;
+                    function = integers ? "bl_ipow" : "bl_pow";
+                }
+                return function + "(" + emitExpression(binary.left.get(), mangler, temps, options) +
+                       ", " + emitExpression(binary.right.get(), mangler, temps, options) + ")";
             }
-            return std::string("(") + emitExpression(binary.left, mangler) + " " + binary.op + " " +
-                   emitExpression(binary.right, mangler) + ")";
+            std::string left = emitExpression(binary.left.get(), mangler, temps, options);
+            if (isStringLiteral(binary.left.get()) && isStringLiteral(binary.right.get())) {
+                // Two literals are both `const char*` in C++: `+` would not
+                // compile and comparisons would compare addresses.
+                left = cppType(ValueType::String, options) + "(" + left + ")";
+            }
+            return std::string("(") + left + " " + binary.op + " " +
+                   emitExpression(binary.right.get(), mangler, temps, options) + ")";
         }
     }
     return {};
@@ -200,34 +499,177 @@ void emitStatements(const std::vector<StmtPtr>& statements,
                     std::size_t indentLevel,
                     std::ostringstream& out,
                     NameMangler& mangler,
+                    const CodegenOptions& options,
                     bool createNewScope) {
     if (createNewScope) {
         mangler.pushScope();
     }
-    for (const auto& stmt : statements) {
-        emitStatement(*stmt, indentLevel, out, mangler);
+    const CsePlan plan = planCommonSubexpressions(
+        statements, [&mangler](const std::string& name) { return mangler.resolve(name); });
+    BlockTemps temps{&plan, std::vector<std::string>(plan.slotCount)};
+    for (std::size_t i = 0; i < statements.size(); ++i) {
+        for (const auto& hoist : plan.before[i]) {
+            // Emitted before the name is recorded, so the definition itself
+            // expands in full while its own subexpressions reuse earlier temps.
+            const std::string value = emitExpression(hoist.expr, mangler, temps, options);
+            temps.names[hoist.slot] = mangler.temporary();
+            out << indent(indentLevel) << "const auto " << temps.names[hoist.slot] << " = " << value
+                << ";\n";
+        }
+        // Loops count their line in the condition instead.
+        StatementKind kind = statements[i]->kind();
+        std::string counter = kind == StatementKind::While || kind == StatementKind::ForRange
+                                  ? std::string()
+                                  : lineCounter(statements[i]->line, options);
+        if (!counter.empty()) {
+            out << indent(indentLevel) << counter << ";\n";
+        }
+        if (options.bufferedOutput && statements[i]->kind() == StatementKind::Output) {
+            // Consecutive outputs become one write, unless a temporary has to
+            // be computed between them.
+            std::vector<const OutputStmt*> outputs{
+                static_cast<const OutputStmt*>(statements[i].get())};
+            while (i + 1 < statements.size() &&
+                   statements[i + 1]->kind() == StatementKind::Output &&
+                   plan.before[i + 1].empty()) {
+                outputs.push_back(static_cast<const OutputStmt*>(statements[++i].get()));
+                counter = lineCounter(statements[i]->line, options);
+                if (!counter.empty()) {
+                    out << indent(indentLevel) << counter << ";\n";
+                }
+            }
+            emitOutputs(outputs, indentLevel, out, mangler, temps, options);
+            continue;
+        }
+        emitStatement(*statements[i], indentLevel, out, mangler, options, temps);
     }
     if (createNewScope) {
         mangler.popScope();
     }
 }
 
+// Includes, and the runtime of the minimal version, for programs that use
+// `features` (runtimeFeatures of everything in the file).
+void emitPrologue(RuntimeFeatures features, bool countLines, const CodegenOptions& options,
+                  std::ostringstream& out) {
+    if (options.minimalRuntime && !options.runtimeHeaderPath.empty()) {
+        // First, or g++ ignores the header's .gch.
+        out << "#include \"" << escapeString(options.runtimeHeaderPath) << "\"\n\n";
+    } else if (options.minimalRuntime) {
+        features.flushedLines = !options.bufferedOutput;
+        if (countLines && !features.input && !features.strings) {
+            out << "#include <cstdlib>\n";
+        }
+        out << runtimeSource(features);
+    } else {
+        out << "#include <cmath>\n";
+        if (countLines) {
+            out << "#include <cstdio>\n";
+            out << "#include <cstdlib>\n";
+        }
+        out << "#include <iostream>\n";
+        out << "#include <string>\n\n";
+    }
+}
+
+void emitStreamSetup(const CodegenOptions& options, std::ostringstream& out) {
+    if (!options.minimalRuntime) {
+        out << indent(1) << "std::ios_base::sync_with_stdio(false);\n";
+    } else if (options.bufferedOutput) {
+        // The block size std::cout buffers in once unsynced from stdio.
+        out << indent(1) << "std::setvbuf(stdout, nullptr, _IOFBF, BUFSIZ);\n";
+    }
+}
+
 }  // namespace
 
-std::string CodeGenerator::generate(const Program& program) {
+std::string CodeGenerator::generate(const Program& program, const CodegenOptions& options) {
     std::ostringstream out;
     NameMangler mangler;
-    out << "#include <cmath>\n";
-    out << "#include <iostream>\n";
-    out << "#include <string>\n\n";
-    out << "int main() {\n";
-    out << indent(1) << "std::ios_base::sync_with_stdio(false);\n";
+    bool countLines = !options.lineCountsPath.empty();
+    emitPrologue(runtimeFeatures(program), countLines, options, out);
+    if (countLines) {
+        std::size_t lines = 0;
+        for (const auto& stmt : program.statements) {
+            lines = std::max(lines, lastLine(*stmt));
+        }
+        // Plain increments: the program is single-threaded.
+        out << "static unsigned long long bl_line_counts[" << lines + 1 << "];\n\n";
+        out << "static void bl_write_line_counts() {\n";
+        out << indent(1) << "std::FILE* file = std::fopen(\""
+            << escapeString(options.lineCountsPath) << "\", \"w\");\n";
+        out << indent(1) << "if (!file) {\n";
+        out << indent(2) << "return;\n";
+        out << indent(1) << "}\n";
+        out << indent(1) << "std::fputs(\"{\\\"lines\\\": {\", file);\n";
+        out << indent(1) << "const char* separator = \"\";\n";
+        out << indent(1) << "for (int line = 1; line <= " << lines << "; ++line) {\n";
+        out << indent(2) << "if (bl_line_counts[line] != 0) {\n";
+        out << indent(3) << "std::fprintf(file, \"%s\\\"%d\\\": %llu\", separator, line, "
+            << "bl_line_counts[line]);\n";
+        out << indent(3) << "separator = \", \";\n";
+        out << indent(2) << "}\n";
+        out << indent(1) << "}\n";
+        out << indent(1) << "std::fputs(\"}}\\n\", file);\n";
+        out << indent(1) << "std::fclose(file);\n";
+        out << "}\n\n";
+    }
+    if (options.entryPoint.empty()) {
+        out << "int main() {\n";
+    } else {
+        out << "extern \"C\" int " << options.entryPoint << "() {\n";
+    }
+    emitStreamSetup(options, out);
+    if (countLines) {
+        out << indent(1) << "std::atexit(bl_write_line_counts);\n";
+    }
     //out << indent(1) << "std::cin.tie(nullptr);\n";
     //out << indent(1) << "std::cout << std::boolalpha;\n";
-    emitStatements(program.statements, 1, out, mangler, false);
+    emitStatements(program.statements, 1, out, mangler, options, false);
     out << indent(1) << "return 0;\n";
     out << "}\n";
     return out.str();
 }
 
+std::string CodeGenerator::generateBatch(const std::vector<const Program*>& programs,
+                                         const CodegenOptions& options) {
+    std::ostringstream out;
+    emitPrologue(runtimeFeatures(programs), false, options, out);
+    for (std::size_t id = 0; id < programs.size(); ++id) {
+        // A fresh mangler per program: each run() is its own scope.
+        NameMangler mangler;
+        out << "namespace bl_program_" << id << " {\n\n";
+        out << "int run() {\n";
+        emitStatements(programs[id]->statements, 1, out, mangler, options, false);
+        out << indent(1) << "return 0;\n";
+        out << "}\n\n";
+        out << "}  // namespace bl_program_" << id << "\n\n";
+    }
+    out << "int main(int argc, char* argv[]) {\n";
+    out << indent(1) << "static int (*const programs[])() = {";
+    for (std::size_t id = 0; id < programs.size(); ++id) {
+        out << (id == 0 ? "" : ", ") << "bl_program_" << id << "::run";
+    }
+    out << (programs.empty() ? "nullptr" : "") << "};\n";
+    // Digits only, parsed by hand: the runtime may not include <cstdlib>.
+    out << indent(1) << "unsigned long id = 0;\n";
+    out << indent(1) << "const char* digit = argc == 2 ? argv[1] : \"\";\n";
+    out << indent(1) << "if (*digit == '\\0') {\n";
+    out << indent(2) << "return 2;\n";
+    out << indent(1) << "}\n";
+    out << indent(1) << "for (; *digit != '\\0'; ++digit) {\n";
+    out << indent(2) << "if (*digit < '0' || *digit > '9' || id >= " << programs.size() << ") {\n";
+    out << indent(3) << "return 2;\n";
+    out << indent(2) << "}\n";
+    out << indent(2) << "id = id * 10 + static_cast<unsigned long>(*digit - '0');\n";
+    out << indent(1) << "}\n";
+    out << indent(1) << "if (id >= " << programs.size() << ") {\n";
+    out << indent(2) << "return 2;\n";
+    out << indent(1) << "}\n";
+    emitStreamSetup(options, out);
+    out << indent(1) << "return programs[id]();\n";
+    out << "}\n";
+    return out.str();
+}
+
 }  // namespace bearlang
@@ -1,14 +1,50 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "core/parser/ast.h"
 
 namespace bearlang {
 
+struct CodegenOptions {
+    // Ends lines with '\n' and merges consecutive `вывод` statements into one
+    // write. The stream is still flushed before `ввод` (std::cin is tied to
+    // std::cout) and at exit. Interactive lessons that must see every line
+    // immediately, even if the program crashes later, turn this off to get
+    // std::endl after each line.
+    bool bufferedOutput = true;
+    // When set, the program counts how often each BearLang line runs (a
+    // loop's line once per test of its condition) and writes the counts to
+    // this file as JSON, {"lines": {"<line>": <count>, ...}}, when it exits
+    // normally.
+    std::string lineCountsPath;
+    // Prints, reads, keeps strings and raises to a power through the small
+    // <cstdio>-based runtime of runtime.h instead of <iostream>, <string> and
+    // <cmath>, which makes g++ several times faster on these programs. The
+    // output is byte for byte the same; the default stays the readable
+    // std::cout version learners are shown.
+    bool minimalRuntime = false;
+    // With minimalRuntime: includes the runtime from this header, which
+    // holds runtimeHeader() and usually has a precompiled .gch beside it,
+    // instead of writing the parts the program uses into it.
+    std::string runtimeHeaderPath;
+    // When set, the program is `extern "C" int <entryPoint>()` instead of
+    // main(), to be built as a shared object and called by a loader (see
+    // Zygote in core/process/zygote.h).
+    std::string entryPoint;
+};
+
 class CodeGenerator {
 public:
-    static std::string generate(const Program& program);
+    static std::string generate(const Program& program, const CodegenOptions& options = {});
+
+    // Several programs in one translation unit, so that a single g++ run
+    // builds them all: program i becomes bl_program_<i>::run(), and main()
+    // runs the one whose number is its only argument. Any other argument
+    // exits with status 2. lineCountsPath is ignored.
+    static std::string generateBatch(const std::vector<const Program*>& programs,
+                                     const CodegenOptions& options = {});
 };
 
 }  // namespace bearlang
@@ -0,0 +1,282 @@
+#include "cse.h"
+
+#include <algorithm>
+
+namespace bearlang {
+
+namespace {
+
+struct KeyInfo {
+    std::size_t size = 1;
+    bool candidate = false;
+    bool mayTrap = false;
+    std::vector<std::string> variables;
+};
+
+struct Occurrence {
+    const Expression* expr;
+    std::size_t statement;
+    bool conditional;
+};
+
+struct Run {
+    std::size_t key;
+    std::vector<Occurrence> occurrences;
+};
+
+class Planner {
+public:
+    explicit Planner(const NameResolver& resolve) : resolve_(resolve) {}
+
+    CsePlan plan(const std::vector<StmtPtr>& statements) {
+        for (std::size_t i = 0; i < statements.size(); ++i) {
+            visitStatement(*statements[i], i);
+        }
+
+        CsePlan result;
+        result.before.resize(statements.size());
+        selectHoists(result);
+        return result;
+    }
+
+private:
+    std::string resolve(const std::string& name) const {
+        auto local = locals_.find(name);
+        if (local != locals_.end()) {
+            return local->second;
+        }
+        return resolve_(name);
+    }
+
+    void visitStatement(const Statement& statement, std::size_t index) {
+        switch (statement.kind()) {
+            case StatementKind::VarDecl: {
+                const auto& decl = static_cast<const VarDeclStmt&>(statement);
+                // The code generator declares the name before emitting the
+                // initializer, so the initializer already sees the new variable.
+                locals_[decl.name] = "#" + std::to_string(index);
+                if (decl.initializer) {
+                    // Temporaries are defined before the declaration, so
+                    // nothing that reads the new variable may be hoisted out
+                    // of its own initializer.
+                    declaring_ = locals_[decl.name];
+                    visitExpression(*decl.initializer, index, false);
+                    declaring_.clear();
+                }
+                break;
+            }
+            case StatementKind::Assign: {
+                const auto& assign = static_cast<const AssignStmt&>(statement);
+                visitExpression(*assign.value, index, false);
+                kill(resolve(assign.name));
+                break;
+            }
+            case StatementKind::Input: {
+                const auto& input = static_cast<const InputStmt&>(statement);
+                kill(resolve(input.name));
+                break;
+            }
+            case StatementKind::Output: {
+                const auto& output = static_cast<const OutputStmt&>(statement);
+                visitExpression(*output.value, index, false);
+                break;
+            }
+            case StatementKind::If: {
+                const auto& ifStmt = static_cast<const IfStmt&>(statement);
+                for (std::size_t i = 0; i < ifStmt.branches.size(); ++i) {
+                    visitExpression(*ifStmt.branches[i].condition, index, i > 0);
+                }
+                openRuns_.clear();
+                break;
+            }
+            case StatementKind::While:
+            case StatementKind::ForRange:
+                // Loop headers are re-evaluated on every iteration and belong to
+                // the loop, not to the enclosing block.
+                openRuns_.clear();
+                break;
+        }
+    }
+
+    std::size_t visitExpression(const Expression& expr, std::size_t statement, bool conditional) {
+        std::string signature;
+        KeyInfo info;
+        switch (expr.kind()) {
+            case ExpressionKind::Literal: {
+                const auto& literal = static_cast<const LiteralExpr&>(expr);
+                signature = "L" + std::to_string(static_cast<int>(literal.type)) + ":" + literal.text;
+                break;
+            }
+            case ExpressionKind::Variable: {
+                const auto& var = static_cast<const VariableExpr&>(expr);
+                std::string resolved = resolve(var.name);
+                signature = "V" + resolved;
+                info.variables.push_back(std::move(resolved));
+                break;
+            }
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                std::size_t operand = visitExpression(*unary.operand, statement, conditional);
+                const KeyInfo& operandInfo = keys_[operand];
+                signature = "U" + unary.op + "(" + std::to_string(operand) + ")";
+                info.size = operandInfo.size + 1;
+                info.mayTrap = operandInfo.mayTrap;
+                info.variables = operandInfo.variables;
+                // Negating a plain name or literal is not worth a temporary.
+                info.candidate = operandInfo.candidate;
+                break;
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                bool shortCircuit = binary.op == "&&" || binary.op == "||";
+                std::size_t left = visitExpression(*binary.left, statement, conditional);
+                std::size_t right =
+                    visitExpression(*binary.right, statement, conditional || shortCircuit);
+                const KeyInfo& leftInfo = keys_[left];
+                const KeyInfo& rightInfo = keys_[right];
+                signature = "B" + binary.op + "(" + std::to_string(left) + "," +
+                            std::to_string(right) + ")";
+                info.size = leftInfo.size + rightInfo.size + 1;
+                // Integer division by zero traps, so such expressions may only be
+                // moved to a point where the program evaluated them anyway.
+                info.mayTrap = leftInfo.mayTrap || rightInfo.mayTrap || binary.op == "/" ||
+                               binary.op == "%";
+                info.variables = leftInfo.variables;
+                for (const auto& name : rightInfo.variables) {
+                    if (std::find(info.variables.begin(), info.variables.end(), name) ==
+                        info.variables.end()) {
+                        info.variables.push_back(name);
+                    }
+                }
+                info.candidate = !info.variables.empty();
+                break;
+            }
+        }
+
+        std::size_t key = intern(signature, std::move(info));
+        const KeyInfo& keyInfo = keys_[key];
+        if (keyInfo.candidate &&
+            std::find(keyInfo.variables.begin(), keyInfo.variables.end(), declaring_) ==
+                keyInfo.variables.end()) {
+            record(expr, key, statement, conditional);
+        }
+        return key;
+    }
+
+    std::size_t intern(const std::string& signature, KeyInfo info) {
+        auto found = interned_.find(signature);
+        if (found != interned_.end()) {
+            return found->second;
+        }
+        std::size_t key = keys_.size();
+        for (const auto& name : info.variables) {
+            keysByVariable_[name].push_back(key);
+        }
+        keys_.push_back(std::move(info));
+        interned_.emplace(signature, key);
+        return key;
+    }
+
+    void record(const Expression& expr, std::size_t key, std::size_t statement, bool conditional) {
+        auto open = openRuns_.find(key);
+        std::size_t run;
+        if (open == openRuns_.end()) {
+            run = runs_.size();
+            runs_.push_back(Run{key, {}});
+            openRuns_.emplace(key, run);
+        } else {
+            run = open->second;
+        }
+        runs_[run].occurrences.push_back(Occurrence{&expr, statement, conditional});
+        runOf_[&expr] = run;
+    }
+
+    void kill(const std::string& resolvedName) {
+        auto found = keysByVariable_.find(resolvedName);
+        if (found == keysByVariable_.end()) {
+            return;
+        }
+        for (std::size_t key : found->second) {
+            openRuns_.erase(key);
+        }
+    }
+
+    void selectHoists(CsePlan& plan) {
+        std::vector<std::size_t> order(runs_.size());
+        std::vector<long> effective(runs_.size());
+        for (std::size_t i = 0; i < runs_.size(); ++i) {
+            order[i] = i;
+            effective[i] = static_cast<long>(runs_[i].occurrences.size());
+        }
+        // Larger expressions first: once an expression is hoisted, its copies
+        // collapse into one definition and the subexpressions inside the other
+        // copies no longer count as repeats.
+        std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+            return keys_[runs_[a].key].size > keys_[runs_[b].key].size;
+        });
+
+        for (std::size_t runIndex : order) {
+            const Run& run = runs_[runIndex];
+            const KeyInfo& info = keys_[run.key];
+            const Occurrence& first = run.occurrences.front();
+            if (effective[runIndex] < 2 || (info.mayTrap && first.conditional)) {
+                continue;
+            }
+            std::size_t slot = plan.slotCount++;
+            plan.before[first.statement].push_back(CsePlan::Hoist{slot, first.expr});
+            for (const auto& occurrence : run.occurrences) {
+                plan.uses[occurrence.expr] = slot;
+            }
+            discountNested(*first.expr, effective[runIndex] - 1, effective);
+        }
+
+        for (auto& hoists : plan.before) {
+            std::stable_sort(hoists.begin(), hoists.end(),
+                             [this](const CsePlan::Hoist& a, const CsePlan::Hoist& b) {
+                                 return keys_[runs_[runOf_.at(a.expr)].key].size <
+                                        keys_[runs_[runOf_.at(b.expr)].key].size;
+                             });
+        }
+    }
+
+    void discountNested(const Expression& expr, long removedCopies, std::vector<long>& effective) {
+        const Expression* children[2] = {nullptr, nullptr};
+        if (expr.kind() == ExpressionKind::Unary) {
+            children[0] = static_cast<const UnaryExpr&>(expr).operand.get();
+        } else if (expr.kind() == ExpressionKind::Binary) {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            children[0] = binary.left.get();
+            children[1] = binary.right.get();
+        }
+        for (const Expression* child : children) {
+            if (!child) {
+                continue;
+            }
+            auto run = runOf_.find(child);
+            if (run != runOf_.end()) {
+                effective[run->second] -= removedCopies;
+            }
+            discountNested(*child, removedCopies, effective);
+        }
+    }
+
+    const NameResolver& resolve_;
+    std::unordered_map<std::string, std::string> locals_;
+    std::string declaring_;
+    std::unordered_map<std::string, std::size_t> interned_;
+    std::vector<KeyInfo> keys_;
+    std::unordered_map<std::string, std::vector<std::size_t>> keysByVariable_;
+    std::vector<Run> runs_;
+    std::unordered_map<std::size_t, std::size_t> openRuns_;
+    std::unordered_map<const Expression*, std::size_t> runOf_;
+};
+
+}  // namespace
+
+CsePlan planCommonSubexpressions(const std::vector<StmtPtr>& statements,
+                                 const NameResolver& resolve) {
+    Planner planner(resolve);
+    return planner.plan(statements);
+}
+
+}  // namespace bearlang
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// Result of common-subexpression elimination for one block of statements.
+// Each slot is a temporary that is computed once before the statement that
+// first needs it and reused by every later occurrence of the same expression.
+struct CsePlan {
+    struct Hoist {
+        std::size_t slot;
+        const Expression* expr;
+    };
+
+    // Temporaries to define right before statement i, subexpressions first.
+    std::vector<std::vector<Hoist>> before;
+    // Expression nodes that are replaced by the temporary of a slot.
+    std::unordered_map<const Expression*, std::size_t> uses;
+    std::size_t slotCount = 0;
+};
+
+using NameResolver = std::function<std::string(const std::string&)>;
+
+// Finds structurally identical pure expressions inside the straight-line part
+// of a block. Variables are compared after resolution, so shadowed names never
+// match, and any assignment or nested control flow ends the reuse window.
+CsePlan planCommonSubexpressions(const std::vector<StmtPtr>& statements,
+                                 const NameResolver& resolve);
+
+}  // namespace bearlang
@@ -0,0 +1,508 @@
+#include "runtime.h"
+
+#include <vector>
+
+namespace bearlang {
+
+namespace {
+
+void scanExpression(const Expression* expr, RuntimeFeatures& features) {
+    if (!expr) {
+        return;
+    }
+    if (expr->kind() == ExpressionKind::Unary) {
+        scanExpression(static_cast<const UnaryExpr&>(*expr).operand.get(), features);
+    } else if (expr->kind() == ExpressionKind::Binary) {
+        const auto& binary = static_cast<const BinaryExpr&>(*expr);
+        features.power = features.power || binary.op == "^";
+        // Every string operand is either a literal or a `строка` variable,
+        // whose declaration already asks for bl_string.
+        for (const Expression* operand : {binary.left.get(), binary.right.get()}) {
+            features.strings = features.strings ||
+                               (operand && operand->kind() == ExpressionKind::Literal &&
+                                static_cast<const LiteralExpr&>(*operand).type == ValueType::String);
+            scanExpression(operand, features);
+        }
+    }
+}
+
+void scanStatements(const std::vector<StmtPtr>& statements, RuntimeFeatures& features) {
+    for (const auto& stmt : statements) {
+        switch (stmt->kind()) {
+            case StatementKind::VarDecl: {
+                const auto& decl = static_cast<const VarDeclStmt&>(*stmt);
+                features.strings = features.strings || decl.type == ValueType::String;
+                scanExpression(decl.initializer.get(), features);
+                break;
+            }
+            case StatementKind::Assign:
+                scanExpression(static_cast<const AssignStmt&>(*stmt).value.get(), features);
+                break;
+            case StatementKind::Input:
+                features.input = true;
+                break;
+            case StatementKind::Output:
+                scanExpression(static_cast<const OutputStmt&>(*stmt).value.get(), features);
+                break;
+            case StatementKind::If: {
+                const auto& ifStmt = static_cast<const IfStmt&>(*stmt);
+                for (const auto& branch : ifStmt.branches) {
+                    scanExpression(branch.condition.get(), features);
+                    scanStatements(branch.body, features);
+                }
+                scanStatements(ifStmt.elseBranch, features);
+                break;
+            }
+            case StatementKind::While: {
+                const auto& loop = static_cast<const WhileStmt&>(*stmt);
+                scanExpression(loop.condition.get(), features);
+                scanStatements(loop.body, features);
+                break;
+            }
+            case StatementKind::ForRange: {
+                const auto& loop = static_cast<const ForRangeStmt&>(*stmt);
+                scanExpression(loop.from.get(), features);
+                scanExpression(loop.to.get(), features);
+                scanStatements(loop.body, features);
+                break;
+            }
+        }
+    }
+}
+
+const char* const kOutput = R"(// BearLang runtime: std::cout and std::cin rebuilt on <cstdio>, which g++
+// parses several times faster than <iostream>.
+inline void bl_write(int value) {
+    char digits[12];
+    char* end = digits + sizeof digits;
+    char* begin = end;
+    unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+    do {
+        *--begin = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        *--begin = '-';
+    }
+    std::fwrite(begin, 1, end - begin, stdout);
+}
+
+// std::cout's default format: 6 significant digits, %g.
+inline void bl_write(double value) {
+    std::printf("%g", value);
+}
+
+// Without std::boolalpha std::cout prints 1 / 0.
+inline void bl_write(bool value) {
+    std::putc(value ? '1' : '0', stdout);
+}
+
+inline void bl_write(const char* text) {
+    std::fputs(text, stdout);
+}
+)";
+
+const char* const kLine = R"(
+inline void bl_line() {
+    std::putc('\n', stdout);
+}
+)";
+
+// std::endl.
+const char* const kFlushedLine = R"(
+inline void bl_endl() {
+    std::putc('\n', stdout);
+    std::fflush(stdout);
+}
+)";
+
+const char* const kString = R"(
+// `строка`: the part of std::string that generated code uses.
+class bl_string {
+public:
+    bl_string() {}
+    bl_string(const char* text) {
+        append(text, __builtin_strlen(text));
+    }
+    bl_string(const bl_string& other) {
+        append(other.data_, other.size_);
+    }
+    bl_string(bl_string&& other) : data_(other.data_), size_(other.size_), capacity_(other.capacity_) {
+        other.data_ = nullptr;
+        other.size_ = other.capacity_ = 0;
+    }
+    ~bl_string() {
+        std::free(data_);
+    }
+
+    bl_string& operator=(const bl_string& other) {
+        if (this != &other) {
+            size_ = 0;
+            append(other.data_, other.size_);
+        }
+        return *this;
+    }
+    bl_string& operator=(bl_string&& other) {
+        char* data = data_;
+        data_ = other.data_;
+        other.data_ = data;
+        size_ = other.size_;
+        other.size_ = 0;
+        std::size_t capacity = capacity_;
+        capacity_ = other.capacity_;
+        other.capacity_ = capacity;
+        return *this;
+    }
+
+    const char* data() const {
+        return data_ ? data_ : "";
+    }
+    std::size_t size() const {
+        return size_;
+    }
+    void clear() {
+        size_ = 0;
+    }
+    void reserve(std::size_t capacity) {
+        if (capacity > capacity_) {
+            char* buffer = static_cast<char*>(std::malloc(capacity));
+            if (size_ != 0) {
+                __builtin_memcpy(buffer, data_, size_);
+            }
+            std::free(data_);
+            data_ = buffer;
+            capacity_ = capacity;
+        }
+    }
+    bl_string& append(const bl_string& other) {
+        return append(other.data_, other.size_);
+    }
+    bl_string& append(const char* text) {
+        return append(text, __builtin_strlen(text));
+    }
+    bl_string& append(const char* text, std::size_t length) {
+        if (length == 0) {
+            return *this;
+        }
+        if (size_ + length > capacity_) {
+            // `text` may point into the buffer being replaced.
+            std::size_t capacity = size_ + length > 2 * capacity_ ? size_ + length : 2 * capacity_;
+            char* buffer = static_cast<char*>(std::malloc(capacity));
+            if (size_ != 0) {
+                __builtin_memcpy(buffer, data_, size_);
+            }
+            __builtin_memcpy(buffer + size_, text, length);
+            std::free(data_);
+            data_ = buffer;
+            capacity_ = capacity;
+        } else {
+            __builtin_memcpy(data_ + size_, text, length);
+        }
+        size_ += length;
+        return *this;
+    }
+
+private:
+    char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t capacity_ = 0;
+};
+
+// Either side of a comparison or `+`, so a literal is not copied first.
+struct bl_string_view {
+    bl_string_view(const bl_string& text) : data(text.data()), size(text.size()) {}
+    bl_string_view(const char* text) : data(text), size(__builtin_strlen(text)) {}
+
+    const char* data;
+    std::size_t size;
+};
+
+// std::string::compare: bytes as unsigned char, then the shorter first.
+inline int bl_compare(bl_string_view left, bl_string_view right) {
+    std::size_t common = left.size < right.size ? left.size : right.size;
+    int order = common == 0 ? 0 : __builtin_memcmp(left.data, right.data, common);
+    if (order != 0) {
+        return order;
+    }
+    return left.size < right.size ? -1 : left.size > right.size ? 1 : 0;
+}
+
+inline bool operator==(bl_string_view left, bl_string_view right) {
+    return bl_compare(left, right) == 0;
+}
+inline bool operator!=(bl_string_view left, bl_string_view right) {
+    return bl_compare(left, right) != 0;
+}
+inline bool operator<(bl_string_view left, bl_string_view right) {
+    return bl_compare(left, right) < 0;
+}
+inline bool operator<=(bl_string_view left, bl_string_view right) {
+    return bl_compare(left, right) <= 0;
+}
+inline bool operator>(bl_string_view left, bl_string_view right) {
+    return bl_compare(left, right) > 0;
+}
+inline bool operator>=(bl_string_view left, bl_string_view right) {
+    return bl_compare(left, right) >= 0;
+}
+
+inline bl_string operator+(bl_string_view left, bl_string_view right) {
+    bl_string result;
+    result.reserve(left.size + right.size);
+    result.append(left.data, left.size).append(right.data, right.size);
+    return result;
+}
+
+inline void bl_write(const bl_string& text) {
+    std::fwrite(text.data(), 1, text.size(), stdout);
+}
+)";
+
+const char* const kInput = R"(
+// Cleared by a failed read or the end of input, like std::cin.good(); every
+// later read then leaves its variable unchanged.
+static bool bl_input_good = true;
+
+inline int bl_next() {
+    int c = std::getc(stdin);
+    if (c == EOF) {
+        bl_input_good = false;
+    }
+    return c;
+}
+
+inline void bl_unget(int c) {
+    if (c != EOF) {
+        std::ungetc(c, stdin);
+    }
+}
+
+inline bool bl_space(int c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// std::istream::sentry: flushes the output std::cin is tied to, then skips
+// whitespace. False when there is nothing to read.
+inline bool bl_begin_read() {
+    std::fflush(stdout);
+    if (!bl_input_good) {
+        return false;
+    }
+    int c;
+    do {
+        c = bl_next();
+    } while (bl_space(c));
+    bl_unget(c);
+    return bl_input_good;
+}
+
+// An optional sign and decimal digits, as std::num_get collects them for a
+// long. The magnitude saturates far above the int range.
+inline bool bl_read_integer(bool& negative, unsigned long long& magnitude) {
+    int c = bl_next();
+    negative = c == '-';
+    if (c == '-' || c == '+') {
+        c = bl_next();
+    }
+    bool digits = false;
+    magnitude = 0;
+    while (c >= '0' && c <= '9') {
+        digits = true;
+        if (magnitude < 1000000000000ull) {
+            magnitude = magnitude * 10 + static_cast<unsigned>(c - '0');
+        }
+        c = bl_next();
+    }
+    bl_unget(c);
+    return digits;
+}
+
+// No digits store 0; out of range stores the nearest limit. Both fail.
+inline void bl_read(int& value) {
+    if (!bl_begin_read()) {
+        return;
+    }
+    bool negative;
+    unsigned long long magnitude;
+    if (!bl_read_integer(negative, magnitude)) {
+        value = 0;
+        bl_input_good = false;
+    } else if (magnitude > (negative ? 2147483648ull : 2147483647ull)) {
+        value = negative ? -2147483647 - 1 : 2147483647;
+        bl_input_good = false;
+    } else {
+        value = static_cast<int>(negative ? -static_cast<long long>(magnitude) : static_cast<long long>(magnitude));
+    }
+}
+
+// Only 0 and 1 are accepted; no digits store false, other numbers true, and
+// both fail.
+inline void bl_read(bool& value) {
+    if (!bl_begin_read()) {
+        return;
+    }
+    bool negative;
+    unsigned long long magnitude;
+    bool digits = bl_read_integer(negative, magnitude);
+    if (digits && (magnitude == 0 || (magnitude == 1 && !negative))) {
+        value = magnitude == 1;
+        return;
+    }
+    value = digits;
+    bl_input_good = false;
+}
+
+// Collects sign, digits, one '.' and an exponent the way std::num_get does,
+// then converts with strtod: text it cannot convert entirely stores 0, an
+// overflow the largest double, and both fail.
+inline void bl_read(double& value) {
+    if (!bl_begin_read()) {
+        return;
+    }
+    std::size_t size = 0;
+    std::size_t capacity = 64;
+    char* text = static_cast<char*>(std::malloc(capacity));
+    bool mantissa = false;
+    bool point = false;
+    bool exponent = false;
+    int c = bl_next();
+    if (c == '+' || c == '-') {
+        text[size++] = static_cast<char>(c);
+        c = bl_next();
+    }
+    while (true) {
+        if (size + 2 >= capacity) {
+            capacity *= 2;
+            text = static_cast<char*>(std::realloc(text, capacity));
+        }
+        if (c >= '0' && c <= '9') {
+            mantissa = true;
+        } else if (c == '.' && !point && !exponent) {
+            point = true;
+        } else if ((c == 'e' || c == 'E') && !exponent && mantissa) {
+            exponent = true;
+            text[size++] = 'e';
+            c = bl_next();
+            if (c != '+' && c != '-') {
+                continue;
+            }
+        } else {
+            break;
+        }
+        text[size++] = static_cast<char>(c);
+        c = bl_next();
+    }
+    bl_unget(c);
+    text[size] = '\0';
+    char* end = text;
+    double parsed = std::strtod(text, &end);
+    if (size == 0 || *end != '\0') {
+        value = 0.0;
+        bl_input_good = false;
+    } else if (parsed == __builtin_huge_val() || parsed == -__builtin_huge_val()) {
+        value = parsed > 0 ? 1.7976931348623157e308 : -1.7976931348623157e308;
+        bl_input_good = false;
+    } else {
+        value = parsed;
+    }
+    std::free(text);
+}
+)";
+
+const char* const kStringInput = R"(
+inline void bl_read(bl_string& value) {
+    if (!bl_begin_read()) {
+        return;
+    }
+    value.clear();
+    int c = bl_next();
+    while (c != EOF && !bl_space(c)) {
+        char byte = static_cast<char>(c);
+        value.append(&byte, 1);
+        c = bl_next();
+    }
+    bl_unget(c);
+}
+)";
+
+const char* const kPower = R"(
+inline double bl_pow(double base, double exponent) {
+    return __builtin_pow(base, exponent);
+}
+
+// `^` on two `целое`: repeated squaring is exact while the result fits in the
+// 53-bit mantissa of a double, where std::pow is exact too; beyond that and
+// for negative exponents it is pow itself.
+inline double bl_ipow(int base, int exponent) {
+    if (exponent < 0) {
+        return __builtin_pow(base, exponent);
+    }
+    double result = 1.0;
+    double factor = base;
+    for (int remaining = exponent; remaining != 0; remaining >>= 1) {
+        if (remaining & 1) {
+            result *= factor;
+        }
+        if (remaining > 1) {
+            factor *= factor;
+        }
+    }
+    if (result >= 9007199254740992.0 || result <= -9007199254740992.0) {
+        return __builtin_pow(base, exponent);
+    }
+    return result;
+}
+)";
+
+}  // namespace
+
+RuntimeFeatures runtimeFeatures(const Program& program) {
+    RuntimeFeatures features;
+    scanStatements(program.statements, features);
+    return features;
+}
+
+RuntimeFeatures runtimeFeatures(const std::vector<const Program*>& programs) {
+    RuntimeFeatures features;
+    for (const Program* program : programs) {
+        scanStatements(program->statements, features);
+    }
+    return features;
+}
+
+std::string runtimeSource(const RuntimeFeatures& features) {
+    std::string source = "#include <cstdio>\n";
+    if (features.input || features.strings) {
+        source += "#include <cstdlib>\n";
+    }
+    source += "\n";
+    source += kOutput;
+    if (features.strings) {
+        source += kString;
+    }
+    source += kLine;
+    if (features.flushedLines) {
+        source += kFlushedLine;
+    }
+    if (features.input) {
+        source += kInput;
+        if (features.strings) {
+            source += kStringInput;
+        }
+    }
+    if (features.power) {
+        source += kPower;
+    }
+    return source + "\n";
+}
+
+std::string runtimeHeader() {
+    RuntimeFeatures all;
+    all.input = true;
+    all.strings = true;
+    all.power = true;
+    all.flushedLines = true;
+    return runtimeSource(all);
+}
+
+}  // namespace bearlang
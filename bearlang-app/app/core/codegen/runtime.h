@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// The parts of the minimal runtime (CodegenOptions::minimalRuntime) a
+// program needs.
+struct RuntimeFeatures {
+    // `ввод`: the readers, and <cstdlib> for strtod.
+    bool input = false;
+    // `строка` values other than literals passed straight to `вывод`:
+    // bl_string, which stands in for std::string.
+    bool strings = false;
+    // `^`: bl_pow / bl_ipow.
+    bool power = false;
+    // Unbuffered output: bl_endl, a line written out at once.
+    bool flushedLines = false;
+};
+
+// Everything but flushedLines, which depends on CodegenOptions.
+RuntimeFeatures runtimeFeatures(const Program& program);
+// What any of `programs` needs, for programs that share one file.
+RuntimeFeatures runtimeFeatures(const std::vector<const Program*>& programs);
+
+// C++ that replaces <iostream>, <string> and <cmath> in generated programs:
+// bl_write / bl_line / bl_endl print through <cstdio> exactly what
+// std::cout << prints, bl_read parses input by the rules of std::cin >>
+// (std::num_get) including its failure states, bl_string does what
+// std::string does for `строка`, and bl_pow / bl_ipow compute `^` without
+// <cmath>. Only the pieces in `features` are emitted.
+std::string runtimeSource(const RuntimeFeatures& features);
+
+// The whole runtime, the same for every program, for a header that is
+// precompiled once (CodegenOptions::runtimeHeaderPath).
+std::string runtimeHeader();
+
+}  // namespace bearlang
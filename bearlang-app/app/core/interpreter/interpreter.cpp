@@ -0,0 +1,202 @@
+#include "interpreter.h"
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "resolver.h"
+
+namespace bearlang {
+
+namespace {
+
+class TreeWalker {
+public:
+    TreeWalker(std::size_t slotCount,
+               std::istream& in,
+               std::ostream& out,
+               const InterpreterOptions& options)
+        : slots_(slotCount), in_(in), out_(out), options_(options) {}
+
+    void executeAll(const std::vector<Action>& actions) {
+        for (const auto& action : actions) {
+            execute(action);
+        }
+    }
+
+private:
+    // Stores a freshly computed value, moving it when it lives in `scratch`
+    // rather than in another variable.
+    void store(const Action& action, const Value& value, Value& scratch) {
+        Value& target = slots_[action.slot];
+        if (action.convert) {
+            target = convertValue(value, action.type);
+        } else if (&value == &scratch) {
+            target = std::move(scratch);
+        } else {
+            target = value;
+        }
+    }
+
+    void execute(const Action& action) {
+        switch (action.kind) {
+            case ActionKind::Declare: {
+                // The initializer may read the new variable, which is
+                // default-initialized at that point.
+                slots_[action.slot] = defaultValue(action.type);
+                if (action.hasValue) {
+                    Value scratch;
+                    store(action, evaluate(action.value, scratch), scratch);
+                }
+                break;
+            }
+            case ActionKind::Assign: {
+                Value scratch;
+                store(action, evaluate(action.value, scratch), scratch);
+                break;
+            }
+            case ActionKind::Append: {
+                // Other variables holding the same string keep the old text.
+                auto& target = slots_[action.slot].mutableString();
+                for (const auto& piece : action.pieces) {
+                    Value scratch;
+                    target += evaluate(piece, scratch).string();
+                }
+                break;
+            }
+            case ActionKind::Input:
+                out_.flush();
+                readValue(in_, slots_[action.slot]);
+                break;
+            case ActionKind::Output: {
+                if (action.value.kind == NodeKind::Concat) {
+                    // Streamed piece by piece, like the generated C++.
+                    for (const auto& piece : action.value.operands) {
+                        Value scratch;
+                        writeValue(out_, evaluate(piece, scratch));
+                    }
+                } else {
+                    Value scratch;
+                    writeValue(out_, evaluate(action.value, scratch));
+                }
+                if (options_.bufferedOutput) {
+                    out_ << '\n';
+                } else {
+                    out_ << std::endl;
+                }
+                break;
+            }
+            case ActionKind::If: {
+                for (const auto& branch : action.branches) {
+                    if (test(branch.condition)) {
+                        executeAll(branch.body);
+                        return;
+                    }
+                }
+                if (action.hasElse) {
+                    executeAll(action.body);
+                }
+                break;
+            }
+            case ActionKind::While:
+                while (test(action.value)) {
+                    executeAll(action.body);
+                }
+                break;
+            case ActionKind::For: {
+                slots_[action.slot] = defaultValue(action.type);
+                {
+                    Value scratch;
+                    store(action, evaluate(action.value, scratch), scratch);
+                }
+                // The bound is re-evaluated on every iteration, like the
+                // condition of the emitted C++ `for`.
+                while (true) {
+                    Value scratch;
+                    const Value& bound = evaluate(action.bound, scratch);
+                    if (!truthy(applyBinary(BinaryOp::Le, slots_[action.slot], bound))) {
+                        break;
+                    }
+                    executeAll(action.body);
+                    increment(slots_[action.slot]);
+                }
+                break;
+            }
+        }
+    }
+
+    static void increment(Value& counter) {
+        if (counter.isInt()) {
+            counter = wrapAdd(counter.integer(), 1);
+        } else if (counter.isDouble()) {
+            counter = counter.number() + 1.0;
+        } else if (counter.isBool()) {
+            // ++ on a bool always yields true.
+            counter = true;
+        }
+    }
+
+    bool test(const Node& condition) {
+        Value scratch;
+        return truthy(evaluate(condition, scratch));
+    }
+
+    // Returns the value of a node without copying variables or constants:
+    // the result refers either to them or to `scratch`.
+    const Value& evaluate(const Node& node, Value& scratch) {
+        switch (node.kind) {
+            case NodeKind::Constant:
+                return node.constant;
+            case NodeKind::Slot:
+                return slots_[node.slot];
+            case NodeKind::Unary: {
+                Value operand;
+                scratch = applyUnary(node.unaryOp, evaluate(node.operands[0], operand));
+                return scratch;
+            }
+            case NodeKind::Binary: {
+                Value left;
+                Value right;
+                const Value& a = evaluate(node.operands[0], left);
+                const Value& b = evaluate(node.operands[1], right);
+                scratch = applyBinary(node.binaryOp, a, b);
+                return scratch;
+            }
+            case NodeKind::And:
+                scratch = test(node.operands[0]) && test(node.operands[1]);
+                return scratch;
+            case NodeKind::Or:
+                scratch = test(node.operands[0]) || test(node.operands[1]);
+                return scratch;
+            case NodeKind::Concat: {
+                std::string result;
+                for (const auto& piece : node.operands) {
+                    Value value;
+                    result += evaluate(piece, value).string();
+                }
+                scratch = std::move(result);
+                return scratch;
+            }
+        }
+        throw RuntimeError("Неизвестное выражение");
+    }
+
+    std::vector<Value> slots_;
+    std::istream& in_;
+    std::ostream& out_;
+    const InterpreterOptions& options_;
+};
+
+}  // namespace
+
+void Interpreter::run(const Program& program,
+                      std::istream& in,
+                      std::ostream& out,
+                      const InterpreterOptions& options) {
+    ResolvedProgram resolved = resolveProgram(program);
+    TreeWalker walker(resolved.slotCount, in, out, options);
+    walker.executeAll(resolved.actions);
+    out.flush();
+}
+
+}  // namespace bearlang
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <iosfwd>
+
+#include "core/parser/ast.h"
+#include "value.h"
+
+namespace bearlang {
+
+struct InterpreterOptions {
+    // Same meaning as CodegenOptions::bufferedOutput: '\n' instead of
+    // std::endl after each `вывод`. Output is flushed before every `ввод`.
+    bool bufferedOutput = true;
+};
+
+// Runs a Program directly on the AST, without g++ or a child process.
+// Results match the generated C++: int/double/string/bool values, `std::pow`
+// for `^`, truncating integer division and stream-based input and output.
+// The program must already have passed checkProgram. Throws RuntimeError
+// where the native program would crash (division by zero).
+class Interpreter {
+public:
+    static void run(const Program& program,
+                    std::istream& in,
+                    std::ostream& out,
+                    const InterpreterOptions& options = {});
+};
+
+}  // namespace bearlang
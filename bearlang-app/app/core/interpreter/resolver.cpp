@@ -0,0 +1,294 @@
+#include "resolver.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "core/semantic/typing.h"
+
+namespace bearlang {
+
+namespace {
+
+class Resolver {
+public:
+    Resolver() {
+        scopes_.emplace_back();
+    }
+
+    ResolvedProgram resolve(const Program& program) {
+        ResolvedProgram result;
+        result.actions = resolveStatements(program.statements);
+        result.slotCount = slotCount_;
+        return result;
+    }
+
+private:
+    struct Binding {
+        std::size_t slot;
+        ValueType type;
+    };
+
+    const Binding& lookup(const std::string& name) const {
+        for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) {
+                return found->second;
+            }
+        }
+        throw RuntimeError("Неизвестная переменная '" + name + "'");
+    }
+
+    std::size_t declare(const std::string& name, ValueType type) {
+        std::size_t slot = nextSlot_++;
+        slotCount_ = std::max(slotCount_, nextSlot_);
+        scopes_.back()[name] = Binding{slot, type};
+        return slot;
+    }
+
+    void pushScope() {
+        scopes_.emplace_back();
+        scopeStarts_.push_back(nextSlot_);
+    }
+
+    void popScope() {
+        scopes_.pop_back();
+        nextSlot_ = scopeStarts_.back();
+        scopeStarts_.pop_back();
+    }
+
+    std::vector<Action> resolveStatements(const std::vector<StmtPtr>& statements) {
+        std::vector<Action> actions;
+        actions.reserve(statements.size());
+        for (const auto& stmt : statements) {
+            actions.push_back(resolveStatement(*stmt));
+        }
+        return actions;
+    }
+
+    std::vector<Action> resolveBlock(const std::vector<StmtPtr>& statements) {
+        pushScope();
+        std::vector<Action> actions = resolveStatements(statements);
+        popScope();
+        return actions;
+    }
+
+    Action resolveStatement(const Statement& statement) {
+        Action action;
+        switch (statement.kind()) {
+            case StatementKind::VarDecl: {
+                const auto& decl = static_cast<const VarDeclStmt&>(statement);
+                action.kind = ActionKind::Declare;
+                action.type = decl.type;
+                // Declared before the initializer, as in the generated C++.
+                action.slot = declare(decl.name, decl.type);
+                if (decl.initializer) {
+                    action.hasValue = true;
+                    action.convert = typeOf(*decl.initializer) != decl.type;
+                    action.value = resolveExpression(*decl.initializer);
+                }
+                break;
+            }
+            case StatementKind::Assign: {
+                const auto& assign = static_cast<const AssignStmt&>(statement);
+                const Binding& target = lookup(assign.name);
+                action.slot = target.slot;
+                action.type = target.type;
+                action.hasValue = true;
+                if (resolveAppend(*assign.value, assign.name, action)) {
+                    break;
+                }
+                action.kind = ActionKind::Assign;
+                action.convert = typeOf(*assign.value) != target.type;
+                action.value = resolveExpression(*assign.value);
+                break;
+            }
+            case StatementKind::Input: {
+                const auto& input = static_cast<const InputStmt&>(statement);
+                action.kind = ActionKind::Input;
+                action.slot = lookup(input.name).slot;
+                break;
+            }
+            case StatementKind::Output: {
+                const auto& output = static_cast<const OutputStmt&>(statement);
+                action.kind = ActionKind::Output;
+                action.value = resolveExpression(*output.value);
+                break;
+            }
+            case StatementKind::If: {
+                const auto& ifStmt = static_cast<const IfStmt&>(statement);
+                action.kind = ActionKind::If;
+                for (const auto& branch : ifStmt.branches) {
+                    Node condition = resolveExpression(*branch.condition);
+                    action.branches.push_back(
+                        Action::Branch{std::move(condition), resolveBlock(branch.body)});
+                }
+                action.hasElse = ifStmt.hasElse;
+                if (ifStmt.hasElse) {
+                    action.body = resolveBlock(ifStmt.elseBranch);
+                }
+                break;
+            }
+            case StatementKind::While: {
+                const auto& loop = static_cast<const WhileStmt&>(statement);
+                action.kind = ActionKind::While;
+                action.value = resolveExpression(*loop.condition);
+                action.body = resolveBlock(loop.body);
+                break;
+            }
+            case StatementKind::ForRange: {
+                const auto& loop = static_cast<const ForRangeStmt&>(statement);
+                action.kind = ActionKind::For;
+                action.type = loop.type;
+                pushScope();
+                action.slot = declare(loop.name, loop.type);
+                action.convert = typeOf(*loop.from) != loop.type;
+                action.value = resolveExpression(*loop.from);
+                action.bound = resolveExpression(*loop.to);
+                action.body = resolveBlock(loop.body);
+                popScope();
+                break;
+            }
+        }
+        return action;
+    }
+
+    // `s = s + a + b` appends to s in place when no later piece reads s.
+    bool resolveAppend(const Expression& value, const std::string& target, Action& action) {
+        std::vector<const Expression*> pieces;
+        flattenConcat(value, pieces);
+        if (pieces.size() < 2 || !isVariable(*pieces.front(), target)) {
+            return false;
+        }
+        for (std::size_t i = 1; i < pieces.size(); ++i) {
+            if (reads(*pieces[i], target)) {
+                return false;
+            }
+        }
+        action.kind = ActionKind::Append;
+        for (std::size_t i = 1; i < pieces.size(); ++i) {
+            action.pieces.push_back(resolveExpression(*pieces[i]));
+        }
+        return true;
+    }
+
+    static bool isVariable(const Expression& expr, const std::string& name) {
+        return expr.kind() == ExpressionKind::Variable &&
+               static_cast<const VariableExpr&>(expr).name == name;
+    }
+
+    static bool reads(const Expression& expr, const std::string& name) {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return false;
+            case ExpressionKind::Variable:
+                return isVariable(expr, name);
+            case ExpressionKind::Unary:
+                return reads(*static_cast<const UnaryExpr&>(expr).operand, name);
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return reads(*binary.left, name) || reads(*binary.right, name);
+            }
+        }
+        return false;
+    }
+
+    void flattenConcat(const Expression& expr, std::vector<const Expression*>& pieces) const {
+        if (expr.kind() == ExpressionKind::Binary &&
+            static_cast<const BinaryExpr&>(expr).op == "+" && typeOf(expr) == ValueType::String) {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            flattenConcat(*binary.left, pieces);
+            flattenConcat(*binary.right, pieces);
+            return;
+        }
+        pieces.push_back(&expr);
+    }
+
+    ValueType typeOf(const Expression& expr) const {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return static_cast<const LiteralExpr&>(expr).type;
+            case ExpressionKind::Variable:
+                return lookup(static_cast<const VariableExpr&>(expr).name).type;
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                return unaryResultType(unary.op, typeOf(*unary.operand));
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return binaryResultType(binary.op, typeOf(*binary.left), typeOf(*binary.right));
+            }
+        }
+        return ValueType::Unknown;
+    }
+
+    Node resolveExpression(const Expression& expr) {
+        Node node;
+        switch (expr.kind()) {
+            case ExpressionKind::Literal: {
+                const auto& literal = static_cast<const LiteralExpr&>(expr);
+                node.kind = NodeKind::Constant;
+                switch (literal.type) {
+                    // Out-of-range literals wrap, as g++ narrows them to int.
+                    case ValueType::Integer:
+                        node.constant = static_cast<int>(std::stoll(literal.text));
+                        break;
+                    case ValueType::Double: node.constant = std::stod(literal.text); break;
+                    case ValueType::String: node.constant = literal.text; break;
+                    case ValueType::Boolean: node.constant = literal.boolValue; break;
+                    case ValueType::Unknown:
+                    default: throw RuntimeError("Неизвестный литерал '" + literal.text + "'");
+                }
+                break;
+            }
+            case ExpressionKind::Variable:
+                node.kind = NodeKind::Slot;
+                node.slot = lookup(static_cast<const VariableExpr&>(expr).name).slot;
+                break;
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                node.kind = NodeKind::Unary;
+                node.unaryOp = unaryOpFromSpelling(unary.op);
+                node.operands.push_back(resolveExpression(*unary.operand));
+                break;
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                if (binary.op == "+" && typeOf(expr) == ValueType::String) {
+                    // One buffer for the whole chain instead of a temporary per `+`.
+                    node.kind = NodeKind::Concat;
+                    std::vector<const Expression*> pieces;
+                    flattenConcat(expr, pieces);
+                    for (const Expression* piece : pieces) {
+                        node.operands.push_back(resolveExpression(*piece));
+                    }
+                    break;
+                }
+                if (binary.op == "&&" || binary.op == "||") {
+                    node.kind = binary.op == "&&" ? NodeKind::And : NodeKind::Or;
+                } else {
+                    node.kind = NodeKind::Binary;
+                    node.binaryOp = binaryOpFromSpelling(binary.op);
+                }
+                node.operands.push_back(resolveExpression(*binary.left));
+                node.operands.push_back(resolveExpression(*binary.right));
+                break;
+            }
+        }
+        return node;
+    }
+
+    std::vector<std::unordered_map<std::string, Binding>> scopes_;
+    std::vector<std::size_t> scopeStarts_;
+    std::size_t nextSlot_ = 0;
+    std::size_t slotCount_ = 0;
+};
+
+}  // namespace
+
+ResolvedProgram resolveProgram(const Program& program) {
+    Resolver resolver;
+    return resolver.resolve(program);
+}
+
+}  // namespace bearlang
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "core/parser/ast.h"
+#include "value.h"
+
+namespace bearlang {
+
+// The AST with every name replaced by a slot index, literals parsed and
+// operators decoded. Built once per run, so execution never looks up a name,
+// re-parses a number or compares operator strings.
+enum class NodeKind : unsigned char { Constant, Slot, Unary, Binary, And, Or, Concat };
+
+struct Node {
+    NodeKind kind = NodeKind::Constant;
+    UnaryOp unaryOp = UnaryOp::Negate;
+    BinaryOp binaryOp = BinaryOp::Add;
+    std::size_t slot = 0;
+    Value constant;
+    // One child for Unary, two for Binary / And / Or, the pieces of a string
+    // `+` chain for Concat.
+    std::vector<Node> operands;
+};
+
+enum class ActionKind : unsigned char { Declare, Assign, Append, Input, Output, If, While, For };
+
+struct Action {
+    struct Branch {
+        Node condition;
+        std::vector<Action> body;
+    };
+
+    ActionKind kind = ActionKind::Output;
+    // Variable written by Declare / Assign / Append / Input, counter of For.
+    std::size_t slot = 0;
+    ValueType type = ValueType::Unknown;
+    // The stored value needs convertValue, e.g. `целое x = 2.7`.
+    bool convert = false;
+    bool hasValue = false;
+    // Initializer, assigned value, output, loop condition or start of `для`.
+    Node value;
+    // Upper bound of `для`, re-evaluated on every iteration.
+    Node bound;
+    // Strings appended in place by `s = s + ...`.
+    std::vector<Node> pieces;
+    std::vector<Branch> branches;
+    // Body of a loop, `иначе` branch of an If.
+    std::vector<Action> body;
+    bool hasElse = false;
+};
+
+struct ResolvedProgram {
+    std::vector<Action> actions;
+    std::size_t slotCount = 0;
+};
+
+// Slots follow block structure: a block's variables are released when it
+// ends and reused by the next block. The program must have passed
+// checkProgram.
+ResolvedProgram resolveProgram(const Program& program);
+
+}  // namespace bearlang
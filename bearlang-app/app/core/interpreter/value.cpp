@@ -0,0 +1,252 @@
+#include "value.h"
+
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+#include "core/semantic/typing.h"
+
+namespace bearlang {
+
+static_assert(sizeof(Value) == 8, "Value must stay one machine word");
+
+Value::Value(double value) noexcept {
+    if (std::isnan(value)) {
+        bits_ = std::signbit(value) ? 0xFFF8000000000000ull : 0x7FF8000000000000ull;
+    } else {
+        std::memcpy(&bits_, &value, sizeof(value));
+    }
+}
+
+// Heap addresses fit in the 48 bits below the tag on x86-64 and AArch64.
+Value::Value(std::string value)
+    : bits_(kStringTag | reinterpret_cast<std::uintptr_t>(new StringBox{std::move(value), 1})) {}
+
+double Value::number() const {
+    double value;
+    std::memcpy(&value, &bits_, sizeof(value));
+    return value;
+}
+
+std::string& Value::mutableString() {
+    if (box()->references > 1) {
+        *this = Value(box()->text);
+    }
+    return box()->text;
+}
+
+namespace {
+
+[[noreturn]] void typeMismatch(BinaryOp op, const Value& left, const Value& right) {
+    throw RuntimeError(std::string("Операция '") + spelling(op) + "' не применима к типам " +
+                       typeName(typeOf(left)) + " и " + typeName(typeOf(right)));
+}
+
+double asDouble(const Value& value) {
+    if (value.isInt()) return value.integer();
+    if (value.isDouble()) return value.number();
+    if (value.isBool()) return value.boolean() ? 1.0 : 0.0;
+    throw RuntimeError("Ожидается число, а не строка");
+}
+
+int asInt(const Value& value) {
+    if (value.isInt()) return value.integer();
+    if (value.isDouble()) return static_cast<int>(value.number());
+    if (value.isBool()) return value.boolean() ? 1 : 0;
+    throw RuntimeError("Ожидается число, а не строка");
+}
+
+template <typename T>
+bool compare(BinaryOp op, const T& a, const T& b) {
+    switch (op) {
+        case BinaryOp::Eq: return a == b;
+        case BinaryOp::Lt: return a < b;
+        case BinaryOp::Le: return a <= b;
+        case BinaryOp::Gt: return a > b;
+        case BinaryOp::Ge: return a >= b;
+        default: return false;
+    }
+}
+
+bool isComparison(BinaryOp op) {
+    return op == BinaryOp::Eq || op == BinaryOp::Lt || op == BinaryOp::Le || op == BinaryOp::Gt ||
+           op == BinaryOp::Ge;
+}
+
+// Both operands `int`: the common case in loops and counters.
+Value applyIntBinary(BinaryOp op, int a, int b) {
+    switch (op) {
+        case BinaryOp::Add: return wrapAdd(a, b);
+        case BinaryOp::Sub: return wrapSub(a, b);
+        case BinaryOp::Mul: return wrapMul(a, b);
+        case BinaryOp::Div: return divideInts(a, b);
+        case BinaryOp::Mod: return moduloInts(a, b);
+        case BinaryOp::Pow: return std::pow(static_cast<double>(a), static_cast<double>(b));
+        default: return compare(op, a, b);
+    }
+}
+
+}  // namespace
+
+ValueType typeOf(const Value& value) {
+    if (value.isInt()) return ValueType::Integer;
+    if (value.isDouble()) return ValueType::Double;
+    if (value.isString()) return ValueType::String;
+    return ValueType::Boolean;
+}
+
+Value defaultValue(ValueType type) {
+    switch (type) {
+        case ValueType::Double: return 0.0;
+        case ValueType::String: return std::string();
+        case ValueType::Boolean: return false;
+        case ValueType::Integer:
+        case ValueType::Unknown:
+        default: return 0;
+    }
+}
+
+Value convertValue(const Value& value, ValueType target) {
+    if (typeOf(value) == target) {
+        return value;
+    }
+    switch (target) {
+        case ValueType::Integer: return asInt(value);
+        case ValueType::Double: return asDouble(value);
+        case ValueType::Boolean: return truthy(value);
+        case ValueType::String:
+            throw RuntimeError("Нельзя присвоить значение типа " + typeName(typeOf(value)) +
+                               " строке");
+        case ValueType::Unknown:
+        default: return value;
+    }
+}
+
+bool truthy(const Value& value) {
+    if (value.isInt()) return value.integer() != 0;
+    if (value.isBool()) return value.boolean();
+    if (value.isDouble()) return value.number() != 0.0;
+    throw RuntimeError("Строка не может быть условием");
+}
+
+UnaryOp unaryOpFromSpelling(const std::string& op) {
+    return op == "!" ? UnaryOp::Not : UnaryOp::Negate;
+}
+
+BinaryOp binaryOpFromSpelling(const std::string& op) {
+    if (op == "+") return BinaryOp::Add;
+    if (op == "-") return BinaryOp::Sub;
+    if (op == "*") return BinaryOp::Mul;
+    if (op == "/") return BinaryOp::Div;
+    if (op == "%") return BinaryOp::Mod;
+    if (op == "^") return BinaryOp::Pow;
+    if (op == "==") return BinaryOp::Eq;
+    if (op == "<") return BinaryOp::Lt;
+    if (op == "<=") return BinaryOp::Le;
+    if (op == ">") return BinaryOp::Gt;
+    if (op == ">=") return BinaryOp::Ge;
+    throw RuntimeError("Неизвестная операция '" + op + "'");
+}
+
+const char* spelling(BinaryOp op) {
+    switch (op) {
+        case BinaryOp::Add: return "+";
+        case BinaryOp::Sub: return "-";
+        case BinaryOp::Mul: return "*";
+        case BinaryOp::Div: return "/";
+        case BinaryOp::Mod: return "%";
+        case BinaryOp::Pow: return "^";
+        case BinaryOp::Eq: return "==";
+        case BinaryOp::Lt: return "<";
+        case BinaryOp::Le: return "<=";
+        case BinaryOp::Gt: return ">";
+        case BinaryOp::Ge: return ">=";
+    }
+    return "?";
+}
+
+Value applyUnary(UnaryOp op, const Value& operand) {
+    if (op == UnaryOp::Not) {
+        return !truthy(operand);
+    }
+    if (operand.isDouble()) {
+        return -operand.number();
+    }
+    return wrapNeg(asInt(operand));
+}
+
+Value applyBinary(BinaryOp op, const Value& left, const Value& right) {
+    if (Value::bothInts(left, right)) {
+        return applyIntBinary(op, left.integer(), right.integer());
+    }
+
+    bool leftString = left.isString();
+    bool rightString = right.isString();
+    if (leftString || rightString) {
+        if (!leftString || !rightString) {
+            typeMismatch(op, left, right);
+        }
+        const auto& a = left.string();
+        const auto& b = right.string();
+        if (op == BinaryOp::Add) {
+            return a + b;
+        }
+        if (!isComparison(op)) {
+            typeMismatch(op, left, right);
+        }
+        return compare(op, a, b);
+    }
+
+    bool isDouble = left.isDouble() || right.isDouble();
+    if (isDouble && op == BinaryOp::Mod) {
+        typeMismatch(op, left, right);
+    }
+    if (!isDouble && op != BinaryOp::Pow) {
+        return applyIntBinary(op, asInt(left), asInt(right));
+    }
+    double a = asDouble(left);
+    double b = asDouble(right);
+    switch (op) {
+        case BinaryOp::Add: return a + b;
+        case BinaryOp::Sub: return a - b;
+        case BinaryOp::Mul: return a * b;
+        case BinaryOp::Div: return a / b;
+        case BinaryOp::Pow: return std::pow(a, b);
+        default: return compare(op, a, b);
+    }
+}
+
+void writeValue(std::ostream& out, const Value& value) {
+    if (value.isInt()) {
+        out << value.integer();
+    } else if (value.isDouble()) {
+        out << value.number();
+    } else if (value.isString()) {
+        out << value.string();
+    } else {
+        out << value.boolean();
+    }
+}
+
+// Reads into a copy of the current value, so a read on a failed stream keeps
+// it, as `std::cin >> v` does.
+void readValue(std::istream& in, Value& value) {
+    if (value.isInt()) {
+        int v = value.integer();
+        in >> v;
+        value = v;
+    } else if (value.isDouble()) {
+        double v = value.number();
+        in >> v;
+        value = v;
+    } else if (value.isString()) {
+        in >> value.mutableString();
+    } else {
+        bool v = value.boolean();
+        in >> v;
+        value = v;
+    }
+}
+
+}  // namespace bearlang
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+class RuntimeError : public std::runtime_error {
+public:
+    explicit RuntimeError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// A BearLang value as the generated C++ holds it: int, double, std::string or
+// bool, NaN-boxed into 64 bits. A double is stored as its own bits, with NaN
+// payloads dropped (the sign is kept: it shows in the output as `-nan`).
+// Everything else lives in the quiet-NaN space no double then uses: the top
+// 16 bits are a tag, the low 48 the int, the bool or a string pointer.
+//
+// Strings are shared between copies and counted, not atomically: a value
+// belongs to one run. mutableString() copies a shared string first.
+class Value {
+public:
+    Value() noexcept : bits_(kIntTag) {}
+    Value(int value) noexcept : bits_(kIntTag | static_cast<std::uint32_t>(value)) {}
+    Value(bool value) noexcept : bits_(kBoolTag | (value ? 1u : 0u)) {}
+    Value(double value) noexcept;
+    Value(std::string value);
+    Value(const char* value) : Value(std::string(value)) {}
+
+    Value(const Value& other) noexcept : bits_(other.bits_) { retain(); }
+    Value(Value&& other) noexcept : bits_(other.bits_) { other.bits_ = kIntTag; }
+    Value& operator=(const Value& other) noexcept {
+        Value copy(other);
+        std::swap(bits_, copy.bits_);
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        std::swap(bits_, other.bits_);
+        return *this;
+    }
+    ~Value() { release(); }
+
+    bool isInt() const { return (bits_ & kTagMask) == kIntTag; }
+    bool isBool() const { return (bits_ & kTagMask) == kBoolTag; }
+    bool isString() const { return (bits_ & kTagMask) == kStringTag; }
+    bool isDouble() const { return bits_ < kFirstTag; }
+
+    // One mask for both operands: the loop counters and arithmetic case.
+    static bool bothInts(const Value& a, const Value& b) {
+        return (((a.bits_ ^ kIntTag) | (b.bits_ ^ kIntTag)) & kUpperMask) == 0;
+    }
+
+    // The accessors require the matching is*() to hold.
+    int integer() const { return static_cast<int>(static_cast<std::uint32_t>(bits_)); }
+    bool boolean() const { return (bits_ & 1) != 0; }
+    double number() const;
+    const std::string& string() const { return box()->text; }
+    std::string& mutableString();
+
+private:
+    struct StringBox {
+        std::string text;
+        std::size_t references;
+    };
+
+    static constexpr std::uint64_t kTagMask = 0xFFFF000000000000ull;
+    static constexpr std::uint64_t kUpperMask = 0xFFFFFFFF00000000ull;
+    // 0xFFF8... is the canonical negative NaN, so tags start one above it.
+    static constexpr std::uint64_t kFirstTag = 0xFFF9000000000000ull;
+    static constexpr std::uint64_t kIntTag = 0xFFF9000000000000ull;
+    static constexpr std::uint64_t kBoolTag = 0xFFFA000000000000ull;
+    static constexpr std::uint64_t kStringTag = 0xFFFB000000000000ull;
+
+    StringBox* box() const {
+        return reinterpret_cast<StringBox*>(static_cast<std::uintptr_t>(bits_ & ~kTagMask));
+    }
+    void retain() const {
+        if (isString()) {
+            ++box()->references;
+        }
+    }
+    void release() {
+        if (isString() && --box()->references == 0) {
+            delete box();
+        }
+    }
+
+    std::uint64_t bits_;
+};
+
+ValueType typeOf(const Value& value);
+Value defaultValue(ValueType type);
+
+// Implicit conversion applied when a value is stored into a variable of the
+// given type, e.g. `целое x = 2.7` keeps 2.
+Value convertValue(const Value& value, ValueType target);
+bool truthy(const Value& value);
+
+// Operators other than the short-circuiting `&&` / `||`, decoded once from
+// the C++ spelling the parser stores so evaluation never compares strings.
+enum class UnaryOp : unsigned char { Negate, Not };
+enum class BinaryOp : unsigned char { Add, Sub, Mul, Div, Mod, Pow, Eq, Lt, Le, Gt, Ge };
+
+UnaryOp unaryOpFromSpelling(const std::string& op);
+BinaryOp binaryOpFromSpelling(const std::string& op);
+const char* spelling(BinaryOp op);
+
+Value applyUnary(UnaryOp op, const Value& operand);
+Value applyBinary(BinaryOp op, const Value& left, const Value& right);
+
+// Same formatting and parsing as `std::cout << v` / `std::cin >> v` on the
+// underlying C++ type, including the stream state after a failed read.
+void writeValue(std::ostream& out, const Value& value);
+void readValue(std::istream& in, Value& value);
+
+// `int` arithmetic of the generated program. Overflow wraps like the x86
+// instructions g++ emits; division faults become RuntimeError instead of SIGFPE.
+inline int wrapAdd(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b));
+}
+
+inline int wrapSub(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b));
+}
+
+inline int wrapMul(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+}
+
+inline int wrapNeg(int a) {
+    return static_cast<int>(0u - static_cast<unsigned>(a));
+}
+
+inline void checkIntDivisor(int a, int b) {
+    if (b == 0) {
+        throw RuntimeError("Деление на ноль");
+    }
+    if (a == INT_MIN && b == -1) {
+        throw RuntimeError("Переполнение при делении");
+    }
+}
+
+inline int divideInts(int a, int b) {
+    checkIntDivisor(a, b);
+    return a / b;
+}
+
+inline int moduloInts(int a, int b) {
+    checkIntDivisor(a, b);
+    return a % b;
+}
+
+}  // namespace bearlang
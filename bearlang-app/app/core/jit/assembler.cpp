@@ -0,0 +1,303 @@
+#include "assembler.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace bearlang {
+
+namespace {
+
+int number(Gpr reg) {
+    return static_cast<int>(reg);
+}
+
+int number(Xmm reg) {
+    return static_cast<int>(reg);
+}
+
+}  // namespace
+
+Label X64Assembler::newLabel() {
+    labels_.push_back(-1);
+    return Label{labels_.size() - 1};
+}
+
+void X64Assembler::bind(Label label) {
+    labels_[label.id] = static_cast<std::int64_t>(code_.size());
+}
+
+void X64Assembler::finish() {
+    for (const Fixup& fixup : fixups_) {
+        std::int64_t target = labels_[fixup.label];
+        if (target < 0) {
+            throw std::logic_error("JIT: unbound label");
+        }
+        auto offset = static_cast<std::int32_t>(target - static_cast<std::int64_t>(fixup.at + 4));
+        std::memcpy(code_.data() + fixup.at, &offset, sizeof(offset));
+    }
+    fixups_.clear();
+}
+
+void X64Assembler::byte(std::uint8_t value) {
+    code_.push_back(value);
+}
+
+void X64Assembler::dword(std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        byte(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+}
+
+void X64Assembler::encode(std::uint8_t prefix,
+                          bool wide,
+                          std::initializer_list<std::uint8_t> opcode,
+                          int reg,
+                          int rm) {
+    if (prefix) {
+        byte(prefix);
+    }
+    std::uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg >> 3) << 2) | (rm >> 3);
+    if (rex != 0x40) {
+        byte(rex);
+    }
+    for (std::uint8_t b : opcode) {
+        byte(b);
+    }
+    byte(static_cast<std::uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+void X64Assembler::encode(std::uint8_t prefix,
+                          bool wide,
+                          std::initializer_list<std::uint8_t> opcode,
+                          int reg,
+                          Mem rm) {
+    int base = number(rm.base);
+    if (prefix) {
+        byte(prefix);
+    }
+    std::uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg >> 3) << 2) | (base >> 3);
+    if (rex != 0x40) {
+        byte(rex);
+    }
+    for (std::uint8_t b : opcode) {
+        byte(b);
+    }
+    // mod=10: [base + disp32]; rsp and r12 as base need a SIB byte.
+    byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+    if ((base & 7) == 4) {
+        byte(0x24);
+    }
+    dword(static_cast<std::uint32_t>(rm.disp));
+}
+
+void X64Assembler::rel32(Label target) {
+    fixups_.push_back(Fixup{code_.size(), target.id});
+    dword(0);
+}
+
+void X64Assembler::mov(Gpr dst, Gpr src) {
+    encode(0, false, {0x8B}, number(dst), number(src));
+}
+
+void X64Assembler::mov(Gpr dst, Mem src) {
+    encode(0, false, {0x8B}, number(dst), src);
+}
+
+void X64Assembler::mov(Mem dst, Gpr src) {
+    encode(0, false, {0x89}, number(src), dst);
+}
+
+void X64Assembler::mov(Gpr dst, std::int32_t imm) {
+    if (number(dst) >= 8) {
+        byte(0x41);
+    }
+    byte(static_cast<std::uint8_t>(0xB8 + (number(dst) & 7)));
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::mov(Mem dst, std::int32_t imm) {
+    encode(0, false, {0xC7}, 0, dst);
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::mov64(Gpr dst, Gpr src) {
+    encode(0, true, {0x8B}, number(dst), number(src));
+}
+
+void X64Assembler::mov64(Gpr dst, Mem src) {
+    encode(0, true, {0x8B}, number(dst), src);
+}
+
+void X64Assembler::mov64(Mem dst, Gpr src) {
+    encode(0, true, {0x89}, number(src), dst);
+}
+
+void X64Assembler::mov64(Gpr dst, std::uint64_t imm) {
+    byte(static_cast<std::uint8_t>(0x48 | (number(dst) >> 3)));
+    byte(static_cast<std::uint8_t>(0xB8 + (number(dst) & 7)));
+    dword(static_cast<std::uint32_t>(imm));
+    dword(static_cast<std::uint32_t>(imm >> 32));
+}
+
+// The r, r/m form of the group is 8 * digit + 3.
+void X64Assembler::alu(Alu op, Gpr dst, Gpr src) {
+    encode(0, false, {static_cast<std::uint8_t>(8 * static_cast<int>(op) + 3)}, number(dst), number(src));
+}
+
+void X64Assembler::alu(Alu op, Gpr dst, Mem src) {
+    encode(0, false, {static_cast<std::uint8_t>(8 * static_cast<int>(op) + 3)}, number(dst), src);
+}
+
+void X64Assembler::alu(Alu op, Gpr dst, std::int32_t imm) {
+    encode(0, false, {0x81}, static_cast<int>(op), number(dst));
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::alu(Alu op, Mem dst, std::int32_t imm) {
+    encode(0, false, {0x81}, static_cast<int>(op), dst);
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::sub64(Gpr dst, std::int32_t imm) {
+    encode(0, true, {0x81}, static_cast<int>(Alu::Sub), number(dst));
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::add64(Gpr dst, std::int32_t imm) {
+    encode(0, true, {0x81}, static_cast<int>(Alu::Add), number(dst));
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::imul(Gpr dst, Gpr src) {
+    encode(0, false, {0x0F, 0xAF}, number(dst), number(src));
+}
+
+void X64Assembler::imul(Gpr dst, Mem src) {
+    encode(0, false, {0x0F, 0xAF}, number(dst), src);
+}
+
+void X64Assembler::imul(Gpr dst, Gpr src, std::int32_t imm) {
+    encode(0, false, {0x69}, number(dst), number(src));
+    dword(static_cast<std::uint32_t>(imm));
+}
+
+void X64Assembler::neg(Gpr reg) {
+    encode(0, false, {0xF7}, 3, number(reg));
+}
+
+void X64Assembler::cdq() {
+    byte(0x99);
+}
+
+void X64Assembler::idiv(Gpr divisor) {
+    encode(0, false, {0xF7}, 7, number(divisor));
+}
+
+void X64Assembler::test(Gpr a, Gpr b) {
+    encode(0, false, {0x85}, number(b), number(a));
+}
+
+void X64Assembler::setcc(Cond cond, Gpr dst) {
+    encode(0, false, {0x0F, static_cast<std::uint8_t>(0x90 + static_cast<int>(cond))}, 0, number(dst));
+}
+
+void X64Assembler::movzxByte(Gpr dst, Gpr src) {
+    encode(0, false, {0x0F, 0xB6}, number(dst), number(src));
+}
+
+void X64Assembler::btc64(Gpr reg, std::uint8_t bit) {
+    encode(0, true, {0x0F, 0xBA}, 7, number(reg));
+    byte(bit);
+}
+
+// movaps copies the whole register and has no dependency on the destination.
+void X64Assembler::movsd(Xmm dst, Xmm src) {
+    encode(0, false, {0x0F, 0x28}, number(dst), number(src));
+}
+
+void X64Assembler::movsd(Xmm dst, Mem src) {
+    encode(0xF2, false, {0x0F, 0x10}, number(dst), src);
+}
+
+void X64Assembler::movsd(Mem dst, Xmm src) {
+    encode(0xF2, false, {0x0F, 0x11}, number(src), dst);
+}
+
+void X64Assembler::sse(Sse op, Xmm dst, Xmm src) {
+    encode(0xF2, false, {0x0F, static_cast<std::uint8_t>(op)}, number(dst), number(src));
+}
+
+void X64Assembler::sse(Sse op, Xmm dst, Mem src) {
+    encode(0xF2, false, {0x0F, static_cast<std::uint8_t>(op)}, number(dst), src);
+}
+
+void X64Assembler::ucomisd(Xmm a, Xmm b) {
+    encode(0x66, false, {0x0F, 0x2E}, number(a), number(b));
+}
+
+void X64Assembler::ucomisd(Xmm a, Mem b) {
+    encode(0x66, false, {0x0F, 0x2E}, number(a), b);
+}
+
+void X64Assembler::xorpd(Xmm dst, Xmm src) {
+    encode(0x66, false, {0x0F, 0x57}, number(dst), number(src));
+}
+
+void X64Assembler::cvtsi2sd(Xmm dst, Gpr src) {
+    encode(0xF2, false, {0x0F, 0x2A}, number(dst), number(src));
+}
+
+void X64Assembler::cvtsi2sd(Xmm dst, Mem src) {
+    encode(0xF2, false, {0x0F, 0x2A}, number(dst), src);
+}
+
+void X64Assembler::cvttsd2si(Gpr dst, Xmm src) {
+    encode(0xF2, false, {0x0F, 0x2C}, number(dst), number(src));
+}
+
+void X64Assembler::cvttsd2si(Gpr dst, Mem src) {
+    encode(0xF2, false, {0x0F, 0x2C}, number(dst), src);
+}
+
+void X64Assembler::movq(Xmm dst, Gpr src) {
+    encode(0x66, true, {0x0F, 0x6E}, number(dst), number(src));
+}
+
+void X64Assembler::movq(Gpr dst, Xmm src) {
+    encode(0x66, true, {0x0F, 0x7E}, number(src), number(dst));
+}
+
+void X64Assembler::push(Gpr reg) {
+    if (number(reg) >= 8) {
+        byte(0x41);
+    }
+    byte(static_cast<std::uint8_t>(0x50 + (number(reg) & 7)));
+}
+
+void X64Assembler::pop(Gpr reg) {
+    if (number(reg) >= 8) {
+        byte(0x41);
+    }
+    byte(static_cast<std::uint8_t>(0x58 + (number(reg) & 7)));
+}
+
+void X64Assembler::call(Gpr target) {
+    encode(0, false, {0xFF}, 2, number(target));
+}
+
+void X64Assembler::ret() {
+    byte(0xC3);
+}
+
+void X64Assembler::jmp(Label target) {
+    byte(0xE9);
+    rel32(target);
+}
+
+void X64Assembler::jcc(Cond cond, Label target) {
+    byte(0x0F);
+    byte(static_cast<std::uint8_t>(0x80 + static_cast<int>(cond)));
+    rel32(target);
+}
+
+}  // namespace bearlang
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace bearlang {
+
+// Just enough of x86-64 for the JIT: 32-bit integer arithmetic, SSE2 scalar
+// doubles, [base + disp32] memory operands and rel32 jumps to labels.
+enum class Gpr : std::uint8_t { Rax, Rcx, Rdx, Rbx, Rsp, Rbp, Rsi, Rdi, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+enum class Xmm : std::uint8_t {
+    X0, X1, X2, X3, X4, X5, X6, X7, X8, X9, X10, X11, X12, X13, X14, X15
+};
+
+struct Mem {
+    Gpr base;
+    std::int32_t disp;
+};
+
+// Condition codes as encoded in Jcc / SETcc.
+enum class Cond : std::uint8_t {
+    Below = 0x2,
+    AboveEqual = 0x3,
+    Equal = 0x4,
+    NotEqual = 0x5,
+    Above = 0x7,
+    Parity = 0xA,
+    NoParity = 0xB,
+    Less = 0xC,
+    GreaterEqual = 0xD,
+    LessEqual = 0xE,
+    Greater = 0xF,
+};
+
+// The /digit of the 0x81 group; also selects the r, r/m opcode.
+enum class Alu : std::uint8_t { Add = 0, Or = 1, And = 4, Sub = 5, Xor = 6, Cmp = 7 };
+
+enum class Sse : std::uint8_t { Add = 0x58, Mul = 0x59, Sub = 0x5C, Div = 0x5E };
+
+struct Label {
+    std::size_t id;
+};
+
+class X64Assembler {
+public:
+    const std::vector<std::uint8_t>& code() const { return code_; }
+
+    Label newLabel();
+    void bind(Label label);
+    // Resolves every jump; call once, after all labels are bound.
+    void finish();
+
+    // Integer moves and arithmetic, 32-bit unless marked 64.
+    void mov(Gpr dst, Gpr src);
+    void mov(Gpr dst, Mem src);
+    void mov(Mem dst, Gpr src);
+    void mov(Gpr dst, std::int32_t imm);
+    void mov(Mem dst, std::int32_t imm);
+    void mov64(Gpr dst, Gpr src);
+    void mov64(Gpr dst, Mem src);
+    void mov64(Mem dst, Gpr src);
+    void mov64(Gpr dst, std::uint64_t imm);
+    void alu(Alu op, Gpr dst, Gpr src);
+    void alu(Alu op, Gpr dst, Mem src);
+    void alu(Alu op, Gpr dst, std::int32_t imm);
+    void alu(Alu op, Mem dst, std::int32_t imm);
+    void sub64(Gpr dst, std::int32_t imm);
+    void add64(Gpr dst, std::int32_t imm);
+    void imul(Gpr dst, Gpr src);
+    void imul(Gpr dst, Mem src);
+    void imul(Gpr dst, Gpr src, std::int32_t imm);
+    void neg(Gpr reg);
+    void cdq();
+    void idiv(Gpr divisor);
+    void test(Gpr a, Gpr b);
+    // Low byte of rax..rbx only, so no REX prefix is needed.
+    void setcc(Cond cond, Gpr dst);
+    void movzxByte(Gpr dst, Gpr src);
+    void btc64(Gpr reg, std::uint8_t bit);
+
+    // SSE2 scalar doubles.
+    void movsd(Xmm dst, Xmm src);
+    void movsd(Xmm dst, Mem src);
+    void movsd(Mem dst, Xmm src);
+    void sse(Sse op, Xmm dst, Xmm src);
+    void sse(Sse op, Xmm dst, Mem src);
+    void ucomisd(Xmm a, Xmm b);
+    void ucomisd(Xmm a, Mem b);
+    void xorpd(Xmm dst, Xmm src);
+    void cvtsi2sd(Xmm dst, Gpr src);
+    void cvtsi2sd(Xmm dst, Mem src);
+    void cvttsd2si(Gpr dst, Xmm src);
+    void cvttsd2si(Gpr dst, Mem src);
+    void movq(Xmm dst, Gpr src);
+    void movq(Gpr dst, Xmm src);
+
+    void push(Gpr reg);
+    void pop(Gpr reg);
+    void call(Gpr target);
+    void ret();
+    void jmp(Label target);
+    void jcc(Cond cond, Label target);
+
+private:
+    void byte(std::uint8_t value);
+    void dword(std::uint32_t value);
+    // [prefix] [REX] opcode ModRM, with a register or memory r/m operand.
+    void encode(std::uint8_t prefix, bool wide, std::initializer_list<std::uint8_t> opcode, int reg,
+                int rm);
+    void encode(std::uint8_t prefix, bool wide, std::initializer_list<std::uint8_t> opcode, int reg,
+                Mem rm);
+    void rel32(Label target);
+
+    struct Fixup {
+        std::size_t at;
+        std::size_t label;
+    };
+
+    std::vector<std::uint8_t> code_;
+    std::vector<std::int64_t> labels_;
+    std::vector<Fixup> fixups_;
+};
+
+}  // namespace bearlang
@@ -0,0 +1,1072 @@
+#include "jit.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define BEARLANG_JIT_X64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define BEARLANG_JIT_X64 0
+#endif
+
+#include "assembler.h"
+#include "core/interpreter/value.h"
+#include "core/vm/compiler.h"
+#include "core/vm/typed_ops.h"
+#include "core/vm/vm.h"
+
+namespace bearlang {
+
+namespace {
+
+#if BEARLANG_JIT_X64
+
+// What the machine code reaches through its first argument.
+struct Runtime {
+    const Chunk* chunk;
+    NumericSlot* n;
+    std::string* s;
+    std::istream* in;
+    std::ostream* out;
+    bool bufferedOutput;
+    std::exception_ptr failure;
+};
+
+// Runs one instruction the generated code leaves to C++, with the VM's
+// semantics. Exceptions cannot unwind through the generated frames, so they
+// are parked in the runtime and rethrown once the code has returned.
+int runtimeStep(Runtime* rt, int index) noexcept {
+    const Instruction& ins = rt->chunk->code[index];
+    NumericSlot* n = rt->n;
+    std::string* s = rt->s;
+    const std::vector<std::string>& constants = rt->chunk->strings;
+    std::istream& in = *rt->in;
+    std::ostream& out = *rt->out;
+    try {
+        switch (ins.op) {
+            case Op::LoadString: s[ins.a] = constants[ins.b]; break;
+            case Op::MoveStr: s[ins.a] = s[ins.b]; break;
+            case Op::AppendStr: s[ins.a] += s[ins.b]; break;
+            case Op::AppendConst: s[ins.a] += constants[ins.b]; break;
+            case Op::PrintInt: out << n[ins.a].i; break;
+            case Op::PrintDouble: out << n[ins.a].d; break;
+            case Op::PrintStr: out << s[ins.a]; break;
+            case Op::PrintConst: out << constants[ins.a]; break;
+            case Op::PrintNewline:
+                if (rt->bufferedOutput) {
+                    out << '\n';
+                } else {
+                    out << std::endl;
+                }
+                break;
+            case Op::ReadInt:
+                out.flush();
+                in >> n[ins.a].i;
+                break;
+            case Op::ReadDouble:
+                out.flush();
+                in >> n[ins.a].d;
+                break;
+            case Op::ReadStr:
+                out.flush();
+                in >> s[ins.a];
+                break;
+            case Op::ReadBool: {
+                out.flush();
+                bool value = n[ins.a].i != 0;
+                in >> value;
+                n[ins.a].i = value;
+                break;
+            }
+            default:
+                // DivInt, ModInt, PowDouble and the string comparisons.
+                executeTyped(ins, n, s);
+                break;
+        }
+        return 0;
+    } catch (...) {
+        rt->failure = std::current_exception();
+        return 1;
+    }
+}
+
+using EntryPoint = int (*)(Runtime*, NumericSlot*);
+
+// Machine code in its own pages: written while read-write, then switched to
+// read-execute, never both at once.
+class ExecutableCode {
+public:
+    explicit ExecutableCode(const std::vector<std::uint8_t>& code) {
+        long page = ::sysconf(_SC_PAGESIZE);
+        std::size_t pageSize = page > 0 ? static_cast<std::size_t>(page) : 4096;
+        size_ = (code.size() + pageSize - 1) / pageSize * pageSize;
+        void* memory = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        std::memcpy(memory, code.data(), code.size());
+        if (::mprotect(memory, size_, PROT_READ | PROT_EXEC) != 0) {
+            ::munmap(memory, size_);
+            return;
+        }
+        memory_ = memory;
+    }
+
+    ~ExecutableCode() {
+        if (memory_) {
+            ::munmap(memory_, size_);
+        }
+    }
+
+    ExecutableCode(const ExecutableCode&) = delete;
+    ExecutableCode& operator=(const ExecutableCode&) = delete;
+
+    bool valid() const {
+        return memory_ != nullptr;
+    }
+
+    EntryPoint entry() const {
+        return reinterpret_cast<EntryPoint>(memory_);
+    }
+
+private:
+    void* memory_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// How an instruction uses a numeric operand field.
+enum class Use : unsigned char { None, Int, Double, Number };
+
+struct Shape {
+    Use a = Use::None;
+    Use b = Use::None;
+    Use c = Use::None;
+    // Field a is read (otherwise only written, when numeric).
+    bool readsA = false;
+    // Handled by runtimeStep rather than by generated code.
+    bool callsRuntime = false;
+};
+
+Shape shapeOf(Op op) {
+    const Use I = Use::Int;
+    const Use D = Use::Double;
+    const Use N = Use::None;
+    switch (op) {
+        case Op::LoadInt: return Shape{I, N, N, false, false};
+        case Op::LoadDouble: return Shape{D, N, N, false, false};
+        case Op::MoveNum: return Shape{Use::Number, Use::Number, N, false, false};
+        case Op::IntToDouble: return Shape{D, I, N, false, false};
+        case Op::DoubleToInt: return Shape{I, D, N, false, false};
+        case Op::IntToBool:
+        case Op::NegInt:
+        case Op::NotInt:
+            return Shape{I, I, N, false, false};
+        case Op::DoubleToBool:
+        case Op::NotDouble:
+            return Shape{I, D, N, false, false};
+        case Op::AddInt:
+        case Op::SubInt:
+        case Op::MulInt:
+        case Op::EqInt:
+        case Op::LtInt:
+        case Op::LeInt:
+        case Op::GtInt:
+        case Op::GeInt:
+            return Shape{I, I, I, false, false};
+        // The fast path is inline; a zero or -1 divisor goes to the runtime.
+        case Op::DivInt:
+        case Op::ModInt:
+            return Shape{I, I, I, false, false};
+        case Op::AddDouble:
+        case Op::SubDouble:
+        case Op::MulDouble:
+        case Op::DivDouble:
+            return Shape{D, D, D, false, false};
+        case Op::PowDouble: return Shape{D, D, D, false, true};
+        case Op::NegDouble: return Shape{D, D, N, false, false};
+        case Op::EqDouble:
+        case Op::LtDouble:
+        case Op::LeDouble:
+        case Op::GtDouble:
+        case Op::GeDouble:
+            return Shape{I, D, D, false, false};
+        case Op::EqStr:
+        case Op::LtStr:
+        case Op::LeStr:
+        case Op::GtStr:
+        case Op::GeStr:
+            return Shape{I, N, N, false, true};
+        case Op::JumpIfFalse:
+        case Op::JumpIfTrue:
+        case Op::LoopIfTrue:
+            return Shape{I, N, N, true, false};
+        case Op::ForInitInt:
+        case Op::ForLoopInt:
+        case Op::JumpIfLtInt:
+        case Op::JumpIfLeInt:
+        case Op::JumpIfGtInt:
+        case Op::JumpIfGeInt:
+        case Op::JumpIfEqInt:
+        case Op::JumpIfNeInt:
+            return Shape{I, I, N, true, false};
+        case Op::AddIntImm: return Shape{I, I, N, false, false};
+        case Op::PrintInt: return Shape{I, N, N, true, true};
+        case Op::PrintDouble: return Shape{D, N, N, true, true};
+        case Op::ReadInt: return Shape{I, N, N, false, true};
+        case Op::ReadDouble: return Shape{D, N, N, false, true};
+        case Op::ReadBool: return Shape{I, N, N, true, true};
+        case Op::LoadString:
+        case Op::MoveStr:
+        case Op::AppendStr:
+        case Op::AppendConst:
+        case Op::PrintStr:
+        case Op::PrintConst:
+        case Op::PrintNewline:
+        case Op::ReadStr:
+            return Shape{N, N, N, false, true};
+        case Op::Jump:
+        case Op::Halt:
+            return Shape{};
+    }
+    return Shape{};
+}
+
+// `для` steps its counter and `ввод` into a `логика` keeps the old value on
+// failure: both read and write field a.
+bool updatesA(Op op) {
+    return op == Op::ForLoopInt || op == Op::ReadBool;
+}
+
+// Jump target of a branch, -1 for other instructions.
+int branchTarget(const Instruction& ins) {
+    switch (ins.op) {
+        case Op::Jump: return ins.a;
+        case Op::JumpIfFalse:
+        case Op::JumpIfTrue:
+        case Op::LoopIfTrue:
+            return ins.b;
+        case Op::ForInitInt:
+        case Op::ForLoopInt:
+        case Op::JumpIfLtInt:
+        case Op::JumpIfLeInt:
+        case Op::JumpIfGtInt:
+        case Op::JumpIfGeInt:
+        case Op::JumpIfEqInt:
+        case Op::JumpIfNeInt:
+            return ins.c;
+        default:
+            return -1;
+    }
+}
+
+// A set of numeric registers.
+class RegisterSet {
+public:
+    explicit RegisterSet(std::size_t size = 0) : words_((size + 63) / 64) {}
+
+    void insert(int reg) {
+        words_[static_cast<std::size_t>(reg) / 64] |= std::uint64_t{1} << (reg % 64);
+    }
+
+    bool contains(int reg) const {
+        return (words_[static_cast<std::size_t>(reg) / 64] >> (reg % 64)) & 1;
+    }
+
+    void unite(const RegisterSet& other) {
+        for (std::size_t i = 0; i < words_.size(); ++i) {
+            words_[i] |= other.words_[i];
+        }
+    }
+
+    void subtract(const RegisterSet& other) {
+        for (std::size_t i = 0; i < words_.size(); ++i) {
+            words_[i] &= ~other.words_[i];
+        }
+    }
+
+    bool operator==(const RegisterSet& other) const {
+        return words_ == other.words_;
+    }
+
+private:
+    std::vector<std::uint64_t> words_;
+};
+
+enum class LocationKind : unsigned char { Memory, Gpr, Xmm, Constant };
+
+// Where a numeric register lives for its whole live interval: a CPU
+// register, its frame slot, or nowhere at all for an int written only by
+// one LoadInt, whose value is then an immediate operand.
+struct Location {
+    LocationKind kind = LocationKind::Memory;
+    int reg = 0;
+    std::int32_t value = 0;
+};
+
+// The frame pointer lives in r15 and the runtime pointer on the stack; rax,
+// rcx, rdx, xmm0 and xmm1 are scratch.
+const Gpr kFrame = Gpr::R15;
+const Mem kRuntimeSlot{Gpr::Rbp, -48};
+const Gpr kIntPool[] = {Gpr::Rbx, Gpr::R12, Gpr::R13, Gpr::R14, Gpr::R8, Gpr::R9, Gpr::R10, Gpr::R11};
+const Xmm kDoublePool[] = {Xmm::X2, Xmm::X3, Xmm::X4, Xmm::X5, Xmm::X6, Xmm::X7, Xmm::X8, Xmm::X9,
+                           Xmm::X10, Xmm::X11, Xmm::X12, Xmm::X13, Xmm::X14, Xmm::X15};
+
+class Lowering {
+public:
+    explicit Lowering(const Chunk& chunk)
+        : chunk_(chunk), registerCount_(static_cast<int>(chunk.numericSlots) + 1) {}
+
+    std::vector<std::uint8_t> compile() {
+        analyze();
+        allocateRegisters();
+        emitProgram();
+        asm_.finish();
+        return asm_.code();
+    }
+
+private:
+    // Register classes, constants and live intervals.
+    void analyze() {
+        std::size_t count = static_cast<std::size_t>(registerCount_);
+        std::vector<unsigned> classes(count, 0);
+        std::vector<int> writes(count, 0);
+        std::vector<const Instruction*> onlyWrite(count, nullptr);
+        auto mark = [&classes](Use use, int reg) {
+            if (use == Use::Int) {
+                classes[reg] |= 1;
+            } else if (use == Use::Double) {
+                classes[reg] |= 2;
+            }
+        };
+        for (const Instruction& ins : chunk_.code) {
+            Shape shape = shapeOf(ins.op);
+            mark(shape.a, ins.a);
+            mark(shape.b, ins.b);
+            mark(shape.c, ins.c);
+            if (shape.a != Use::None && !shape.readsA) {
+                ++writes[ins.a];
+                onlyWrite[ins.a] = &ins;
+            }
+            if (updatesA(ins.op)) {
+                ++writes[ins.a];
+            }
+        }
+        // MoveNum copies whatever its source holds, so both sides share a class.
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const Instruction& ins : chunk_.code) {
+                if (ins.op == Op::MoveNum && classes[ins.a] != classes[ins.b]) {
+                    classes[ins.a] = classes[ins.b] = classes[ins.a] | classes[ins.b];
+                    changed = true;
+                }
+            }
+        }
+
+        locations_.assign(count, Location{});
+        for (std::size_t reg = 0; reg < count; ++reg) {
+            // Every read of a register follows a write, so an int written by a
+            // single LoadInt always holds that value.
+            if (classes[reg] == 1 && writes[reg] == 1 && onlyWrite[reg]->op == Op::LoadInt) {
+                locations_[reg] = Location{LocationKind::Constant, 0, onlyWrite[reg]->b};
+            }
+        }
+        classes_ = std::move(classes);
+        computeLiveness();
+    }
+
+    void uses(const Instruction& ins, RegisterSet& read, RegisterSet& written) const {
+        Shape shape = shapeOf(ins.op);
+        if (shape.a != Use::None) {
+            if (shape.readsA) {
+                read.insert(ins.a);
+            } else {
+                written.insert(ins.a);
+            }
+        }
+        if (shape.b != Use::None) {
+            read.insert(ins.b);
+        }
+        if (shape.c != Use::None) {
+            read.insert(ins.c);
+        }
+        if (updatesA(ins.op)) {
+            written.insert(ins.a);
+        }
+    }
+
+    // Backward dataflow over the instructions, then each register's interval
+    // is the span from its first to its last live point.
+    void computeLiveness() {
+        std::size_t size = chunk_.code.size();
+        std::vector<RegisterSet> read(size, RegisterSet(registerCount_));
+        std::vector<RegisterSet> written(size, RegisterSet(registerCount_));
+        for (std::size_t i = 0; i < size; ++i) {
+            uses(chunk_.code[i], read[i], written[i]);
+        }
+        std::vector<RegisterSet> liveIn(size, RegisterSet(registerCount_));
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t i = size; i-- > 0;) {
+                const Instruction& ins = chunk_.code[i];
+                RegisterSet live(registerCount_);
+                bool fallsThrough = ins.op != Op::Jump && ins.op != Op::Halt;
+                if (fallsThrough && i + 1 < size) {
+                    live.unite(liveIn[i + 1]);
+                }
+                int target = branchTarget(ins);
+                if (target >= 0 && static_cast<std::size_t>(target) < size) {
+                    live.unite(liveIn[target]);
+                }
+                live.subtract(written[i]);
+                live.unite(read[i]);
+                if (!(live == liveIn[i])) {
+                    liveIn[i] = std::move(live);
+                    changed = true;
+                }
+            }
+        }
+
+        start_.assign(registerCount_, -1);
+        end_.assign(registerCount_, -1);
+        for (std::size_t i = 0; i < size; ++i) {
+            for (int reg = 0; reg < registerCount_; ++reg) {
+                if (liveIn[i].contains(reg) || written[i].contains(reg)) {
+                    if (start_[reg] < 0) {
+                        start_[reg] = static_cast<int>(i);
+                    }
+                    end_[reg] = static_cast<int>(i);
+                }
+            }
+        }
+        liveAtEntry_ = size > 0 ? liveIn[0] : RegisterSet(registerCount_);
+    }
+
+    // Linear scan (Poletto & Sarkar): intervals in order of start; when no
+    // register is free, the interval that ends last stays in memory.
+    void allocateRegisters() {
+        std::vector<int> ints;
+        std::vector<int> doubles;
+        for (int reg = 0; reg < registerCount_; ++reg) {
+            if (start_[reg] < 0 || locations_[reg].kind == LocationKind::Constant) {
+                continue;
+            }
+            if (classes_[reg] == 1) {
+                ints.push_back(reg);
+            } else if (classes_[reg] == 2) {
+                doubles.push_back(reg);
+            }
+        }
+        std::vector<int> intPool;
+        for (Gpr reg : kIntPool) {
+            intPool.push_back(static_cast<int>(reg));
+        }
+        std::vector<int> doublePool;
+        for (Xmm reg : kDoublePool) {
+            doublePool.push_back(static_cast<int>(reg));
+        }
+        linearScan(ints, intPool, LocationKind::Gpr);
+        linearScan(doubles, doublePool, LocationKind::Xmm);
+    }
+
+    void linearScan(std::vector<int> intervals, std::vector<int> free, LocationKind kind) {
+        std::stable_sort(intervals.begin(), intervals.end(),
+                         [this](int a, int b) { return start_[a] < start_[b]; });
+        std::vector<int> active;
+        for (int reg : intervals) {
+            for (auto it = active.begin(); it != active.end();) {
+                if (end_[*it] < start_[reg]) {
+                    free.push_back(locations_[*it].reg);
+                    it = active.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (!free.empty()) {
+                locations_[reg] = Location{kind, free.back(), 0};
+                free.pop_back();
+                active.push_back(reg);
+                continue;
+            }
+            auto longest = std::max_element(active.begin(), active.end(),
+                                            [this](int a, int b) { return end_[a] < end_[b]; });
+            if (longest != active.end() && end_[*longest] > end_[reg]) {
+                locations_[reg] = locations_[*longest];
+                locations_[*longest] = Location{};
+                *longest = reg;
+            }
+        }
+    }
+
+    static Mem slot(int reg) {
+        return Mem{kFrame, reg * static_cast<std::int32_t>(sizeof(NumericSlot))};
+    }
+
+    const Location& at(int reg) const {
+        return locations_[reg];
+    }
+
+    static Gpr gpr(const Location& location) {
+        return static_cast<Gpr>(location.reg);
+    }
+
+    static Xmm xmm(const Location& location) {
+        return static_cast<Xmm>(location.reg);
+    }
+
+    // --- integer operands ---
+
+    void loadInt(Gpr dst, int reg) {
+        const Location& location = at(reg);
+        switch (location.kind) {
+            case LocationKind::Gpr:
+                if (gpr(location) != dst) {
+                    asm_.mov(dst, gpr(location));
+                }
+                break;
+            case LocationKind::Constant: asm_.mov(dst, location.value); break;
+            case LocationKind::Memory:
+            case LocationKind::Xmm:
+                asm_.mov(dst, slot(reg));
+                break;
+        }
+    }
+
+    // The CPU register holding an int operand, loading it into `scratch`
+    // unless it already lives in one.
+    Gpr intOperand(int reg, Gpr scratch) {
+        if (at(reg).kind == LocationKind::Gpr) {
+            return gpr(at(reg));
+        }
+        loadInt(scratch, reg);
+        return scratch;
+    }
+
+    void aluWith(Alu op, Gpr dst, int reg) {
+        const Location& location = at(reg);
+        switch (location.kind) {
+            case LocationKind::Gpr: asm_.alu(op, dst, gpr(location)); break;
+            case LocationKind::Constant: asm_.alu(op, dst, location.value); break;
+            case LocationKind::Memory:
+            case LocationKind::Xmm:
+                asm_.alu(op, dst, slot(reg));
+                break;
+        }
+    }
+
+    void imulWith(Gpr dst, int reg) {
+        const Location& location = at(reg);
+        switch (location.kind) {
+            case LocationKind::Gpr: asm_.imul(dst, gpr(location)); break;
+            case LocationKind::Constant: asm_.imul(dst, dst, location.value); break;
+            case LocationKind::Memory:
+            case LocationKind::Xmm:
+                asm_.imul(dst, slot(reg));
+                break;
+        }
+    }
+
+    void storeInt(int reg, Gpr src) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Gpr) {
+            if (gpr(location) != src) {
+                asm_.mov(gpr(location), src);
+            }
+        } else {
+            asm_.mov(slot(reg), src);
+        }
+    }
+
+    // a = b op c, computed in a's own register when c does not live there.
+    void intArithmetic(const Instruction& ins) {
+        const Location& target = at(ins.a);
+        bool inPlace = target.kind == LocationKind::Gpr &&
+                       !(at(ins.c).kind == LocationKind::Gpr && at(ins.c).reg == target.reg);
+        Gpr dst = inPlace ? gpr(target) : Gpr::Rax;
+        loadInt(dst, ins.b);
+        switch (ins.op) {
+            case Op::AddInt: aluWith(Alu::Add, dst, ins.c); break;
+            case Op::SubInt: aluWith(Alu::Sub, dst, ins.c); break;
+            default: imulWith(dst, ins.c); break;
+        }
+        storeInt(ins.a, dst);
+    }
+
+    void intDivision(std::size_t index, const Instruction& ins) {
+        Gpr result = ins.op == Op::DivInt ? Gpr::Rax : Gpr::Rdx;
+        const Location& divisor = at(ins.c);
+        if (divisor.kind == LocationKind::Constant) {
+            // A known divisor other than 0 and -1 can never fault.
+            if (divisor.value == 0 || divisor.value == -1) {
+                callRuntime(index);
+                return;
+            }
+            loadInt(Gpr::Rax, ins.b);
+            asm_.mov(Gpr::Rcx, divisor.value);
+            asm_.cdq();
+            asm_.idiv(Gpr::Rcx);
+            storeInt(ins.a, result);
+            return;
+        }
+        Label slow = asm_.newLabel();
+        Label done = asm_.newLabel();
+        loadInt(Gpr::Rax, ins.b);
+        loadInt(Gpr::Rcx, ins.c);
+        asm_.test(Gpr::Rcx, Gpr::Rcx);
+        asm_.jcc(Cond::Equal, slow);
+        asm_.alu(Alu::Cmp, Gpr::Rcx, -1);
+        asm_.jcc(Cond::Equal, slow);
+        asm_.cdq();
+        asm_.idiv(Gpr::Rcx);
+        storeInt(ins.a, result);
+        asm_.jmp(done);
+        asm_.bind(slow);
+        callRuntime(index);
+        asm_.bind(done);
+    }
+
+    void intComparison(const Instruction& ins, Cond cond) {
+        Gpr left = intOperand(ins.b, Gpr::Rax);
+        aluWith(Alu::Cmp, left, ins.c);
+        asm_.setcc(cond, Gpr::Rax);
+        asm_.movzxByte(Gpr::Rax, Gpr::Rax);
+        storeInt(ins.a, Gpr::Rax);
+    }
+
+    void intTest(const Instruction& ins, Cond cond) {
+        Gpr value = intOperand(ins.b, Gpr::Rax);
+        asm_.test(value, value);
+        asm_.setcc(cond, Gpr::Rax);
+        asm_.movzxByte(Gpr::Rax, Gpr::Rax);
+        storeInt(ins.a, Gpr::Rax);
+    }
+
+    void compareAndBranch(const Instruction& ins, Cond cond) {
+        Gpr left = intOperand(ins.a, Gpr::Rax);
+        aluWith(Alu::Cmp, left, ins.b);
+        asm_.jcc(cond, labels_[ins.c]);
+    }
+
+    // --- double operands ---
+
+    void loadDouble(Xmm dst, int reg) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Xmm) {
+            if (xmm(location) != dst) {
+                asm_.movsd(dst, xmm(location));
+            }
+        } else {
+            asm_.movsd(dst, slot(reg));
+        }
+    }
+
+    Xmm doubleOperand(int reg, Xmm scratch) {
+        if (at(reg).kind == LocationKind::Xmm) {
+            return xmm(at(reg));
+        }
+        loadDouble(scratch, reg);
+        return scratch;
+    }
+
+    void sseWith(Sse op, Xmm dst, int reg) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Xmm) {
+            asm_.sse(op, dst, xmm(location));
+        } else {
+            asm_.sse(op, dst, slot(reg));
+        }
+    }
+
+    void ucomisdWith(Xmm left, int reg) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Xmm) {
+            asm_.ucomisd(left, xmm(location));
+        } else {
+            asm_.ucomisd(left, slot(reg));
+        }
+    }
+
+    void storeDouble(int reg, Xmm src) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Xmm) {
+            if (xmm(location) != src) {
+                asm_.movsd(xmm(location), src);
+            }
+        } else {
+            asm_.movsd(slot(reg), src);
+        }
+    }
+
+    // Raw bits of a double operand in rax, and back.
+    void loadDoubleBits(int reg) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Xmm) {
+            asm_.movq(Gpr::Rax, xmm(location));
+        } else {
+            asm_.mov64(Gpr::Rax, slot(reg));
+        }
+    }
+
+    void storeDoubleBits(int reg) {
+        const Location& location = at(reg);
+        if (location.kind == LocationKind::Xmm) {
+            asm_.movq(xmm(location), Gpr::Rax);
+        } else {
+            asm_.mov64(slot(reg), Gpr::Rax);
+        }
+    }
+
+    void doubleArithmetic(const Instruction& ins, Sse op) {
+        const Location& target = at(ins.a);
+        bool inPlace = target.kind == LocationKind::Xmm &&
+                       !(at(ins.c).kind == LocationKind::Xmm && at(ins.c).reg == target.reg);
+        Xmm dst = inPlace ? xmm(target) : Xmm::X0;
+        loadDouble(dst, ins.b);
+        sseWith(op, dst, ins.c);
+        storeDouble(ins.a, dst);
+    }
+
+    // ucomisd reports "unordered" (NaN) as ZF = PF = CF = 1, so `<` and
+    // `<=` swap their operands and test "above", and `==` also checks PF.
+    void doubleComparison(const Instruction& ins) {
+        switch (ins.op) {
+            case Op::LtDouble:
+            case Op::LeDouble:
+                ucomisdWith(doubleOperand(ins.c, Xmm::X1), ins.b);
+                asm_.setcc(ins.op == Op::LtDouble ? Cond::Above : Cond::AboveEqual, Gpr::Rax);
+                asm_.movzxByte(Gpr::Rax, Gpr::Rax);
+                break;
+            case Op::GtDouble:
+            case Op::GeDouble:
+                ucomisdWith(doubleOperand(ins.b, Xmm::X0), ins.c);
+                asm_.setcc(ins.op == Op::GtDouble ? Cond::Above : Cond::AboveEqual, Gpr::Rax);
+                asm_.movzxByte(Gpr::Rax, Gpr::Rax);
+                break;
+            default:
+                ucomisdWith(doubleOperand(ins.b, Xmm::X0), ins.c);
+                combineFlags(Cond::Equal, Cond::NoParity, Alu::And);
+                break;
+        }
+        storeInt(ins.a, Gpr::Rax);
+    }
+
+    // Compares b with 0.0: `не x` is "equal and ordered", the truth of x is
+    // "not equal or unordered", as for C++ doubles.
+    void doubleTest(const Instruction& ins) {
+        Xmm value = doubleOperand(ins.b, Xmm::X0);
+        asm_.xorpd(Xmm::X1, Xmm::X1);
+        asm_.ucomisd(value, Xmm::X1);
+        if (ins.op == Op::NotDouble) {
+            combineFlags(Cond::Equal, Cond::NoParity, Alu::And);
+        } else {
+            combineFlags(Cond::NotEqual, Cond::Parity, Alu::Or);
+        }
+        storeInt(ins.a, Gpr::Rax);
+    }
+
+    void combineFlags(Cond first, Cond second, Alu op) {
+        asm_.setcc(first, Gpr::Rax);
+        asm_.setcc(second, Gpr::Rcx);
+        asm_.movzxByte(Gpr::Rax, Gpr::Rax);
+        asm_.movzxByte(Gpr::Rcx, Gpr::Rcx);
+        asm_.alu(op, Gpr::Rax, Gpr::Rcx);
+    }
+
+    // --- calls into C++ ---
+
+    bool holdsRegister(int reg) const {
+        LocationKind kind = locations_[reg].kind;
+        return kind == LocationKind::Gpr || kind == LocationKind::Xmm;
+    }
+
+    void spill(int reg) {
+        if (at(reg).kind == LocationKind::Gpr) {
+            asm_.mov(slot(reg), gpr(at(reg)));
+        } else {
+            asm_.movsd(slot(reg), xmm(at(reg)));
+        }
+    }
+
+    void reload(int reg) {
+        if (at(reg).kind == LocationKind::Gpr) {
+            asm_.mov(gpr(at(reg)), slot(reg));
+        } else {
+            asm_.movsd(xmm(at(reg)), slot(reg));
+        }
+    }
+
+    // The runtime works on the frame, and calls clobber the caller-saved
+    // registers, so every value in a CPU register around the call goes
+    // through its slot.
+    void callRuntime(std::size_t index) {
+        std::vector<int> live;
+        int position = static_cast<int>(index);
+        for (int reg = 0; reg < registerCount_; ++reg) {
+            if (holdsRegister(reg) && start_[reg] <= position && position <= end_[reg]) {
+                live.push_back(reg);
+            }
+        }
+        for (int reg : live) {
+            spill(reg);
+        }
+        asm_.mov64(Gpr::Rdi, kRuntimeSlot);
+        asm_.mov(Gpr::Rsi, static_cast<std::int32_t>(index));
+        asm_.mov64(Gpr::Rax, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&runtimeStep)));
+        asm_.call(Gpr::Rax);
+        for (int reg : live) {
+            reload(reg);
+        }
+        asm_.test(Gpr::Rax, Gpr::Rax);
+        asm_.jcc(Cond::NotEqual, failed_);
+    }
+
+    // --- the function ---
+
+    void emitProgram() {
+        labels_.clear();
+        for (std::size_t i = 0; i <= chunk_.code.size(); ++i) {
+            labels_.push_back(asm_.newLabel());
+        }
+        exit_ = asm_.newLabel();
+        failed_ = asm_.newLabel();
+
+        // int entry(Runtime* rdi, NumericSlot* rsi). Six pushes and 24 bytes
+        // keep rsp 16-byte aligned at every call.
+        asm_.push(Gpr::Rbp);
+        asm_.mov64(Gpr::Rbp, Gpr::Rsp);
+        asm_.push(Gpr::Rbx);
+        asm_.push(Gpr::R12);
+        asm_.push(Gpr::R13);
+        asm_.push(Gpr::R14);
+        asm_.push(Gpr::R15);
+        asm_.sub64(Gpr::Rsp, 24);
+        asm_.mov64(kRuntimeSlot, Gpr::Rdi);
+        asm_.mov64(kFrame, Gpr::Rsi);
+        for (int reg = 0; reg < registerCount_; ++reg) {
+            if (holdsRegister(reg) && liveAtEntry_.contains(reg)) {
+                reload(reg);
+            }
+        }
+
+        for (std::size_t i = 0; i < chunk_.code.size(); ++i) {
+            asm_.bind(labels_[i]);
+            emitInstruction(i, chunk_.code[i]);
+        }
+        asm_.bind(labels_[chunk_.code.size()]);
+        asm_.alu(Alu::Xor, Gpr::Rax, Gpr::Rax);
+        asm_.jmp(exit_);
+
+        asm_.bind(failed_);
+        asm_.mov(Gpr::Rax, 1);
+        asm_.bind(exit_);
+        asm_.add64(Gpr::Rsp, 24);
+        asm_.pop(Gpr::R15);
+        asm_.pop(Gpr::R14);
+        asm_.pop(Gpr::R13);
+        asm_.pop(Gpr::R12);
+        asm_.pop(Gpr::Rbx);
+        asm_.pop(Gpr::Rbp);
+        asm_.ret();
+    }
+
+    void emitInstruction(std::size_t index, const Instruction& ins) {
+        if (shapeOf(ins.op).callsRuntime) {
+            callRuntime(index);
+            return;
+        }
+        switch (ins.op) {
+            case Op::LoadInt:
+                if (at(ins.a).kind == LocationKind::Gpr) {
+                    asm_.mov(gpr(at(ins.a)), ins.b);
+                } else {
+                    // Constants keep their slot filled for the runtime.
+                    asm_.mov(slot(ins.a), ins.b);
+                }
+                break;
+            case Op::LoadDouble: {
+                std::uint64_t bits;
+                std::memcpy(&bits, &chunk_.doubles[ins.b], sizeof(bits));
+                asm_.mov64(Gpr::Rax, bits);
+                storeDoubleBits(ins.a);
+                break;
+            }
+            case Op::MoveNum: emitMove(ins); break;
+            case Op::IntToDouble: {
+                const Location& target = at(ins.a);
+                Xmm dst = target.kind == LocationKind::Xmm ? xmm(target) : Xmm::X0;
+                asm_.xorpd(dst, dst);
+                if (at(ins.b).kind == LocationKind::Memory) {
+                    asm_.cvtsi2sd(dst, slot(ins.b));
+                } else {
+                    asm_.cvtsi2sd(dst, intOperand(ins.b, Gpr::Rax));
+                }
+                storeDouble(ins.a, dst);
+                break;
+            }
+            case Op::DoubleToInt:
+                if (at(ins.b).kind == LocationKind::Xmm) {
+                    asm_.cvttsd2si(Gpr::Rax, xmm(at(ins.b)));
+                } else {
+                    asm_.cvttsd2si(Gpr::Rax, slot(ins.b));
+                }
+                storeInt(ins.a, Gpr::Rax);
+                break;
+            case Op::IntToBool: intTest(ins, Cond::NotEqual); break;
+            case Op::NotInt: intTest(ins, Cond::Equal); break;
+            case Op::DoubleToBool:
+            case Op::NotDouble:
+                doubleTest(ins);
+                break;
+            case Op::AddInt:
+            case Op::SubInt:
+            case Op::MulInt:
+                intArithmetic(ins);
+                break;
+            case Op::DivInt:
+            case Op::ModInt:
+                intDivision(index, ins);
+                break;
+            case Op::NegInt:
+                loadInt(Gpr::Rax, ins.b);
+                asm_.neg(Gpr::Rax);
+                storeInt(ins.a, Gpr::Rax);
+                break;
+            case Op::AddDouble: doubleArithmetic(ins, Sse::Add); break;
+            case Op::SubDouble: doubleArithmetic(ins, Sse::Sub); break;
+            case Op::MulDouble: doubleArithmetic(ins, Sse::Mul); break;
+            case Op::DivDouble: doubleArithmetic(ins, Sse::Div); break;
+            case Op::NegDouble:
+                // Flipping the sign bit also turns 0.0 into -0.0, like C++.
+                loadDoubleBits(ins.b);
+                asm_.btc64(Gpr::Rax, 63);
+                storeDoubleBits(ins.a);
+                break;
+            case Op::EqInt: intComparison(ins, Cond::Equal); break;
+            case Op::LtInt: intComparison(ins, Cond::Less); break;
+            case Op::LeInt: intComparison(ins, Cond::LessEqual); break;
+            case Op::GtInt: intComparison(ins, Cond::Greater); break;
+            case Op::GeInt: intComparison(ins, Cond::GreaterEqual); break;
+            case Op::EqDouble:
+            case Op::LtDouble:
+            case Op::LeDouble:
+            case Op::GtDouble:
+            case Op::GeDouble:
+                doubleComparison(ins);
+                break;
+            case Op::Jump: asm_.jmp(labels_[ins.a]); break;
+            case Op::JumpIfFalse:
+            case Op::JumpIfTrue:
+            case Op::LoopIfTrue: {
+                Gpr value = intOperand(ins.a, Gpr::Rax);
+                asm_.test(value, value);
+                asm_.jcc(ins.op == Op::JumpIfFalse ? Cond::Equal : Cond::NotEqual, labels_[ins.b]);
+                break;
+            }
+            case Op::ForInitInt: compareAndBranch(ins, Cond::Greater); break;
+            case Op::ForLoopInt:
+                if (at(ins.a).kind == LocationKind::Gpr) {
+                    asm_.alu(Alu::Add, gpr(at(ins.a)), 1);
+                } else {
+                    asm_.alu(Alu::Add, slot(ins.a), 1);
+                }
+                compareAndBranch(ins, Cond::LessEqual);
+                break;
+            case Op::JumpIfLtInt: compareAndBranch(ins, Cond::Less); break;
+            case Op::JumpIfLeInt: compareAndBranch(ins, Cond::LessEqual); break;
+            case Op::JumpIfGtInt: compareAndBranch(ins, Cond::Greater); break;
+            case Op::JumpIfGeInt: compareAndBranch(ins, Cond::GreaterEqual); break;
+            case Op::JumpIfEqInt: compareAndBranch(ins, Cond::Equal); break;
+            case Op::JumpIfNeInt: compareAndBranch(ins, Cond::NotEqual); break;
+            case Op::AddIntImm: {
+                Gpr dst = at(ins.a).kind == LocationKind::Gpr ? gpr(at(ins.a)) : Gpr::Rax;
+                loadInt(dst, ins.b);
+                asm_.alu(Alu::Add, dst, ins.c);
+                storeInt(ins.a, dst);
+                break;
+            }
+            case Op::Halt:
+                asm_.alu(Alu::Xor, Gpr::Rax, Gpr::Rax);
+                asm_.jmp(exit_);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void emitMove(const Instruction& ins) {
+        const Location& target = at(ins.a);
+        const Location& source = at(ins.b);
+        switch (target.kind) {
+            case LocationKind::Gpr: loadInt(gpr(target), ins.b); break;
+            case LocationKind::Xmm: loadDouble(xmm(target), ins.b); break;
+            case LocationKind::Memory:
+            case LocationKind::Constant:
+                if (source.kind == LocationKind::Gpr) {
+                    asm_.mov(slot(ins.a), gpr(source));
+                } else if (source.kind == LocationKind::Xmm) {
+                    asm_.movsd(slot(ins.a), xmm(source));
+                } else if (source.kind == LocationKind::Constant) {
+                    asm_.mov(slot(ins.a), source.value);
+                } else {
+                    // Type unknown here: copy all eight bytes.
+                    asm_.mov64(Gpr::Rax, slot(ins.b));
+                    asm_.mov64(slot(ins.a), Gpr::Rax);
+                }
+                break;
+        }
+    }
+
+    const Chunk& chunk_;
+    int registerCount_;
+    // Bit 1: used as int, bit 2: used as double.
+    std::vector<unsigned> classes_;
+    std::vector<Location> locations_;
+    std::vector<int> start_;
+    std::vector<int> end_;
+    RegisterSet liveAtEntry_;
+    X64Assembler asm_;
+    std::vector<Label> labels_;
+    Label exit_{0};
+    Label failed_{0};
+};
+
+#endif
+
+}  // namespace
+
+void Jit::run(const Program& program, std::istream& in, std::ostream& out, const JitOptions& options) {
+    execute(BytecodeCompiler::compile(program), in, out, options);
+}
+
+void Jit::execute(const Chunk& chunk, std::istream& in, std::ostream& out, const JitOptions& options) {
+#if BEARLANG_JIT_X64
+    ExecutableCode code(Lowering(chunk).compile());
+    if (code.valid()) {
+        // The frame is zeroed, as in the VM.
+        std::vector<NumericSlot> numeric(chunk.numericSlots + 1);
+        std::vector<std::string> strings(chunk.stringSlots + 1);
+        Runtime runtime{&chunk, numeric.data(), strings.data(), &in, &out, options.bufferedOutput, nullptr};
+        if (code.entry()(&runtime, numeric.data()) != 0) {
+            std::rethrow_exception(runtime.failure);
+        }
+        out.flush();
+        return;
+    }
+#endif
+    VmOptions vmOptions;
+    vmOptions.bufferedOutput = options.bufferedOutput;
+    VirtualMachine::execute(chunk, in, out, vmOptions);
+}
+
+bool Jit::available() {
+    return BEARLANG_JIT_X64 != 0;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iosfwd>
+
+#include "core/parser/ast.h"
+#include "core/vm/bytecode.h"
+
+namespace bearlang {
+
+struct JitOptions {
+    // Same meaning as InterpreterOptions::bufferedOutput.
+    bool bufferedOutput = true;
+};
+
+// Translates the bytecode of BytecodeCompiler into x86-64 machine code and
+// runs it in-process. Numeric registers are mapped to CPU registers by linear
+// scan over their live intervals; strings, `ввод` / `вывод`, `^` and the
+// error paths of `/` and `%` call back into C++. Results, input handling and
+// RuntimeError conditions are the same as in VirtualMachine.
+//
+// The code is written into anonymous memory that becomes executable only
+// after it stops being writable. Only x86-64 with the System V calling
+// convention is supported; elsewhere, or when the system refuses executable
+// memory, the program runs on the VM instead.
+class Jit {
+public:
+    static void run(const Program& program,
+                    std::istream& in,
+                    std::ostream& out,
+                    const JitOptions& options = {});
+
+    static void execute(const Chunk& chunk,
+                        std::istream& in,
+                        std::ostream& out,
+                        const JitOptions& options = {});
+
+    static bool available();
+};
+
+}  // namespace bearlang
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
@@ -92,6 +94,9 @@ struct Statement {
 
     StatementKind kind() const { return kind_; }
 
+    // 1-based source line of the statement's first token; 0 if unknown.
+    std::size_t line = 0;
+
 private:
     StatementKind kind_;
 };
@@ -136,6 +141,8 @@ struct IfStmt : Statement {
     struct Branch {
         ExprPtr condition;
         std::vector<StmtPtr> body;
+        // Line of the `если` / `иначе если` holding the condition.
+        std::size_t line = 0;
     };
 
     IfStmt() : Statement(StatementKind::If) {}
@@ -204,6 +211,35 @@ inline StmtPtr makeFor(ValueType type,
         type, std::move(name), std::move(from), std::move(to), std::move(body));
 }
 
+// Last source line of a statement, including nested blocks.
+inline std::size_t lastLine(const Statement& stmt) {
+    std::size_t last = stmt.line;
+    auto block = [&last](const std::vector<StmtPtr>& statements) {
+        for (const auto& nested : statements) {
+            last = std::max(last, lastLine(*nested));
+        }
+    };
+    switch (stmt.kind()) {
+        case StatementKind::If: {
+            const auto& ifStmt = static_cast<const IfStmt&>(stmt);
+            for (const auto& branch : ifStmt.branches) {
+                block(branch.body);
+            }
+            block(ifStmt.elseBranch);
+            break;
+        }
+        case StatementKind::While:
+            block(static_cast<const WhileStmt&>(stmt).body);
+            break;
+        case StatementKind::ForRange:
+            block(static_cast<const ForRangeStmt&>(stmt).body);
+            break;
+        default:
+            break;
+    }
+    return last;
+}
+
 struct Program {
     std::vector<StmtPtr> statements;
 };
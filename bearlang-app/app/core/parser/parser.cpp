@@ -98,29 +98,39 @@ StmtPtr Parser::parseStatement() {
         throw ParserError("Неожиданный отступ");
     }
 
+    std::size_t line = peek().line;
+    StmtPtr stmt;
     if (isTypeKeyword(peek().type)) {
-        return parseVarDecl();
-    }
-
-    switch (peek().type) {
-        case TokenType::KeywordInput:
-            return parseInput();
-        case TokenType::KeywordOutput:
-            return parseOutput();
-        case TokenType::KeywordIf:
-            return parseIf();
-        case TokenType::KeywordWhile:
-            return parseWhile();
-        case TokenType::KeywordFor:
-            return parseFor();
-        case TokenType::Identifier:
-            return parseAssignment();
-        default: {
-            std::ostringstream oss;
-            oss << "Неожиданное слово '" << peek().lexeme << "'";
-            throw ParserError(oss.str());
+        stmt = parseVarDecl();
+    } else {
+        switch (peek().type) {
+            case TokenType::KeywordInput:
+                stmt = parseInput();
+                break;
+            case TokenType::KeywordOutput:
+                stmt = parseOutput();
+                break;
+            case TokenType::KeywordIf:
+                stmt = parseIf();
+                break;
+            case TokenType::KeywordWhile:
+                stmt = parseWhile();
+                break;
+            case TokenType::KeywordFor:
+                stmt = parseFor();
+                break;
+            case TokenType::Identifier:
+                stmt = parseAssignment();
+                break;
+            default: {
+                std::ostringstream oss;
+                oss << "Неожиданное слово '" << peek().lexeme << "'";
+                throw ParserError(oss.str());
+            }
         }
     }
+    stmt->line = line;
+    return stmt;
 }
 
 StmtPtr Parser::parseVarDecl() {
@@ -170,7 +180,7 @@ StmtPtr Parser::parseOutput() {
 }
 
 StmtPtr Parser::parseIf() {
-    advance();
+    std::size_t line = advance().line;
     auto condition = parseParenthesizedCondition("если");
     auto ifBody = parseIndentedBlock("условия 'если'");
 
@@ -178,15 +188,18 @@ StmtPtr Parser::parseIf() {
     IfStmt::Branch firstBranch;
     firstBranch.condition = std::move(condition);
     firstBranch.body = std::move(ifBody);
+    firstBranch.line = line;
     ifStmt->branches.push_back(std::move(firstBranch));
 
     while (match(TokenType::KeywordElse)) {
+        std::size_t elseLine = previous().line;
         if (match(TokenType::KeywordIf)) {
             auto elseIfCond = parseParenthesizedCondition("иначе если");
             auto elseIfBody = parseIndentedBlock("условия 'иначе если'");
             IfStmt::Branch branch;
             branch.condition = std::move(elseIfCond);
             branch.body = std::move(elseIfBody);
+            branch.line = elseLine;
             ifStmt->branches.push_back(std::move(branch));
         } else {
             ifStmt->elseBranch = parseIndentedBlock("блока 'иначе'");
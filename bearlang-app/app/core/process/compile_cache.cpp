@@ -0,0 +1,236 @@
+#include "compile_cache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+#include "workspace.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+const char* const kBinaryName = "binary";
+const char* const kKeyName = "key";
+const char* const kStatsName = "stats";
+const char* const kLockName = "lock";
+
+bool isEntryName(const std::string& name) {
+    return name.size() == 16 &&
+           std::all_of(name.begin(), name.end(), [](char c) {
+               return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+           });
+}
+
+std::string readText(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// A hard link when `to` is on the same filesystem, a copy otherwise.
+bool linkOrCopy(const fs::path& from, const fs::path& to) {
+    std::error_code error;
+    fs::create_hard_link(from, to, error);
+    if (!error) {
+        return true;
+    }
+    return fs::copy_file(from, to, fs::copy_options::overwrite_existing, error) && !error;
+}
+
+// flock on a file in the cache directory for the lifetime of the object.
+// Windows gets no locking: the statistics may then miss a concurrent update.
+class DirectoryLock {
+public:
+    DirectoryLock(const fs::path& file, bool exclusive) {
+#ifndef _WIN32
+        fd_ = ::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ >= 0) {
+            ::flock(fd_, exclusive ? LOCK_EX : LOCK_SH);
+        }
+#else
+        (void)file;
+        (void)exclusive;
+#endif
+    }
+
+    ~DirectoryLock() {
+#ifndef _WIN32
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    DirectoryLock(const DirectoryLock&) = delete;
+    DirectoryLock& operator=(const DirectoryLock&) = delete;
+
+private:
+    int fd_ = -1;
+};
+
+struct Entry {
+    fs::path path;
+    fs::file_time_type used;
+    std::uintmax_t bytes;
+};
+
+std::vector<Entry> listEntries(const fs::path& directory) {
+    std::vector<Entry> entries;
+    std::error_code error;
+    for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        if (!isEntryName(it->path().filename().string())) {
+            continue;
+        }
+        std::error_code entryError;
+        Entry entry{it->path(), fs::last_write_time(it->path(), entryError), 0};
+        for (const char* name : {kBinaryName, kKeyName}) {
+            std::uintmax_t size = fs::file_size(it->path() / name, entryError);
+            entry.bytes += entryError ? 0 : size;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
+CompileCacheStats readStats(const fs::path& path) {
+    CompileCacheStats stats;
+    std::istringstream in(readText(path));
+    std::string name;
+    std::uint64_t value = 0;
+    while (in >> name >> value) {
+        if (name == "hits") {
+            stats.hits = value;
+        } else if (name == "misses") {
+            stats.misses = value;
+        } else if (name == "evictions") {
+            stats.evictions = value;
+        }
+    }
+    return stats;
+}
+
+}  // namespace
+
+std::string fnv1aHex(const std::string& text) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    const char* digits = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) {
+        hex[static_cast<std::size_t>(i)] = digits[hash & 0xf];
+    }
+    return hex;
+}
+
+CompileCache::CompileCache(fs::path directory, std::uintmax_t maxBytes)
+    : directory_(std::move(directory)), maxBytes_(maxBytes) {
+    std::error_code ignored;
+    fs::create_directories(directory_, ignored);
+    // Staging directories of processes that died before publishing.
+    sweepWorkspaceRoot(directory_, 0);
+}
+
+fs::path CompileCache::entryPath(const std::string& key) const {
+    return directory_ / fnv1aHex(key);
+}
+
+bool CompileCache::fetch(const std::string& key, const fs::path& target) {
+    fs::path entry = entryPath(key);
+    bool hit = readText(entry / kKeyName) == key && linkOrCopy(entry / kBinaryName, target);
+    if (hit) {
+        // Recency for LRU eviction.
+        std::error_code ignored;
+        fs::last_write_time(entry, fs::file_time_type::clock::now(), ignored);
+    }
+    record(hit ? 1 : 0, hit ? 0 : 1, 0);
+    return hit;
+}
+
+void CompileCache::store(const std::string& key, const fs::path& binary) {
+    {
+        JobWorkspace staging(directory_);
+        if (!linkOrCopy(binary, staging.file(kBinaryName))) {
+            return;
+        }
+        std::ofstream(staging.file(kKeyName), std::ios::binary) << key;
+        // Fails when another process published the same entry first; its
+        // binary is as good as ours, and `staging` removes this copy.
+        std::error_code lost;
+        fs::rename(staging.path(), entryPath(key), lost);
+    }
+
+    std::uint64_t evicted = 0;
+    {
+        DirectoryLock lock(directory_ / kLockName, true);
+        evicted = evict();
+    }
+    if (evicted != 0) {
+        record(0, 0, evicted);
+    }
+}
+
+std::uint64_t CompileCache::evict() {
+    std::vector<Entry> entries = listEntries(directory_);
+    std::uintmax_t total = 0;
+    for (const Entry& entry : entries) {
+        total += entry.bytes;
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    std::uint64_t evicted = 0;
+    for (const Entry& entry : entries) {
+        if (total <= maxBytes_) {
+            break;
+        }
+        // Out of the key's name first, so a lookup never sees half an entry.
+        fs::path doomed = entry.path;
+        doomed += ".evicted";
+        std::error_code error;
+        fs::rename(entry.path, doomed, error);
+        if (!error) {
+            fs::remove_all(doomed, error);
+            total -= entry.bytes;
+            ++evicted;
+        }
+    }
+    return evicted;
+}
+
+void CompileCache::record(std::uint64_t hits, std::uint64_t misses, std::uint64_t evictions) const {
+    DirectoryLock lock(directory_ / kLockName, true);
+    CompileCacheStats stats = readStats(directory_ / kStatsName);
+    std::ostringstream text;
+    text << "hits " << stats.hits + hits << "\nmisses " << stats.misses + misses << "\nevictions "
+         << stats.evictions + evictions << "\n";
+    try {
+        writeFileAtomically(directory_ / kStatsName, text.str());
+    } catch (const std::exception&) {
+        // Statistics are advisory; a read-only cache still serves hits.
+    }
+}
+
+CompileCacheStats CompileCache::stats() const {
+    DirectoryLock lock(directory_ / kLockName, false);
+    CompileCacheStats stats = readStats(directory_ / kStatsName);
+    for (const Entry& entry : listEntries(directory_)) {
+        ++stats.entries;
+        stats.bytes += entry.bytes;
+    }
+    return stats;
+}
+
+}  // namespace bearlang
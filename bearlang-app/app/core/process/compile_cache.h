@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace bearlang {
+
+// Totals kept in the cache directory, so they cover every process using it.
+struct CompileCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::uintmax_t bytes = 0;
+};
+
+// FNV-1a of `text` as 16 hex digits, the name of a cache entry.
+std::string fnv1aHex(const std::string& text);
+
+// Binaries built from generated C++, keyed by everything that determines
+// them: the compiler's identity, its flags and the source (callers pass all
+// three as one `key` text). An entry is directory/<FNV-1a of key>/ holding the
+// binary and the key itself, which a lookup compares in full, so a hash
+// collision is a miss rather than the wrong program.
+//
+// Several processes may share a directory. An entry appears by renaming a
+// finished staging directory into place, so it is complete or absent; a hit
+// hard-links (or copies) the binary out, so evicting the entry afterwards does
+// not disturb the run. Eviction and the statistics file are serialised by
+// an flock on directory/lock.
+class CompileCache {
+public:
+    // Creates `directory` if needed. Entries beyond `maxBytes` are evicted,
+    // least recently used first.
+    CompileCache(std::filesystem::path directory, std::uintmax_t maxBytes);
+
+    // Places the binary cached for `key` at `target` and counts a hit, or
+    // counts a miss and returns false.
+    bool fetch(const std::string& key, const std::filesystem::path& target);
+
+    // Adds the binary built for `key`, then evicts down to the size limit.
+    void store(const std::string& key, const std::filesystem::path& binary);
+
+    CompileCacheStats stats() const;
+
+    const std::filesystem::path& directory() const {
+        return directory_;
+    }
+
+private:
+    std::filesystem::path entryPath(const std::string& key) const;
+    // Removes least recently used entries down to maxBytes_; the caller holds
+    // the lock. Returns how many went.
+    std::uint64_t evict();
+    void record(std::uint64_t hits, std::uint64_t misses, std::uint64_t evictions) const;
+
+    std::filesystem::path directory_;
+    std::uintmax_t maxBytes_;
+};
+
+}  // namespace bearlang
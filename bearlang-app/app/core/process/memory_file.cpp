@@ -0,0 +1,79 @@
+#include "memory_file.h"
+
+#include <stdexcept>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bearlang {
+
+#ifdef __linux__
+
+bool MemoryFile::available() {
+    return true;
+}
+
+MemoryFile::MemoryFile() : fd_(::memfd_create("bearlang_program", MFD_CLOEXEC)) {
+    if (fd_ < 0) {
+        throw std::runtime_error("Не удалось создать файл в памяти (memfd_create)");
+    }
+}
+
+MemoryFile::~MemoryFile() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::string MemoryFile::writePath() const {
+    return "/proc/" + std::to_string(::getpid()) + "/fd/" + std::to_string(fd_);
+}
+
+std::string MemoryFile::executablePath() {
+    int readOnly = ::open(writePath().c_str(), O_RDONLY | O_CLOEXEC);
+    if (readOnly < 0) {
+        throw std::runtime_error("Не удалось открыть собранную программу в памяти");
+    }
+    ::close(fd_);
+    fd_ = readOnly;
+    // A close-on-exec descriptor still names the file while execve opens it,
+    // so a spawned child can run its own /proc/self/fd copy.
+    return "/proc/self/fd/" + std::to_string(fd_);
+}
+
+std::uint64_t MemoryFile::size() const {
+    struct stat info {};
+    return ::fstat(fd_, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+}
+
+#else
+
+bool MemoryFile::available() {
+    return false;
+}
+
+MemoryFile::MemoryFile() {
+    throw std::runtime_error("Файлы в памяти есть только в Linux");
+}
+
+MemoryFile::~MemoryFile() = default;
+
+std::string MemoryFile::writePath() const {
+    return std::string();
+}
+
+std::string MemoryFile::executablePath() {
+    return std::string();
+}
+
+std::uint64_t MemoryFile::size() const {
+    return 0;
+}
+
+#endif
+
+}  // namespace bearlang
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace bearlang {
+
+// An anonymous file in memory (memfd_create) for a binary that is linked and
+// executed without touching a filesystem: the linker writes it through
+// writePath(), and the program is started from executablePath(), which is
+// what fexecve does. Linux only.
+class MemoryFile {
+public:
+    // False where memfd_create does not exist; the constructor then throws.
+    static bool available();
+
+    // Throws std::runtime_error when the file cannot be created.
+    MemoryFile();
+    ~MemoryFile();
+
+    MemoryFile(const MemoryFile&) = delete;
+    MemoryFile& operator=(const MemoryFile&) = delete;
+
+    // /proc/<pid>/fd/<fd>: openable by other processes of the same user.
+    std::string writePath() const;
+
+    // Once the writer is done: the kernel refuses to execute a file that is
+    // open for writing, so the writable descriptor is swapped for a read-only
+    // one. The returned /proc/self/fd path is valid in children this process
+    // spawns afterwards. Throws std::runtime_error on failure.
+    std::string executablePath();
+
+    std::uint64_t size() const;
+
+private:
+    int fd_ = -1;
+};
+
+}  // namespace bearlang
@@ -0,0 +1,92 @@
+#include "precompiled_header.h"
+
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include "compile_cache.h"
+#include "workspace.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+const char* const kHeaderName = "bearlang_runtime.h";
+const char* const kCompiledName = "bearlang_runtime.h.gch";
+const char* const kKeyName = "key";
+
+std::string readText(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+bool isComplete(const fs::path& entry, const std::string& key) {
+    std::error_code error;
+    return fs::is_regular_file(entry / kCompiledName, error) && readText(entry / kKeyName) == key;
+}
+
+}  // namespace
+
+PrecompiledHeader::PrecompiledHeader(fs::path directory,
+                                     std::vector<std::string> compiler,
+                                     std::string identity,
+                                     std::string header)
+    : directory_(fs::absolute(directory)),
+      compiler_(std::move(compiler)),
+      key_(identity + "\n" + header),
+      header_(std::move(header)) {}
+
+fs::path PrecompiledHeader::prepare() {
+    if (!ready_.empty() || failed_) {
+        return ready_;
+    }
+    fs::path entry = directory_ / fnv1aHex(key_);
+    if (isComplete(entry, key_)) {
+        ready_ = entry / kHeaderName;
+        return ready_;
+    }
+
+    try {
+        // Staging directories of processes that died mid-build.
+        sweepWorkspaceRoot(directory_, 0);
+        JobWorkspace staging(directory_);
+        std::ofstream(staging.file(kHeaderName), std::ios::binary) << header_;
+        std::vector<std::string> command = compiler_;
+        command.insert(command.end(), {"-x", "c++-header", staging.file(kHeaderName).string(), "-o",
+                                       staging.file(kCompiledName).string()});
+        ProcessOptions options;
+        options.output = ChildStream::Capture;
+        options.errors = ChildStream::Capture;
+        build_ = runProcess(command, options);
+        if (!build_.succeeded()) {
+            failed_ = true;
+            return ready_;
+        }
+        std::ofstream(staging.file(kKeyName), std::ios::binary) << key_;
+        // A damaged entry, or one whose key merely shares the hash, makes way
+        // the way CompileCache evicts: out of the name first.
+        std::error_code error;
+        if (fs::exists(entry, error) && !isComplete(entry, key_)) {
+            fs::path doomed = staging.path();
+            doomed += ".stale";
+            fs::rename(entry, doomed, error);
+            fs::remove_all(doomed, error);
+        }
+        // Fails when another process published the entry first; `staging`
+        // then removes this copy.
+        fs::rename(staging.path(), entry, error);
+    } catch (const std::exception&) {
+        failed_ = true;
+        return ready_;
+    }
+    if (isComplete(entry, key_)) {
+        ready_ = entry / kHeaderName;
+    } else {
+        failed_ = true;
+    }
+    return ready_;
+}
+
+}  // namespace bearlang
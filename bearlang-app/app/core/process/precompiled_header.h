@@ -0,0 +1,52 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+namespace bearlang {
+
+// A header that g++ compiles once into a .gch beside it; a build that
+// includes the header first loads that instead of parsing the text. Entries
+// are keyed like CompileCache entries: directory/<FNV-1a of key>/ holds the
+// header, its .gch and the key (the compiler's identity and flags, and the
+// header text), which is compared in full. Another g++ or flag set therefore
+// gets its own entry. When a .gch does not match a compilation after all,
+// g++ quietly parses the header text instead, so a stale one costs time but
+// never breaks a build.
+//
+// Several processes may share a directory: an entry appears by renaming a
+// finished staging directory into place.
+class PrecompiledHeader {
+public:
+    // `compiler` is the g++ command line every build starts with, flags
+    // included; `identity` is the text that tells it apart from other
+    // compilers (see compilerIdentity in app.cpp). Nothing is built yet.
+    PrecompiledHeader(std::filesystem::path directory,
+                      std::vector<std::string> compiler,
+                      std::string identity,
+                      std::string header);
+
+    // The header to #include, its .gch built first if there is none for this
+    // compiler yet. Empty when that build fails; the build is not retried.
+    std::filesystem::path prepare();
+
+    // The g++ run of the prepare() that built the .gch; `started` is false
+    // when an existing one was used.
+    const ProcessResult& build() const {
+        return build_;
+    }
+
+private:
+    std::filesystem::path directory_;
+    std::vector<std::string> compiler_;
+    std::string key_;
+    std::string header_;
+    std::filesystem::path ready_;
+    bool failed_ = false;
+    ProcessResult build_;
+};
+
+}  // namespace bearlang
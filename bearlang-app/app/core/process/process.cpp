@@ -0,0 +1,304 @@
+#include "process.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace bearlang {
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+#ifndef _WIN32
+
+double toMilliseconds(const timeval& time) {
+    return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_usec) / 1000.0;
+}
+
+// Both ends close on exec; posix_spawn's dup2 gives the child its own copy.
+struct Pipe {
+    int read = -1;
+    int write = -1;
+
+    bool open() {
+        int fds[2];
+        if (::pipe2(fds, O_CLOEXEC) != 0) {
+            return false;
+        }
+        read = fds[0];
+        write = fds[1];
+        return true;
+    }
+
+    static void close(int& fd) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    ~Pipe() {
+        close(read);
+        close(write);
+    }
+};
+
+// Writing to a child that exited without reading all of its input must fail
+// with EPIPE rather than kill bearlang_app; children get SIGPIPE back through
+// POSIX_SPAWN_SETSIGDEF.
+void ignoreSigpipe() {
+    static std::once_flag once;
+    std::call_once(once, [] { std::signal(SIGPIPE, SIG_IGN); });
+}
+
+bool setupStream(posix_spawn_file_actions_t& actions, ChildStream mode, Pipe& pipe, int target) {
+    switch (mode) {
+        case ChildStream::Inherit:
+            return true;
+        case ChildStream::Discard:
+            return posix_spawn_file_actions_addopen(&actions, target, "/dev/null", O_WRONLY, 0) == 0;
+        case ChildStream::Capture:
+            return pipe.open() && posix_spawn_file_actions_adddup2(&actions, pipe.write, target) == 0;
+    }
+    return false;
+}
+
+// Feeds `input` and drains the captured streams until all of them are closed.
+void pumpStreams(Pipe& in, const std::string& input, Pipe& out, std::string& output, Pipe& err,
+                 std::string& errors) {
+    std::size_t written = 0;
+    if (in.write >= 0) {
+        ::fcntl(in.write, F_SETFL, ::fcntl(in.write, F_GETFL) | O_NONBLOCK);
+        if (input.empty()) {
+            Pipe::close(in.write);
+        }
+    }
+    char buffer[65536];
+    while (in.write >= 0 || out.read >= 0 || err.read >= 0) {
+        pollfd fds[3];
+        nfds_t count = 0;
+        if (in.write >= 0) fds[count++] = {in.write, POLLOUT, 0};
+        if (out.read >= 0) fds[count++] = {out.read, POLLIN, 0};
+        if (err.read >= 0) fds[count++] = {err.read, POLLIN, 0};
+        if (::poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (nfds_t i = 0; i < count; ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            if (fds[i].fd == in.write) {
+                ssize_t n = ::write(in.write, input.data() + written, input.size() - written);
+                if (n > 0) {
+                    written += static_cast<std::size_t>(n);
+                }
+                if ((n < 0 && errno != EAGAIN && errno != EINTR) || written == input.size()) {
+                    Pipe::close(in.write);
+                }
+                continue;
+            }
+            Pipe& pipe = fds[i].fd == out.read ? out : err;
+            std::string& text = fds[i].fd == out.read ? output : errors;
+            ssize_t n = ::read(pipe.read, buffer, sizeof buffer);
+            if (n > 0) {
+                text.append(buffer, static_cast<std::size_t>(n));
+            } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                Pipe::close(pipe.read);
+            }
+        }
+    }
+}
+
+#else
+
+std::string quoteArgument(const std::string& argument) {
+    return "\"" + argument + "\"";
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+#endif
+
+}  // namespace
+
+#ifndef _WIN32
+
+ProcessResult runProcess(const std::vector<std::string>& argv, const ProcessOptions& options) {
+    ProcessResult result;
+    if (argv.empty()) {
+        return result;
+    }
+    ignoreSigpipe();
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &defaults);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+
+    Pipe in;
+    Pipe out;
+    Pipe err;
+    bool ready = true;
+    if (options.input) {
+        ready = in.open() && posix_spawn_file_actions_adddup2(&actions, in.read, 0) == 0;
+    }
+    ready = ready && setupStream(actions, options.output, out, 1);
+    ready = ready && setupStream(actions, options.errors, err, 2);
+
+    std::vector<char*> arguments;
+    arguments.reserve(argv.size() + 1);
+    for (const auto& argument : argv) {
+        arguments.push_back(const_cast<char*>(argument.c_str()));
+    }
+    arguments.push_back(nullptr);
+
+    std::vector<char*> environment;
+    if (!options.environment.empty()) {
+        for (char** variable = environ; *variable != nullptr; ++variable) {
+            std::string name(*variable, std::strcspn(*variable, "=") + 1);
+            bool replaced = std::any_of(
+                options.environment.begin(), options.environment.end(),
+                [&](const std::string& entry) { return entry.compare(0, name.size(), name) == 0; });
+            if (!replaced) {
+                environment.push_back(*variable);
+            }
+        }
+        for (const auto& entry : options.environment) {
+            environment.push_back(const_cast<char*>(entry.c_str()));
+        }
+        environment.push_back(nullptr);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = -1;
+    if (ready) {
+        ready = ::posix_spawnp(&pid, arguments[0], &actions, &attributes, arguments.data(),
+                               environment.empty() ? environ : environment.data()) == 0;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    if (!ready) {
+        return result;
+    }
+    result.started = true;
+
+    // Only the child keeps these ends; holding them would hide its EOF.
+    Pipe::close(in.read);
+    Pipe::close(out.write);
+    Pipe::close(err.write);
+    pumpStreams(in, options.input ? *options.input : std::string(), out, result.output, err,
+                result.errors);
+
+    int status = 0;
+    rusage usage{};
+    while (::wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    result.wallMs = millisecondsSince(start);
+    result.userMs = toMilliseconds(usage.ru_utime);
+    result.systemMs = toMilliseconds(usage.ru_stime);
+    if (WIFEXITED(status)) {
+        result.exitCode = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.signal = WTERMSIG(status);
+    }
+    return result;
+}
+
+#else
+
+// Windows has no posix_spawn; the command goes through std::system with
+// redirections to temporary files, and the CPU times stay zero.
+ProcessResult runProcess(const std::vector<std::string>& argv, const ProcessOptions& options) {
+    ProcessResult result;
+    if (argv.empty()) {
+        return result;
+    }
+    std::ostringstream command;
+    command << "\"";
+    for (std::size_t i = 0; i < argv.size(); ++i) {
+        command << (i == 0 ? "" : " ") << quoteArgument(argv[i]);
+    }
+    std::string base = std::tmpnam(nullptr);
+    std::string inPath = base + ".in";
+    std::string outPath = base + ".out";
+    std::string errPath = base + ".err";
+    if (options.input) {
+        std::ofstream(inPath, std::ios::binary) << *options.input;
+        command << " < " << quoteArgument(inPath);
+    }
+    auto redirect = [&](ChildStream mode, const char* prefix, const std::string& path) {
+        if (mode == ChildStream::Capture) {
+            command << " " << prefix << quoteArgument(path);
+        } else if (mode == ChildStream::Discard) {
+            command << " " << prefix << "NUL";
+        }
+    };
+    redirect(options.output, ">", outPath);
+    redirect(options.errors, "2>", errPath);
+    command << "\"";
+
+    auto start = std::chrono::steady_clock::now();
+    int status = std::system(command.str().c_str());
+    result.wallMs = millisecondsSince(start);
+    result.started = status != -1;
+    result.exitCode = status;
+    if (options.output == ChildStream::Capture) {
+        result.output = readFile(outPath);
+    }
+    if (options.errors == ChildStream::Capture) {
+        result.errors = readFile(errPath);
+    }
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+    std::remove(errPath.c_str());
+    return result;
+}
+
+#endif
+
+std::string describeExit(const ProcessResult& result) {
+    if (!result.started) {
+        return "не удалось запустить";
+    }
+    if (result.signal != 0) {
+#ifndef _WIN32
+        return "сигнал " + std::to_string(result.signal) + " (" + ::strsignal(result.signal) + ")";
+#endif
+    }
+    return "код " + std::to_string(result.exitCode);
+}
+
+}  // namespace bearlang
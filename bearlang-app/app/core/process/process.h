@@ -0,0 +1,58 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bearlang {
+
+// Where a child's stdout or stderr goes.
+enum class ChildStream {
+    // The terminal bearlang_app itself writes to.
+    Inherit,
+    // Read through a pipe into ProcessResult.
+    Capture,
+    // Dropped.
+    Discard,
+};
+
+struct ProcessOptions {
+    // Written to the child's stdin through a pipe, which is then closed. When
+    // unset the child reads bearlang_app's own stdin.
+    std::optional<std::string> input;
+    ChildStream output = ChildStream::Inherit;
+    ChildStream errors = ChildStream::Inherit;
+    // "NAME=value" entries set in the child's environment on top of
+    // bearlang_app's own. Not applied by the Windows fallback.
+    std::vector<std::string> environment;
+};
+
+struct ProcessResult {
+    // False when the program could not be started at all.
+    bool started = false;
+    // Exit code of a child that exited; -1 otherwise.
+    int exitCode = -1;
+    // Signal that ended the child, or 0.
+    int signal = 0;
+    std::string output;
+    std::string errors;
+    double wallMs = 0.0;
+    // CPU time of the child, from wait4.
+    double userMs = 0.0;
+    double systemMs = 0.0;
+
+    bool succeeded() const {
+        return started && signal == 0 && exitCode == 0;
+    }
+};
+
+// Starts argv[0] (looked up in PATH when it has no '/') with the given
+// arguments, without a shell, so paths need no quoting. Stdin is written and
+// captured streams are read together with poll(), so a child that fills a
+// pipe before reading all its input cannot deadlock. Waits for the child.
+ProcessResult runProcess(const std::vector<std::string>& argv, const ProcessOptions& options = {});
+
+// "код 1", "сигнал 8 (Floating point exception)", ... for messages.
+std::string describeExit(const ProcessResult& result);
+
+}  // namespace bearlang
@@ -0,0 +1,241 @@
+#include "workspace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+const std::string kPrefix = "job-";
+
+unsigned long currentProcessId() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(::getpid());
+#endif
+}
+
+// Directories of another host age out by time alone: their process ids
+// mean nothing here, and a session may keep a job for hours.
+constexpr auto kForeignJobAge = std::chrono::hours(24);
+
+// This machine's name as it appears in job directory names: letters and
+// digits only, since '-' separates the fields.
+const std::string& localHost() {
+    static const std::string host = [] {
+        std::string name;
+#ifdef _WIN32
+        char buffer[MAX_COMPUTERNAME_LENGTH + 1] = {};
+        DWORD length = sizeof buffer;
+        if (GetComputerNameA(buffer, &length)) {
+            name.assign(buffer, length);
+        }
+#else
+        char buffer[256] = {};
+        if (::gethostname(buffer, sizeof buffer - 1) == 0) {
+            name = buffer;
+        }
+#endif
+        std::string cleaned;
+        for (char c : name.substr(0, 32)) {
+            bool plain = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            cleaned += plain ? c : '_';
+        }
+        return cleaned.empty() ? std::string("host") : cleaned;
+    }();
+    return host;
+}
+
+struct Owner {
+    std::string host;
+    unsigned long pid = 0;
+};
+
+// Host and process id of a name made by JobWorkspace,
+// job-<host>-<pid>-XXXXXX; false for any entry not named job-*. A job-*
+// name without both, such as job-<pid>-XXXXXX of older versions, gets an
+// empty host and so ages out like another host's.
+bool ownerOf(const std::string& name, Owner& owner) {
+    if (name.compare(0, kPrefix.size(), kPrefix) != 0) {
+        return false;
+    }
+    owner = Owner{};
+    std::size_t hostEnd = name.find('-', kPrefix.size());
+    std::size_t pidEnd = hostEnd == std::string::npos ? hostEnd : name.find('-', hostEnd + 1);
+    if (pidEnd == std::string::npos) {
+        return true;
+    }
+    try {
+        std::size_t digits = 0;
+        std::string pid = name.substr(hostEnd + 1, pidEnd - hostEnd - 1);
+        owner.pid = std::stoul(pid, &digits);
+        if (digits == pid.size() && owner.pid != 0) {
+            owner.host = name.substr(kPrefix.size(), hostEnd - kPrefix.size());
+        }
+    } catch (const std::exception&) {
+        owner.pid = 0;
+    }
+    return true;
+}
+
+bool processRunning(unsigned long pid) {
+#ifdef _WIN32
+    // Without a cheap liveness check every owner counts as running; such
+    // directories only go through the size limit.
+    (void)pid;
+    return true;
+#else
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+std::uintmax_t sizeOf(const fs::path& directory) {
+    std::uintmax_t total = 0;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(directory, error), end; !error && it != end;
+         it.increment(error)) {
+        std::error_code sizeError;
+        if (it->is_regular_file(sizeError)) {
+            std::uintmax_t size = it->file_size(sizeError);
+            total += sizeError ? 0 : size;
+        }
+    }
+    return total;
+}
+
+// A name no other thread or process picks at the same time.
+std::string uniqueSuffix() {
+    static thread_local std::mt19937_64 random(std::random_device{}());
+    const char* digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    std::string suffix;
+    for (int i = 0; i < 12; ++i) {
+        suffix += digits[random() % 36];
+    }
+    return suffix;
+}
+
+}  // namespace
+
+JobWorkspace::JobWorkspace(const fs::path& root) {
+    std::error_code error;
+    fs::create_directories(root, error);
+    std::string base =
+        (root / (kPrefix + localHost() + "-" + std::to_string(currentProcessId()) + "-")).string();
+#ifdef _WIN32
+    for (int attempt = 0; attempt < 100 && path_.empty(); ++attempt) {
+        fs::path candidate = base + uniqueSuffix();
+        if (fs::create_directory(candidate, error)) {
+            path_ = candidate;
+        }
+    }
+#else
+    std::string pattern = base + "XXXXXX";
+    if (::mkdtemp(pattern.data()) != nullptr) {
+        path_ = pattern;
+    }
+#endif
+    if (path_.empty()) {
+        throw std::runtime_error("Не удалось создать рабочую папку в " + root.string());
+    }
+}
+
+JobWorkspace::JobWorkspace(JobWorkspace&& other) noexcept : path_(std::move(other.path_)) {
+    other.path_.clear();
+}
+
+JobWorkspace::~JobWorkspace() {
+    if (!path_.empty()) {
+        std::error_code ignored;
+        fs::remove_all(path_, ignored);
+    }
+}
+
+void writeFileAtomically(const fs::path& target, const std::string& content) {
+    fs::path temporary = target;
+    temporary += "." + uniqueSuffix() + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        out << content;
+        if (!out.flush()) {
+            std::error_code ignored;
+            fs::remove(temporary, ignored);
+            throw std::runtime_error("Не удалось записать файл: " + target.string());
+        }
+    }
+    fs::rename(temporary, target);
+}
+
+WorkspaceSweep sweepWorkspaceRoot(const fs::path& root, std::uintmax_t maxBytes) {
+    struct Entry {
+        fs::path path;
+        unsigned long owner;
+        fs::file_time_type modified;
+        std::uintmax_t bytes;
+    };
+    WorkspaceSweep sweep;
+    std::vector<Entry> kept;
+    auto foreignStaleBefore = fs::file_time_type::clock::now() - kForeignJobAge;
+    std::error_code error;
+    for (fs::directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        Owner owner;
+        std::error_code typeError;
+        if (!ownerOf(it->path().filename().string(), owner) || !it->is_directory(typeError)) {
+            continue;
+        }
+        Entry entry{it->path(), owner.pid, it->last_write_time(typeError), sizeOf(it->path())};
+        // Another host's process ids cannot be checked from here, and its
+        // jobs are not this host's to evict for space.
+        bool local = owner.host == localHost();
+        bool abandoned = local ? owner.pid != currentProcessId() && !processRunning(owner.pid)
+                               : entry.modified < foreignStaleBefore;
+        std::error_code removeError;
+        if (abandoned && fs::remove_all(entry.path, removeError) != static_cast<std::uintmax_t>(-1)) {
+            ++sweep.removed;
+            sweep.freedBytes += entry.bytes;
+            continue;
+        }
+        sweep.remainingBytes += entry.bytes;
+        if (local) {
+            kept.push_back(std::move(entry));
+        }
+    }
+
+    std::sort(kept.begin(), kept.end(),
+              [](const Entry& a, const Entry& b) { return a.modified < b.modified; });
+    auto staleBefore = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (const Entry& entry : kept) {
+        if (sweep.remainingBytes <= maxBytes) {
+            break;
+        }
+        if (entry.owner == currentProcessId() || entry.modified > staleBefore) {
+            continue;
+        }
+        std::error_code removeError;
+        if (fs::remove_all(entry.path, removeError) != static_cast<std::uintmax_t>(-1)) {
+            ++sweep.removed;
+            sweep.freedBytes += entry.bytes;
+            sweep.remainingBytes -= entry.bytes;
+        }
+    }
+    return sweep;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace bearlang {
+
+// A private directory for one job (a compile and the runs of its binary)
+// under a shared root, so jobs of other terminals or other threads never
+// touch its files. The name carries the owner's process id, which lets
+// sweepWorkspaceRoot tell the directories of running jobs from what crashed
+// ones left behind; it also carries the host name, since a root on a shared
+// disk holds the jobs of other machines too. The directory and its contents
+// are removed on destruction.
+class JobWorkspace {
+public:
+    // Creates root/job-<host>-<pid>-XXXXXX, and root itself if needed. Throws
+    // std::runtime_error when either cannot be created.
+    explicit JobWorkspace(const std::filesystem::path& root);
+    ~JobWorkspace();
+
+    JobWorkspace(JobWorkspace&& other) noexcept;
+    JobWorkspace& operator=(JobWorkspace&&) = delete;
+    JobWorkspace(const JobWorkspace&) = delete;
+    JobWorkspace& operator=(const JobWorkspace&) = delete;
+
+    const std::filesystem::path& path() const {
+        return path_;
+    }
+
+    std::filesystem::path file(const std::string& name) const {
+        return path_ / name;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Writes `content` to a temporary file next to `target` and renames it over
+// `target`, so a reader sees either the previous file or the whole new one.
+void writeFileAtomically(const std::filesystem::path& target, const std::string& content);
+
+struct WorkspaceSweep {
+    std::size_t removed = 0;
+    std::uintmax_t freedBytes = 0;
+    std::uintmax_t remainingBytes = 0;
+};
+
+// Removes job directories under `root` whose process on this host has
+// exited. If the root still holds more than `maxBytes`, also removes the
+// oldest directories of other local processes untouched for an hour (their
+// owner most likely died and its id was reused) until it fits. Directories
+// of this process are kept. A root may be shared between hosts: directories
+// another host made are only removed once untouched for a day.
+WorkspaceSweep sweepWorkspaceRoot(const std::filesystem::path& root, std::uintmax_t maxBytes);
+
+}  // namespace bearlang
@@ -0,0 +1,317 @@
+#include "zygote.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace bearlang {
+
+const char* const Zygote::kEntryPoint = "bearlang_main";
+
+#ifdef __linux__
+
+namespace {
+
+// What the server sends back for every run.
+struct Reply {
+    // False when the object could not be loaded or the fork failed.
+    bool started;
+    int status;
+    timeval user;
+    timeval system;
+};
+
+// Longest library path a request carries.
+constexpr std::size_t kPathLimit = 4096;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+double toMilliseconds(const timeval& time) {
+    return static_cast<double>(time.tv_sec) * 1000.0 + static_cast<double>(time.tv_usec) / 1000.0;
+}
+
+// Closed on destruction.
+struct Descriptor {
+    int fd = -1;
+
+    ~Descriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+// A request: the library path, with stdin, stdout and stderr of the run
+// attached as SCM_RIGHTS.
+bool sendRequest(int socket, const std::string& path, const int (&fds)[3]) {
+    iovec data{const_cast<char*>(path.data()), path.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof fds)] = {};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof control;
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof fds);
+    std::memcpy(CMSG_DATA(header), fds, sizeof fds);
+    ssize_t sent;
+    while ((sent = ::sendmsg(socket, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+    }
+    return sent == static_cast<ssize_t>(path.size());
+}
+
+// The path length, or -1 when the client is gone or sent no descriptors.
+ssize_t receiveRequest(int socket, char* path, int (&fds)[3]) {
+    iovec data{path, kPathLimit};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof fds)] = {};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof control;
+    ssize_t received;
+    while ((received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR) {
+    }
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (received <= 0 || header == nullptr || header->cmsg_type != SCM_RIGHTS ||
+        header->cmsg_len != CMSG_LEN(sizeof fds)) {
+        return -1;
+    }
+    std::memcpy(fds, CMSG_DATA(header), sizeof fds);
+    return received;
+}
+
+// The server's loop: one request, one forked run, one reply.
+[[noreturn]] void serve(int socket) {
+    void* library = nullptr;
+    int (*entry)() = nullptr;
+    std::string loaded;
+    char path[kPathLimit + 1];
+    while (true) {
+        int fds[3];
+        ssize_t length = receiveRequest(socket, path, fds);
+        if (length < 0) {
+            ::_exit(0);
+        }
+        path[length] = '\0';
+        if (loaded != path) {
+            if (library != nullptr) {
+                ::dlclose(library);
+            }
+            library = ::dlopen(path, RTLD_NOW | RTLD_LOCAL);
+            entry = library != nullptr
+                        ? reinterpret_cast<int (*)()>(::dlsym(library, Zygote::kEntryPoint))
+                        : nullptr;
+            loaded = entry != nullptr ? path : "";
+        }
+
+        Reply reply{};
+        pid_t child = entry != nullptr ? ::fork() : -1;
+        if (child == 0) {
+            // As runProcess leaves it for a spawned binary.
+            std::signal(SIGPIPE, SIG_DFL);
+            for (int target = 0; target < 3; ++target) {
+                ::dup2(fds[target], target);
+            }
+            int status = entry();
+            // What returning from main() would write out. bearlang_app's
+            // own atexit handlers and destructors are skipped, and so are
+            // any the program registers.
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+            ::_exit(status);
+        }
+        for (int fd : fds) {
+            ::close(fd);
+        }
+        if (child > 0) {
+            rusage usage{};
+            while (::wait4(child, &reply.status, 0, &usage) < 0 && errno == EINTR) {
+            }
+            reply.started = true;
+            reply.user = usage.ru_utime;
+            reply.system = usage.ru_stime;
+        }
+        if (::send(socket, &reply, sizeof reply, MSG_NOSIGNAL) != sizeof reply) {
+            ::_exit(0);
+        }
+    }
+}
+
+// An anonymous file standing in for a pipe: the run writes all of it before
+// anyone reads, so a large output cannot block the child.
+int memoryFile(const char* name) {
+    return ::memfd_create(name, MFD_CLOEXEC);
+}
+
+bool writeAll(int fd, const std::string& text) {
+    std::size_t written = 0;
+    while (written < text.size()) {
+        ssize_t n = ::write(fd, text.data() + written, text.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    return ::lseek(fd, 0, SEEK_SET) == 0;
+}
+
+std::string readAll(int fd) {
+    std::string text;
+    if (::lseek(fd, 0, SEEK_SET) != 0) {
+        return text;
+    }
+    char buffer[65536];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof buffer)) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        text.append(buffer, static_cast<std::size_t>(n));
+    }
+    return text;
+}
+
+// The descriptor a run writes `mode` to; `owned` keeps one opened for it.
+int streamFor(ChildStream mode, int inherited, const char* name, Descriptor& owned) {
+    switch (mode) {
+        case ChildStream::Inherit:
+            return inherited;
+        case ChildStream::Discard:
+            owned.fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+            return owned.fd;
+        case ChildStream::Capture:
+            owned.fd = memoryFile(name);
+            return owned.fd;
+    }
+    return -1;
+}
+
+}  // namespace
+
+bool Zygote::available() {
+    return true;
+}
+
+Zygote::Zygote() {
+    int ends[2];
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, ends) != 0) {
+        throw std::runtime_error("Не удалось создать сокет для fork-сервера");
+    }
+    // Whatever is still buffered would be written again by the server.
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(ends[0]);
+        serve(ends[1]);
+    }
+    ::close(ends[1]);
+    if (pid < 0) {
+        ::close(ends[0]);
+        throw std::runtime_error("Не удалось запустить fork-сервер");
+    }
+    socket_ = ends[0];
+    pid_ = pid;
+}
+
+Zygote::~Zygote() {
+    // End of requests: the server exits.
+    ::close(socket_);
+    int status = 0;
+    while (::waitpid(pid_, &status, 0) < 0 && errno == EINTR) {
+    }
+}
+
+ProcessResult Zygote::run(const std::filesystem::path& library, const ProcessOptions& options) {
+    ProcessResult result;
+    auto start = std::chrono::steady_clock::now();
+    Descriptor in;
+    Descriptor out;
+    Descriptor err;
+    int fds[3] = {STDIN_FILENO, -1, -1};
+    if (options.input) {
+        in.fd = memoryFile("bearlang_stdin");
+        if (in.fd < 0 || !writeAll(in.fd, *options.input)) {
+            return result;
+        }
+        fds[0] = in.fd;
+    }
+    fds[1] = streamFor(options.output, STDOUT_FILENO, "bearlang_stdout", out);
+    fds[2] = streamFor(options.errors, STDERR_FILENO, "bearlang_stderr", err);
+    std::string path = std::filesystem::absolute(library).string();
+    if (fds[1] < 0 || fds[2] < 0 || path.size() > kPathLimit || !sendRequest(socket_, path, fds)) {
+        return result;
+    }
+
+    Reply reply{};
+    ssize_t received;
+    while ((received = ::recv(socket_, &reply, sizeof reply, 0)) < 0 && errno == EINTR) {
+    }
+    if (received != sizeof reply || !reply.started) {
+        return result;
+    }
+    result.started = true;
+    result.wallMs = millisecondsSince(start);
+    result.userMs = toMilliseconds(reply.user);
+    result.systemMs = toMilliseconds(reply.system);
+    if (WIFEXITED(reply.status)) {
+        result.exitCode = WEXITSTATUS(reply.status);
+    } else if (WIFSIGNALED(reply.status)) {
+        result.signal = WTERMSIG(reply.status);
+    }
+    if (options.output == ChildStream::Capture) {
+        result.output = readAll(out.fd);
+    }
+    if (options.errors == ChildStream::Capture) {
+        result.errors = readAll(err.fd);
+    }
+    return result;
+}
+
+#else
+
+bool Zygote::available() {
+    return false;
+}
+
+Zygote::Zygote() {
+    throw std::runtime_error("fork-сервер есть только в Linux");
+}
+
+Zygote::~Zygote() = default;
+
+ProcessResult Zygote::run(const std::filesystem::path&, const ProcessOptions&) {
+    return ProcessResult();
+}
+
+#endif
+
+}  // namespace bearlang
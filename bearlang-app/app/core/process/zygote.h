@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include "process.h"
+
+namespace bearlang {
+
+// A fork server for programs built as shared objects (g++ -fPIC -shared,
+// with CodegenOptions::entryPoint set to kEntryPoint). The server is a
+// forked copy of bearlang_app, so the C and C++ runtimes are already loaded
+// and initialised. It dlopens each object once, on its first run. Every run
+// then forks the server; the child gets the run's stdin, stdout and stderr
+// (passed over a socket), calls the entry point and exits with its result.
+// A run costs one fork and no exec, dynamic linking or startup code, which
+// is what repeated test inputs of one program pay for. The program's atexit
+// handlers do not run, so lineCountsPath does not work here. Linux only.
+class Zygote {
+public:
+    // extern "C" int bearlang_main(): the symbol every run calls.
+    static const char* const kEntryPoint;
+
+    // False where there is no fork server; the constructor then throws.
+    static bool available();
+
+    // Forks the server. Call it while bearlang_app still has one thread: a
+    // forked copy of a threaded process may inherit a lock another thread
+    // held. Throws std::runtime_error when the server cannot start.
+    Zygote();
+    // Stops the server and waits for it.
+    ~Zygote();
+
+    Zygote(const Zygote&) = delete;
+    Zygote& operator=(const Zygote&) = delete;
+
+    // Runs `library` the way runProcess runs a binary, with the same meaning
+    // of `options` (environment aside, which is not supported). `started`
+    // is false when the object cannot be loaded or has no entry point. The
+    // server keeps only the last object loaded, so runs of one program
+    // should come together.
+    ProcessResult run(const std::filesystem::path& library, const ProcessOptions& options = {});
+
+private:
+    int socket_ = -1;
+    int pid_ = -1;
+};
+
+}  // namespace bearlang
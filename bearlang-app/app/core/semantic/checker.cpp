@@ -0,0 +1,182 @@
+#include "checker.h"
+
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "typing.h"
+
+namespace bearlang {
+
+namespace {
+
+// Operators as the learner wrote them, not as the C++ spelling stored in the AST.
+std::string displayOperator(const std::string& op) {
+    if (op == "&&") return "и";
+    if (op == "||") return "или";
+    if (op == "!") return "не";
+    return op;
+}
+
+class Checker {
+public:
+    Checker() {
+        scopes_.emplace_back();
+    }
+
+    void checkBlock(const std::vector<StmtPtr>& statements) {
+        scopes_.emplace_back();
+        for (const auto& stmt : statements) {
+            checkStatement(*stmt);
+        }
+        scopes_.pop_back();
+    }
+
+    void checkStatements(const std::vector<StmtPtr>& statements) {
+        for (const auto& stmt : statements) {
+            checkStatement(*stmt);
+        }
+    }
+
+private:
+    ValueType lookup(const std::string& name) const {
+        for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) {
+                return found->second;
+            }
+        }
+        throw SemanticError("Неизвестная переменная '" + name + "'");
+    }
+
+    void expectAssignable(ValueType target, ValueType value, const std::string& name) const {
+        if ((target == ValueType::String) != (value == ValueType::String)) {
+            std::ostringstream oss;
+            oss << "Нельзя присвоить значение типа " << typeName(value) << " переменной '" << name
+                << "' типа " << typeName(target);
+            throw SemanticError(oss.str());
+        }
+    }
+
+    void expectCondition(const Expression& condition, const std::string& context) {
+        ValueType type = checkExpression(condition);
+        if (!isNumeric(type)) {
+            throw SemanticError("Условие " + context + " должно быть логическим или числовым");
+        }
+    }
+
+    void checkStatement(const Statement& statement) {
+        switch (statement.kind()) {
+            case StatementKind::VarDecl: {
+                const auto& decl = static_cast<const VarDeclStmt&>(statement);
+                // Declared before the initializer is checked, as in the
+                // generated C++.
+                scopes_.back()[decl.name] = decl.type;
+                if (decl.initializer) {
+                    expectAssignable(decl.type, checkExpression(*decl.initializer), decl.name);
+                }
+                break;
+            }
+            case StatementKind::Assign: {
+                const auto& assign = static_cast<const AssignStmt&>(statement);
+                ValueType target = lookup(assign.name);
+                expectAssignable(target, checkExpression(*assign.value), assign.name);
+                break;
+            }
+            case StatementKind::Input: {
+                const auto& input = static_cast<const InputStmt&>(statement);
+                lookup(input.name);
+                break;
+            }
+            case StatementKind::Output: {
+                const auto& output = static_cast<const OutputStmt&>(statement);
+                checkExpression(*output.value);
+                break;
+            }
+            case StatementKind::If: {
+                const auto& ifStmt = static_cast<const IfStmt&>(statement);
+                for (const auto& branch : ifStmt.branches) {
+                    expectCondition(*branch.condition, "'если'");
+                    checkBlock(branch.body);
+                }
+                if (ifStmt.hasElse) {
+                    checkBlock(ifStmt.elseBranch);
+                }
+                break;
+            }
+            case StatementKind::While: {
+                const auto& loop = static_cast<const WhileStmt&>(statement);
+                expectCondition(*loop.condition, "'пока'");
+                checkBlock(loop.body);
+                break;
+            }
+            case StatementKind::ForRange: {
+                const auto& loop = static_cast<const ForRangeStmt&>(statement);
+                if (!isNumeric(loop.type)) {
+                    throw SemanticError("Счётчик цикла 'для' должен быть числом");
+                }
+                scopes_.emplace_back();
+                scopes_.back()[loop.name] = loop.type;
+                expectAssignable(loop.type, checkExpression(*loop.from), loop.name);
+                if (!isNumeric(checkExpression(*loop.to))) {
+                    throw SemanticError("Граница цикла 'для' должна быть числом");
+                }
+                checkBlock(loop.body);
+                scopes_.pop_back();
+                break;
+            }
+        }
+    }
+
+    ValueType checkExpression(const Expression& expr) {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return static_cast<const LiteralExpr&>(expr).type;
+            case ExpressionKind::Variable:
+                return lookup(static_cast<const VariableExpr&>(expr).name);
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                ValueType operand = checkExpression(*unary.operand);
+                if (!isNumeric(operand)) {
+                    std::ostringstream oss;
+                    oss << "Операция '" << displayOperator(unary.op) << "' не применима к типу "
+                        << typeName(operand);
+                    throw SemanticError(oss.str());
+                }
+                return unaryResultType(unary.op, operand);
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                ValueType left = checkExpression(*binary.left);
+                ValueType right = checkExpression(*binary.right);
+                bool strings = left == ValueType::String && right == ValueType::String;
+                bool numbers = isNumeric(left) && isNumeric(right);
+                bool comparison = binary.op == "==" || binary.op == "<" || binary.op == "<=" ||
+                                  binary.op == ">" || binary.op == ">=";
+                bool valid = numbers || (strings && (binary.op == "+" || comparison));
+                if (binary.op == "%" && (left == ValueType::Double || right == ValueType::Double)) {
+                    valid = false;
+                }
+                if (!valid) {
+                    std::ostringstream oss;
+                    oss << "Операция '" << displayOperator(binary.op) << "' не применима к типам "
+                        << typeName(left) << " и " << typeName(right);
+                    throw SemanticError(oss.str());
+                }
+                return binaryResultType(binary.op, left, right);
+            }
+        }
+        return ValueType::Unknown;
+    }
+
+    std::vector<std::unordered_map<std::string, ValueType>> scopes_;
+};
+
+}  // namespace
+
+void checkProgram(const Program& program) {
+    Checker checker;
+    checker.checkStatements(program.statements);
+}
+
+}  // namespace bearlang
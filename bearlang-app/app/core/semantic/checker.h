@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+class SemanticError : public std::runtime_error {
+public:
+    explicit SemanticError(const std::string& message) : std::runtime_error(message) {}
+};
+
+// Rejects programs whose generated C++ would not compile: unknown names and
+// operators or assignments that mix strings with numbers. Engines that run a
+// Program in-process call this first so they accept exactly what g++ accepts.
+void checkProgram(const Program& program);
+
+}  // namespace bearlang
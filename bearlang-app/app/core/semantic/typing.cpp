@@ -0,0 +1,55 @@
+#include "typing.h"
+
+namespace bearlang {
+
+bool isNumeric(ValueType type) {
+    return type == ValueType::Integer || type == ValueType::Double || type == ValueType::Boolean;
+}
+
+std::string typeName(ValueType type) {
+    switch (type) {
+        case ValueType::Integer: return "целое";
+        case ValueType::Double: return "дробное";
+        case ValueType::String: return "строка";
+        case ValueType::Boolean: return "логика";
+        case ValueType::Unknown: default: return "неизвестный тип";
+    }
+}
+
+ValueType unaryResultType(const std::string& op, ValueType operand) {
+    if (op == "!") {
+        return ValueType::Boolean;
+    }
+    if (operand == ValueType::Double) {
+        return ValueType::Double;
+    }
+    if (operand == ValueType::Integer || operand == ValueType::Boolean) {
+        return ValueType::Integer;
+    }
+    return ValueType::Unknown;
+}
+
+ValueType binaryResultType(const std::string& op, ValueType left, ValueType right) {
+    if (op == "&&" || op == "||" || op == "==" || op == "<" || op == "<=" || op == ">" ||
+        op == ">=") {
+        return ValueType::Boolean;
+    }
+    if (op == "+" && (left == ValueType::String || right == ValueType::String)) {
+        return ValueType::String;
+    }
+    if (!isNumeric(left) || !isNumeric(right)) {
+        return ValueType::Unknown;
+    }
+    if (op == "^") {
+        return ValueType::Double;
+    }
+    if (op == "%") {
+        return ValueType::Integer;
+    }
+    if (left == ValueType::Double || right == ValueType::Double) {
+        return ValueType::Double;
+    }
+    return ValueType::Integer;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// Static result types of BearLang operators. They follow the C++ that the
+// code generator emits: `bool` promotes to `int`, any `double` operand makes
+// the result `double`, `^` is `std::pow` and `+` on strings concatenates.
+ValueType unaryResultType(const std::string& op, ValueType operand);
+ValueType binaryResultType(const std::string& op, ValueType left, ValueType right);
+
+// `целое`, `дробное` and `логика`: the types arithmetic and conditions accept.
+bool isNumeric(ValueType type);
+
+// BearLang keyword of a type, for messages shown to learners.
+std::string typeName(ValueType type);
+
+}  // namespace bearlang
@@ -0,0 +1,158 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/process/zygote.h"
+#include "core/vm/compiler.h"
+#include "core/vm/executor.h"
+#include "native_build.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    auto index = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+void printBatchRow(const std::string& name, double totalMs, const std::vector<double>& latencies) {
+    std::cout << "  " << name << ": " << totalMs << " мс, "
+              << static_cast<double>(latencies.size()) * 1000.0 / totalMs << " запусков/с, задержка p50 "
+              << percentile(latencies, 0.5) << " мс, p99 " << percentile(latencies, 0.99) << " мс\n";
+}
+
+}  // namespace
+
+int runBatch(std::size_t runs,
+             const fs::path& sourcePath,
+             const fs::path& inputPath,
+             const fs::path& workRoot,
+             CompileCache* compileCache,
+             PrecompiledHeader* runtimeHeader) {
+    Program program;
+    std::string input;
+    if (!loadMeasuredProgram(sourcePath, inputPath, program, input)) {
+        return 1;
+    }
+    // Forked before the pool below starts any thread.
+    std::optional<Zygote> zygote;
+    if (Zygote::available()) {
+        try {
+            zygote.emplace();
+        } catch (const std::exception& ex) {
+            std::cerr << ex.what() << std::endl;
+        }
+    }
+    auto chunk = std::make_shared<const Chunk>(BytecodeCompiler::compile(program));
+    std::cout << "Программа: " << sourcePath.string() << ", запусков: " << runs
+              << ", ядер: " << std::thread::hardware_concurrency() << "\n";
+
+    std::string expected;
+    bool same = true;
+
+    JobWorkspace job(workRoot);
+    fs::path exePath = executablePath(job);
+    std::string cppSource = buildSource(program, CodegenOptions{}, runtimeHeader);
+    if (buildNative(cppSource, {}, job.file("program.cpp"), exePath, compileCache).succeeded()) {
+        ProcessOptions runOptions;
+        runOptions.input = input;
+        runOptions.output = ChildStream::Capture;
+        std::vector<double> latencies;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < runs; ++i) {
+            std::string output = runProcess({exePath.string()}, runOptions).output;
+            latencies.push_back(millisecondsSince(start));
+            if (expected.empty() && same) {
+                expected = output;
+            }
+            same = same && output == expected;
+        }
+        printBatchRow("процессы подряд", millisecondsSince(start), latencies);
+    } else {
+        std::cerr << "Компилятор вернул ошибку, сравниваем только потоки." << std::endl;
+    }
+
+    if (zygote) {
+        // Without the precompiled header: it was built without -fPIC, so g++
+        // would ignore it anyway.
+        CodegenOptions entry;
+        entry.entryPoint = Zygote::kEntryPoint;
+        std::ofstream(job.file("library.cpp")) << buildSource(program, entry, nullptr);
+        fs::path libraryPath = job.file("program.so");
+        ProcessOptions buildOptions;
+        buildOptions.output = ChildStream::Capture;
+        buildOptions.errors = ChildStream::Capture;
+        ProcessResult build = runProcess(
+            gppCommand({"-fPIC", "-shared", job.file("library.cpp").string(), "-o", libraryPath.string()}),
+            buildOptions);
+        if (build.succeeded()) {
+            ProcessOptions runOptions;
+            runOptions.input = input;
+            runOptions.output = ChildStream::Capture;
+            std::vector<double> latencies;
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < runs; ++i) {
+                std::string output = zygote->run(libraryPath, runOptions).output;
+                latencies.push_back(millisecondsSince(start));
+                if (expected.empty() && same) {
+                    expected = output;
+                }
+                same = same && output == expected;
+            }
+            printBatchRow("fork-сервер", millisecondsSince(start), latencies);
+        } else {
+            reportCompileFailure(build);
+        }
+    }
+
+    for (std::size_t threads = 1; threads <= 64; threads *= 2) {
+        std::vector<std::future<BatchResult>> results;
+        results.reserve(runs);
+        auto start = std::chrono::steady_clock::now();
+        WorkStealingPool pool(threads);
+        for (std::size_t i = 0; i < runs; ++i) {
+            results.push_back(submitRun(pool, chunk, input));
+        }
+        std::vector<double> latencies;
+        for (auto& future : results) {
+            BatchResult result = future.get();
+            latencies.push_back(
+                std::chrono::duration<double, std::milli>(result.finished - start).count());
+            std::string output = result.output;
+            if (!result.error.empty()) {
+                output += "Ошибка выполнения: " + result.error + "\n";
+            }
+            if (expected.empty() && same) {
+                expected = output;
+            }
+            same = same && output == expected;
+        }
+        double total = millisecondsSince(start);
+        printBatchRow("потоков: " + std::to_string(threads), total, latencies);
+    }
+    if (same) {
+        std::cout << "Вывод всех запусков совпадает.\n";
+    } else {
+        std::cout << "Вывод запусков отличается.\n";
+    }
+    return same ? 0 : 1;
+}
+
+}  // namespace bearlang
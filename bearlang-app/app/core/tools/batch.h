@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#include "core/process/compile_cache.h"
+#include "core/process/precompiled_header.h"
+
+namespace bearlang {
+
+// --batch, grading-style: the same program `runs` times with the same input,
+// first as the sequential loop over the g++ binary that batches use today,
+// then as a shared object run by a Zygote fork server, then on
+// WorkStealingPool with 1 to 64 threads sharing one compiled chunk.
+// Latency is the time from the start of the batch to the end of a run.
+// Builds go into a JobWorkspace under `workRoot`; `compileCache` may be null.
+int runBatch(std::size_t runs,
+             const std::filesystem::path& sourcePath,
+             const std::filesystem::path& inputPath,
+             const std::filesystem::path& workRoot,
+             CompileCache* compileCache,
+             PrecompiledHeader* runtimeHeader);
+
+}  // namespace bearlang
@@ -0,0 +1,154 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/closure/closure.h"
+#include "core/interpreter/interpreter.h"
+#include "core/interpreter/value.h"
+#include "core/jit/jit.h"
+#include "core/vm/vm.h"
+#include "native_build.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+struct BenchmarkRow {
+    std::string engine;
+    double milliseconds;
+    std::string output;
+};
+
+using InProcessEngine = std::function<void(const Program&, std::istream&, std::ostream&)>;
+
+BenchmarkRow benchmarkInProcess(const std::string& engine,
+                                const InProcessEngine& run,
+                                const Program& program,
+                                const std::string& input) {
+    std::istringstream in(input);
+    std::ostringstream out;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        run(program, in, out);
+    } catch (const RuntimeError& ex) {
+        out << "Ошибка выполнения: " << ex.what() << "\n";
+    }
+    return BenchmarkRow{engine, millisecondsSince(start), out.str()};
+}
+
+}  // namespace
+
+int runBenchmark(const fs::path& sourcePath,
+                 const fs::path& inputPath,
+                 const fs::path& workRoot,
+                 PrecompiledHeader* runtimeHeader) {
+    Program program;
+    std::string input;
+    if (!loadMeasuredProgram(sourcePath, inputPath, program, input)) {
+        return 1;
+    }
+
+    std::vector<BenchmarkRow> rows;
+    rows.push_back(benchmarkInProcess(
+        "интерпретатор",
+        [](const Program& p, std::istream& in, std::ostream& out) { Interpreter::run(p, in, out); },
+        program, input));
+    rows.push_back(benchmarkInProcess(
+        "замыкания",
+        [](const Program& p, std::istream& in, std::ostream& out) { ClosureEngine::run(p, in, out); },
+        program, input));
+    rows.push_back(benchmarkInProcess(
+        "байткод (VM)",
+        [](const Program& p, std::istream& in, std::ostream& out) { VirtualMachine::run(p, in, out); },
+        program, input));
+    if (Jit::available()) {
+        rows.push_back(benchmarkInProcess(
+            "JIT x86-64",
+            [](const Program& p, std::istream& in, std::ostream& out) { Jit::run(p, in, out); },
+            program, input));
+    }
+
+    CodegenOptions codegen;
+    JobWorkspace job(workRoot);
+    fs::path cppPath = job.file("program.cpp");
+    fs::path exePath = executablePath(job);
+    std::string cppSource = buildSource(program, codegen, runtimeHeader);
+    std::ofstream(cppPath) << cppSource;
+
+    ProcessOptions runOptions;
+    runOptions.input = input;
+    runOptions.output = ChildStream::Capture;
+    ProcessResult build = compileCpp(cppPath, exePath);
+    bool compiled = build.succeeded();
+    if (compiled) {
+        ProcessResult run = runProcess({exePath.string()}, runOptions);
+        if (!run.succeeded()) {
+            std::cerr << "g++: программа завершилась с ошибкой: " << describeExit(run) << std::endl;
+        }
+        rows.push_back(BenchmarkRow{"g++: запуск", run.wallMs, std::move(run.output)});
+    } else {
+        reportCompileFailure(build);
+    }
+    // The same build without files, as --diskless does it.
+    std::optional<ProcessResult> memoryBuild;
+    if (compiled && MemoryFile::available()) {
+        MemoryFile binary;
+        memoryBuild = compileInMemory(cppSource, binary);
+        if (memoryBuild->succeeded()) {
+            ProcessResult run = runProcess({binary.executablePath()}, runOptions);
+            rows.push_back(BenchmarkRow{"g++ в памяти: запуск", run.wallMs, std::move(run.output)});
+        }
+    }
+
+    std::cout << "Программа: " << sourcePath.string() << "\n";
+    for (const auto& row : rows) {
+        std::cout << "  " << row.engine << ": " << row.milliseconds << " мс\n";
+    }
+    if (compiled) {
+        std::cout << "  g++: компиляция: " << formatTimes(build) << "\n";
+    }
+    if (memoryBuild) {
+        std::cout << "  g++ в памяти: компиляция: " << formatTimes(*memoryBuild) << "\n";
+    }
+    // What the precompiled header saves: the runtime written into the program.
+    if (compiled && runtimeHeader != nullptr) {
+        fs::path inlinePath = job.file("inline.cpp");
+        std::ofstream(inlinePath) << buildSource(program, codegen, nullptr);
+        ProcessResult inlineBuild = compileCpp(inlinePath, job.file("inline"));
+        if (inlineBuild.succeeded()) {
+            std::cout << "  g++ без PCH: компиляция: " << formatTimes(inlineBuild) << "\n";
+        }
+    }
+    // What the minimal runtime saves: the same program on <iostream>.
+    if (compiled) {
+        fs::path iostreamPath = job.file("iostream.cpp");
+        std::ofstream(iostreamPath) << CodeGenerator::generate(program, codegen);
+        ProcessResult iostreamBuild = compileCpp(iostreamPath, job.file("iostream"));
+        if (iostreamBuild.succeeded()) {
+            std::cout << "  g++ с <iostream>: компиляция: " << formatTimes(iostreamBuild) << "\n";
+        }
+    }
+    bool same = true;
+    for (const auto& row : rows) {
+        if (row.output != rows.front().output) {
+            std::cout << "Вывод отличается: " << row.engine << "\n";
+            same = false;
+        }
+    }
+    if (same) {
+        std::cout << "Вывод всех движков совпадает.\n";
+    }
+    return same && compiled ? 0 : 1;
+}
+
+}  // namespace bearlang
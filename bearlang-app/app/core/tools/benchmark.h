@@ -0,0 +1,18 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/process/precompiled_header.h"
+
+namespace bearlang {
+
+// --benchmark: runs one program on every backend with the same input and
+// reports wall time per backend; g++ compilation and the compiled run are
+// timed apart. Builds go into a JobWorkspace under `workRoot`. Returns the
+// process exit status: 0 when every backend printed the same.
+int runBenchmark(const std::filesystem::path& sourcePath,
+                 const std::filesystem::path& inputPath,
+                 const std::filesystem::path& workRoot,
+                 PrecompiledHeader* runtimeHeader);
+
+}  // namespace bearlang
@@ -0,0 +1,147 @@
+#include "compile_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/interpreter/value.h"
+#include "core/vm/compiler.h"
+#include "core/vm/vm.h"
+#include "native_build.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+int runCompileBatch(const fs::path& directory,
+                    const fs::path& inputPath,
+                    const fs::path& workRoot,
+                    PrecompiledHeader* runtimeHeader) {
+    std::vector<fs::path> files = loadExamples(directory);
+    std::vector<fs::path> names;
+    std::vector<Program> programs;
+    for (const auto& file : files) {
+        try {
+            programs.push_back(parseFile(file));
+            names.push_back(file);
+        } catch (const std::exception& ex) {
+            std::cerr << "Пропущена " << file.string() << ": " << ex.what() << std::endl;
+        }
+    }
+    if (programs.empty()) {
+        std::cerr << "В папке " << directory.string() << " нет программ." << std::endl;
+        return 1;
+    }
+    std::string input;
+    try {
+        if (!inputPath.empty()) {
+            input = readAll(inputPath);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Ошибка: " << ex.what() << std::endl;
+        return 1;
+    }
+
+    CodegenOptions codegen;
+    codegen.minimalRuntime = true;
+    if (runtimeHeader != nullptr) {
+        codegen.runtimeHeaderPath = runtimeHeaderPath(*runtimeHeader).generic_string();
+    }
+    std::size_t count = programs.size();
+    std::size_t shards = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::cout << "Программ: " << count << ", частей: " << shards << "\n";
+
+    JobWorkspace job(workRoot);
+    const std::size_t sampled = std::min<std::size_t>(5, count);
+    double singleMs = 0.0;
+    for (std::size_t i = 0; i < sampled; ++i) {
+        fs::path exePath = job.file("single_" + std::to_string(i));
+        std::string cppSource = CodeGenerator::generate(programs[i], codegen);
+        std::ofstream(job.file("single.cpp")) << cppSource;
+        auto start = std::chrono::steady_clock::now();
+        ProcessResult build = compileCpp(job.file("single.cpp"), exePath);
+        singleMs += millisecondsSince(start);
+        if (!build.succeeded()) {
+            reportCompileFailure(build);
+            return 1;
+        }
+    }
+    singleMs /= static_cast<double>(sampled);
+    std::cout << "  g++ на каждую программу: " << singleMs << " мс на программу, "
+              << 1000.0 / singleMs << " программ/с (по " << sampled << ")\n";
+
+    // Shard s holds programs [first[s], first[s + 1]); a program's id is
+    // its position within its shard.
+    std::vector<std::size_t> first;
+    for (std::size_t s = 0; s <= shards; ++s) {
+        first.push_back(count * s / shards);
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<ProcessResult>> builds;
+    for (std::size_t s = 0; s < shards; ++s) {
+        std::vector<const Program*> shard;
+        for (std::size_t i = first[s]; i < first[s + 1]; ++i) {
+            shard.push_back(&programs[i]);
+        }
+        fs::path cppPath = job.file("shard_" + std::to_string(s) + ".cpp");
+        std::ofstream(cppPath) << CodeGenerator::generateBatch(shard, codegen);
+        fs::path exePath = job.file("shard_" + std::to_string(s));
+        builds.push_back(std::async(std::launch::async, [cppPath, exePath] {
+            return compileCpp(cppPath, exePath);
+        }));
+    }
+    bool compiled = true;
+    for (auto& build : builds) {
+        ProcessResult result = build.get();
+        if (!result.succeeded()) {
+            reportCompileFailure(result);
+            compiled = false;
+        }
+    }
+    double batchMs = millisecondsSince(start);
+    if (!compiled) {
+        return 1;
+    }
+    std::cout << "  g++ на часть: " << batchMs << " мс, " << static_cast<double>(count) * 1000.0 / batchMs
+              << " программ/с\n";
+
+    ProcessOptions runOptions;
+    runOptions.input = input;
+    runOptions.output = ChildStream::Capture;
+    std::size_t mismatched = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t s = 0; s < shards; ++s) {
+        for (std::size_t i = first[s]; i < first[s + 1]; ++i) {
+            ProcessResult run = runProcess(
+                {job.file("shard_" + std::to_string(s)).string(), std::to_string(i - first[s])}, runOptions);
+            std::istringstream in(input);
+            std::ostringstream out;
+            bool failed = false;
+            try {
+                VirtualMachine::execute(BytecodeCompiler::compile(programs[i]), in, out);
+            } catch (const RuntimeError&) {
+                failed = true;
+            }
+            // A runtime error crashes the binary, which loses what stdout
+            // still buffered; only the failure itself is compared.
+            if (failed ? run.succeeded() : !run.succeeded() || run.output != out.str()) {
+                std::cout << "  вывод отличается: " << names[i].string() << "\n";
+                ++mismatched;
+            }
+        }
+    }
+    std::cout << "  запуски и проверка: " << millisecondsSince(start) << " мс\n";
+    if (mismatched == 0) {
+        std::cout << "Вывод всех программ совпадает с байткод-машиной.\n";
+    }
+    return mismatched == 0 ? 0 : 1;
+}
+
+}  // namespace bearlang
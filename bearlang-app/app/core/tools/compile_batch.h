@@ -0,0 +1,21 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/process/precompiled_header.h"
+
+namespace bearlang {
+
+// --compile-batch, grading many submissions at once: every .txt in
+// `directory` goes into CodeGenerator::generateBatch files, one shard per
+// core, and each shard is one g++ run, all of them at the same time.
+// Compile throughput is compared with one g++ run per program, timed on the
+// first few programs. Then every program runs through its shard's
+// dispatcher with the same input, and its output is checked against the
+// bytecode VM.
+int runCompileBatch(const std::filesystem::path& directory,
+                    const std::filesystem::path& inputPath,
+                    const std::filesystem::path& workRoot,
+                    PrecompiledHeader* runtimeHeader);
+
+}  // namespace bearlang
@@ -0,0 +1,153 @@
+#include "heatmap.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "native_build.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+// Line -> count pairs of the JSON an instrumented program writes on exit,
+// `{"lines": {"4": 3000001, ...}}`. False for anything else, so a truncated
+// or foreign file is reported instead of shown as a partial heatmap.
+bool parseLineCounts(const std::string& json, std::map<std::size_t, std::uint64_t>& counts) {
+    std::size_t pos = 0;
+    auto skipSpaces = [&] {
+        while (pos < json.size() && std::isspace(static_cast<unsigned char>(json[pos]))) {
+            ++pos;
+        }
+    };
+    auto expect = [&](const char* token) {
+        skipSpaces();
+        std::size_t length = std::strlen(token);
+        if (json.compare(pos, length, token) != 0) {
+            return false;
+        }
+        pos += length;
+        return true;
+    };
+    auto number = [&](std::uint64_t& value) {
+        skipSpaces();
+        std::size_t start = pos;
+        value = 0;
+        while (pos < json.size() && json[pos] >= '0' && json[pos] <= '9') {
+            std::uint64_t digit = static_cast<std::uint64_t>(json[pos] - '0');
+            if (value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10) {
+                return false;
+            }
+            value = value * 10 + digit;
+            ++pos;
+        }
+        return pos > start;
+    };
+
+    counts.clear();
+    if (!expect("{") || !expect("\"lines\"") || !expect(":") || !expect("{")) {
+        return false;
+    }
+    bool first = true;
+    while (!expect("}")) {
+        std::uint64_t line = 0;
+        std::uint64_t count = 0;
+        if ((!first && !expect(",")) || !expect("\"") || !number(line) || !expect("\"") ||
+            !expect(":") || !number(count)) {
+            return false;
+        }
+        counts[static_cast<std::size_t>(line)] = count;
+        first = false;
+    }
+    if (!expect("}")) {
+        return false;
+    }
+    skipSpaces();
+    return pos == json.size();
+}
+
+// The source with each line's count and a bar on a logarithmic scale, so
+// lines run a few times stay visible next to a loop run millions of times.
+void printHeatMap(const std::string& source, const std::map<std::size_t, std::uint64_t>& counts) {
+    constexpr int kBarWidth = 20;
+    std::uint64_t hottest = 1;
+    for (const auto& entry : counts) {
+        hottest = std::max(hottest, entry.second);
+    }
+    std::istringstream lines(source);
+    std::size_t number = 0;
+    std::cout << "строка   выполнений  " << std::string(kBarWidth, ' ') << "  | текст\n";
+    for (std::string text; std::getline(lines, text);) {
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        ++number;
+        std::cout << std::setw(6) << number;
+        auto found = counts.find(number);
+        if (found == counts.end()) {
+            std::cout << std::string(13 + kBarWidth + 2, ' ');
+        } else {
+            int width = static_cast<int>(std::ceil(kBarWidth * std::log1p(static_cast<double>(found->second)) /
+                                                   std::log1p(static_cast<double>(hottest))));
+            std::cout << std::setw(13) << found->second << "  " << std::string(width, '#')
+                      << std::string(kBarWidth - width, ' ');
+        }
+        std::cout << "  | " << text << "\n";
+    }
+}
+
+}  // namespace
+
+int runHeatMap(const fs::path& sourcePath,
+               const fs::path& inputPath,
+               const fs::path& workRoot,
+               PrecompiledHeader* runtimeHeader) {
+    Program program;
+    std::string input;
+    if (!loadMeasuredProgram(sourcePath, inputPath, program, input)) {
+        return 1;
+    }
+    JobWorkspace job(workRoot);
+    fs::path cppPath = job.file("program.cpp");
+    fs::path exePath = executablePath(job);
+    fs::path countsPath = job.file("counts.json");
+
+    CodegenOptions codegen;
+    codegen.lineCountsPath = fs::absolute(countsPath).string();
+    std::ofstream(cppPath) << buildSource(program, codegen, runtimeHeader);
+    int status = 1;
+    ProcessResult build = compileCpp(cppPath, exePath);
+    if (!build.succeeded()) {
+        reportCompileFailure(build);
+    } else {
+        ProcessOptions runOptions;
+        runOptions.input = input;
+        runOptions.output = ChildStream::Discard;
+        ProcessResult run = runProcess({exePath.string()}, runOptions);
+        std::map<std::size_t, std::uint64_t> counts;
+        if (!fs::exists(countsPath)) {
+            std::cerr << "Программа завершилась аварийно (" << describeExit(run)
+                      << "), счётчики строк не записаны." << std::endl;
+        } else if (!parseLineCounts(readAll(countsPath), counts)) {
+            std::cerr << "Счётчики строк повреждены: " << countsPath.string() << std::endl;
+        } else {
+            std::cout << "Программа: " << sourcePath.string() << ", запуск: " << formatTimes(run) << "\n";
+            printHeatMap(readAll(sourcePath), counts);
+            status = 0;
+        }
+    }
+    return status;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <filesystem>
+
+#include "core/process/precompiled_header.h"
+
+namespace bearlang {
+
+// --heatmap: builds the program with per-line counters
+// (CodegenOptions::lineCountsPath), runs the binary on the input and shows
+// how often each line ran; for programs that have to be measured natively
+// rather than on the VM. The build goes into a JobWorkspace under
+// `workRoot`.
+int runHeatMap(const std::filesystem::path& sourcePath,
+               const std::filesystem::path& inputPath,
+               const std::filesystem::path& workRoot,
+               PrecompiledHeader* runtimeHeader);
+
+}  // namespace bearlang
@@ -0,0 +1,64 @@
+#include "line_profile.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+#include "core/interpreter/value.h"
+#include "core/vm/compiler.h"
+#include "core/vm/vm.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+// Formats and then drops everything written to it, so a program cut off
+// after printing for seconds costs no memory.
+class DiscardBuffer : public std::streambuf {
+protected:
+    int overflow(int ch) override {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return traits_type::not_eof(ch);
+    }
+
+private:
+    char buffer_[4096];
+};
+
+}  // namespace
+
+int runLineProfile(const fs::path& sourcePath, const fs::path& inputPath) {
+    Program program;
+    std::string input;
+    if (!loadMeasuredProgram(sourcePath, inputPath, program, input)) {
+        return 1;
+    }
+    Chunk chunk = BytecodeCompiler::compile(program);
+    VmLineProfile profile;
+    profile.limit = std::chrono::seconds(10);
+    VmOptions vmOptions;
+    vmOptions.lineProfile = &profile;
+    std::istringstream in(input);
+    DiscardBuffer discard;
+    std::ostream out(&discard);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        VirtualMachine::execute(chunk, in, out, vmOptions);
+    } catch (const RuntimeError& ex) {
+        std::cerr << "Ошибка выполнения: " << ex.what() << std::endl;
+    }
+    std::cout << "Программа: " << sourcePath.string() << ", время: " << millisecondsSince(start)
+              << " мс";
+    if (profile.stopped) {
+        std::cout << ", остановлена через " << profile.limit.count() / 1000 << " с";
+    }
+    std::cout << "\n" << formatLineProfile(profile, chunk, readAll(sourcePath));
+    return 0;
+}
+
+}  // namespace bearlang
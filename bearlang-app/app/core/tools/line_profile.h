@@ -0,0 +1,13 @@
+#pragma once
+
+#include <filesystem>
+
+namespace bearlang {
+
+// --line-profile: runs the program on the VM counting operations and time
+// per source line and prints them next to the source; its output is
+// discarded. A program still running after 10 seconds is cut off like a
+// grading timeout would, and the report covers the part that ran.
+int runLineProfile(const std::filesystem::path& sourcePath, const std::filesystem::path& inputPath);
+
+}  // namespace bearlang
@@ -0,0 +1,219 @@
+#include "native_build.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+// What -march=native means on this machine: g++'s list of the target
+// options it enables here, hashed. Empty when g++ cannot report it.
+const std::string& nativeTarget() {
+    static const std::string target = [] {
+        ProcessOptions options;
+        options.output = ChildStream::Capture;
+        options.errors = ChildStream::Discard;
+        ProcessResult report = runProcess({"g++", "-march=native", "-Q", "--help=target"}, options);
+        return report.succeeded() && !report.output.empty() ? fnv1aHex(report.output) : std::string();
+    }();
+    return target;
+}
+
+}  // namespace
+
+const std::vector<std::string> kGppFlags{"-std=gnu++11", "-fno-exceptions"};
+
+std::vector<std::string> gppCommand(std::initializer_list<std::string> arguments) {
+    std::vector<std::string> command{"g++"};
+    command.insert(command.end(), kGppFlags.begin(), kGppFlags.end());
+    command.insert(command.end(), arguments);
+    return command;
+}
+
+const std::vector<std::string>& profileFlags(BuildProfile profile) {
+    static const std::vector<std::string> instant;
+    static const std::vector<std::string> fast{"-O2", "-march=native", "-static"};
+    return profile == BuildProfile::Fast ? fast : instant;
+}
+
+ProcessResult compileCpp(const fs::path& cppPath,
+                         const fs::path& exePath,
+                         const std::vector<std::string>& flags) {
+    ProcessOptions options;
+    options.output = ChildStream::Capture;
+    options.errors = ChildStream::Capture;
+    fs::path partialPath = exePath;
+    partialPath += ".partial";
+    std::vector<std::string> command = gppCommand({});
+    command.insert(command.end(), flags.begin(), flags.end());
+    command.insert(command.end(), {cppPath.string(), "-o", partialPath.string()});
+    ProcessResult build = runProcess(command, options);
+    if (build.succeeded()) {
+        fs::rename(partialPath, exePath);
+    }
+    return build;
+}
+
+ProcessResult compileInMemory(const std::string& cppSource,
+                              const MemoryFile& binary,
+                              const std::vector<std::string>& flags) {
+    ProcessOptions options;
+    options.input = cppSource;
+    options.output = ChildStream::Capture;
+    options.errors = ChildStream::Capture;
+    std::error_code ignored;
+    if (fs::is_directory("/dev/shm", ignored)) {
+        options.environment.push_back("TMPDIR=/dev/shm");
+    }
+    std::vector<std::string> command = gppCommand({"-pipe"});
+    command.insert(command.end(), flags.begin(), flags.end());
+    command.insert(command.end(), {"-x", "c++", "-", "-o", binary.writePath()});
+    return runProcess(command, options);
+}
+
+void reportCompileFailure(const ProcessResult& build) {
+    std::cerr << "Компилятор вернул ошибку (" << describeExit(build) << ")." << std::endl;
+    std::cerr << build.output << build.errors;
+}
+
+std::string formatTimes(const ProcessResult& result) {
+    std::ostringstream text;
+    text << result.wallMs << " мс (процессор " << result.userMs + result.systemMs << " мс)";
+    return text.str();
+}
+
+const std::string& compilerIdentity() {
+    static const std::string identity = [] {
+        std::string text = "g++";
+        const char* path = std::getenv("PATH");
+        std::istringstream directories(path != nullptr ? path : "");
+#ifdef _WIN32
+        const char separator = ';';
+        const char* name = "g++.exe";
+#else
+        const char separator = ':';
+        const char* name = "g++";
+#endif
+        for (std::string directory; std::getline(directories, directory, separator);) {
+            std::error_code error;
+            fs::path compiler = fs::canonical(fs::path(directory) / name, error);
+            if (!error && fs::is_regular_file(compiler, error)) {
+                text = compiler.string() + " " + std::to_string(fs::file_size(compiler, error)) + " " +
+                       std::to_string(fs::last_write_time(compiler, error).time_since_epoch().count());
+                break;
+            }
+        }
+        for (const auto& flag : kGppFlags) {
+            text += " " + flag;
+        }
+        return text;
+    }();
+    return identity;
+}
+
+std::string buildKey(const std::string& cppSource, const std::vector<std::string>& flags) {
+    std::string key = compilerIdentity();
+    for (const auto& flag : flags) {
+        key += " " + flag;
+        if (flag == "-march=native") {
+            if (nativeTarget().empty()) {
+                return std::string();
+            }
+            key += "=" + nativeTarget();
+        }
+    }
+    return key + "\n" + cppSource;
+}
+
+bool fetchCachedBuild(CompileCache* cache,
+                      const std::string& cppSource,
+                      const std::vector<std::string>& flags,
+                      const fs::path& exePath) {
+    if (cache == nullptr) {
+        return false;
+    }
+    std::string key = buildKey(cppSource, flags);
+    return !key.empty() && cache->fetch(key, exePath);
+}
+
+ProcessResult compileAndCache(CompileCache* cache,
+                              const std::string& cppSource,
+                              const std::vector<std::string>& flags,
+                              const fs::path& cppPath,
+                              const fs::path& exePath) {
+    std::ofstream(cppPath) << cppSource;
+    ProcessResult build = compileCpp(cppPath, exePath, flags);
+    if (cache != nullptr && build.succeeded()) {
+        std::string key = buildKey(cppSource, flags);
+        if (!key.empty()) {
+            cache->store(key, exePath);
+        }
+    }
+    return build;
+}
+
+NativeBuild buildNative(const std::string& cppSource,
+                        const std::vector<std::string>& flags,
+                        const fs::path& cppPath,
+                        const fs::path& exePath,
+                        CompileCache* cache) {
+    NativeBuild build;
+    build.fromCache = fetchCachedBuild(cache, cppSource, flags, exePath);
+    if (!build.fromCache) {
+        build.compile = compileAndCache(cache, cppSource, flags, cppPath, exePath);
+    }
+    return build;
+}
+
+void printCacheStats(const CompileCache& cache) {
+    CompileCacheStats stats = cache.stats();
+    std::uint64_t lookups = stats.hits + stats.misses;
+    std::cout << "Кэш сборок: попаданий " << stats.hits << " из " << lookups;
+    if (lookups != 0) {
+        std::cout << " (" << 100 * stats.hits / lookups << "%)";
+    }
+    std::cout << ", записей " << stats.entries << ", " << stats.bytes / 1024 << " КБ, вытеснено "
+              << stats.evictions << "\n";
+}
+
+fs::path runtimeHeaderPath(PrecompiledHeader& header) {
+    bool built = header.build().started;
+    fs::path path = header.prepare();
+    if (!built && header.build().started) {
+        if (path.empty()) {
+            std::cerr << header.build().output << header.build().errors
+                      << "Предкомпилированный заголовок не собран, программы собираются без него."
+                      << std::endl;
+        } else {
+            std::cout << "Предкомпилированный заголовок собран: " << formatTimes(header.build())
+                      << "\n";
+        }
+    }
+    return path;
+}
+
+std::string buildSource(const Program& program,
+                        CodegenOptions codegen,
+                        PrecompiledHeader* runtimeHeader) {
+    codegen.minimalRuntime = true;
+    if (runtimeHeader != nullptr) {
+        codegen.runtimeHeaderPath = runtimeHeaderPath(*runtimeHeader).generic_string();
+    }
+    return CodeGenerator::generate(program, codegen);
+}
+
+fs::path executablePath(const JobWorkspace& job) {
+    fs::path exePath = job.file("program");
+#ifdef _WIN32
+    exePath += ".exe";
+#endif
+    return exePath;
+}
+
+}  // namespace bearlang
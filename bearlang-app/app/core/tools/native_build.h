@@ -0,0 +1,113 @@
+#pragma once
+
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "core/codegen/build_profile.h"
+#include "core/codegen/codegen.h"
+#include "core/parser/ast.h"
+#include "core/process/compile_cache.h"
+#include "core/process/memory_file.h"
+#include "core/process/precompiled_header.h"
+#include "core/process/process.h"
+#include "core/process/workspace.h"
+
+namespace bearlang {
+
+// Flags of every g++ build of generated C++. Generated programs never catch
+// and the minimal runtime never throws, so without exception tables a
+// program that uses no std:: classes links against libc alone and starts
+// without loading libstdc++.
+extern const std::vector<std::string> kGppFlags;
+
+// g++ with kGppFlags, then `arguments`.
+std::vector<std::string> gppCommand(std::initializer_list<std::string> arguments);
+
+// What each build profile adds to kGppFlags. Instant keeps g++'s default
+// -O0, the level the precompiled runtime header is built at; any other
+// level makes g++ ignore the .gch, so Fast builds carry the runtime inline.
+const std::vector<std::string>& profileFlags(BuildProfile profile);
+
+// Runs g++ on the generated C++ with its messages captured: a background
+// build must not write into a running program's output, and a failed build
+// shows them through reportCompileFailure. g++ writes next to `exePath` and
+// the binary is renamed into place once it is complete, so `exePath` never
+// names a half-written file. `flags` go after kGppFlags.
+ProcessResult compileCpp(const std::filesystem::path& cppPath,
+                         const std::filesystem::path& exePath,
+                         const std::vector<std::string>& flags = {});
+
+// Links `cppSource` into `binary` without files: the source reaches g++
+// through a pipe (-x c++ -), its stages talk through pipes (-pipe), the
+// assembler's object file goes to /dev/shm and the linker writes into the
+// memfd.
+ProcessResult compileInMemory(const std::string& cppSource,
+                              const MemoryFile& binary,
+                              const std::vector<std::string>& flags = {});
+
+void reportCompileFailure(const ProcessResult& build);
+
+// "12.5 мс (процессор 11 мс)".
+std::string formatTimes(const ProcessResult& result);
+
+// What the compile cache keys a build by besides the source: the g++ that
+// PATH resolves to, with its size and modification time (an upgrade changes
+// them without running the compiler), and the flags.
+const std::string& compilerIdentity();
+
+// The compile cache key of `cppSource` built with `flags` on top of
+// kGppFlags. A cache directory may be shared between machines, so
+// -march=native stands for the CPU it resolves to here; when that is
+// unknown the key is empty and the build is neither cached nor served.
+std::string buildKey(const std::string& cppSource, const std::vector<std::string>& flags);
+
+struct NativeBuild {
+    // Empty when the binary came from the cache.
+    ProcessResult compile;
+    bool fromCache = false;
+
+    bool succeeded() const {
+        return fromCache || compile.succeeded();
+    }
+};
+
+// Places the cached binary of `cppSource` at `exePath`; false on a miss or
+// without a cache.
+bool fetchCachedBuild(CompileCache* cache,
+                      const std::string& cppSource,
+                      const std::vector<std::string>& flags,
+                      const std::filesystem::path& exePath);
+
+// Writes `cppSource` to `cppPath`, builds it and adds the binary to `cache`.
+ProcessResult compileAndCache(CompileCache* cache,
+                              const std::string& cppSource,
+                              const std::vector<std::string>& flags,
+                              const std::filesystem::path& cppPath,
+                              const std::filesystem::path& exePath);
+
+// Puts the binary of `cppSource` at `exePath`: taken from `cache` when it has
+// one, otherwise built from `cppPath` and added to it. `cache` may be null.
+NativeBuild buildNative(const std::string& cppSource,
+                        const std::vector<std::string>& flags,
+                        const std::filesystem::path& cppPath,
+                        const std::filesystem::path& exePath,
+                        CompileCache* cache);
+
+void printCacheStats(const CompileCache& cache);
+
+// Builds the runtime's .gch on first use, and says so.
+std::filesystem::path runtimeHeaderPath(PrecompiledHeader& header);
+
+// What g++ compiles: the saved copy with the minimal runtime in place of
+// <iostream>, <string> and <cmath>, whose parsing took most of g++'s time on
+// these programs. With `runtimeHeader` the runtime comes precompiled.
+std::string buildSource(const Program& program,
+                        CodegenOptions codegen,
+                        PrecompiledHeader* runtimeHeader);
+
+// `job`'s "program", with the platform's executable suffix.
+std::filesystem::path executablePath(const JobWorkspace& job);
+
+}  // namespace bearlang
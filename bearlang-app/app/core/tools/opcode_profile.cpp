@@ -0,0 +1,39 @@
+#include "opcode_profile.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "core/interpreter/value.h"
+#include "core/vm/compiler.h"
+#include "core/vm/vm.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+int runOpcodeProfile(const fs::path& sourcePath, const fs::path& inputPath) {
+    Program program;
+    std::string input;
+    if (!loadMeasuredProgram(sourcePath, inputPath, program, input)) {
+        return 1;
+    }
+    Chunk chunk = BytecodeCompiler::compile(program);
+    VmProfile profile;
+    VmOptions vmOptions;
+    vmOptions.profile = &profile;
+    std::istringstream in(input);
+    std::ostringstream out;
+    try {
+        VirtualMachine::execute(chunk, in, out, vmOptions);
+    } catch (const RuntimeError& ex) {
+        std::cerr << "Ошибка выполнения: " << ex.what() << std::endl;
+    }
+    std::cout << "Программа: " << sourcePath.string() << ", инструкций: " << chunk.code.size()
+              << ", диспетчеризация: " << VirtualMachine::dispatchName() << "\n";
+    std::cout << formatProfile(profile);
+    return 0;
+}
+
+}  // namespace bearlang
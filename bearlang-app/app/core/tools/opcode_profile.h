@@ -0,0 +1,11 @@
+#pragma once
+
+#include <filesystem>
+
+namespace bearlang {
+
+// --opcode-profile: runs the program on the VM with per-opcode timing and
+// prints the table; the program's own output is discarded.
+int runOpcodeProfile(const std::filesystem::path& sourcePath, const std::filesystem::path& inputPath);
+
+}  // namespace bearlang
@@ -0,0 +1,190 @@
+#include "pgo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "native_build.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+namespace {
+
+// Compiles `cppSource` to `objectPath` and links that into `exePath`, both
+// steps with `flags`. -fprofile-generate and -fprofile-use name their .gcda
+// after the object, so program.o writes and reads program.gcda beside it in
+// every g++ version, whatever the binary is called. The source goes through
+// stdin: a profile records the file name, and "<stdin>" is the same in every
+// job directory, so a cached profile fits the next build.
+ProcessResult compileViaObject(const std::string& cppSource,
+                               const fs::path& objectPath,
+                               const fs::path& exePath,
+                               const std::vector<std::string>& flags) {
+    ProcessOptions options;
+    options.output = ChildStream::Capture;
+    options.errors = ChildStream::Capture;
+    std::vector<std::string> compile = gppCommand({"-c"});
+    compile.insert(compile.end(), flags.begin(), flags.end());
+    compile.insert(compile.end(), {"-x", "c++", "-", "-o", objectPath.string()});
+    options.input = cppSource;
+    ProcessResult build = runProcess(compile, options);
+    options.input.reset();
+    if (!build.succeeded()) {
+        return build;
+    }
+    std::vector<std::string> link = gppCommand({});
+    link.insert(link.end(), flags.begin(), flags.end());
+    link.insert(link.end(), {objectPath.string(), "-o", exePath.string()});
+    ProcessResult linked = runProcess(link, options);
+    linked.output = build.output + linked.output;
+    linked.errors = build.errors + linked.errors;
+    linked.wallMs += build.wallMs;
+    linked.userMs += build.userMs;
+    linked.systemMs += build.systemMs;
+    return linked;
+}
+
+// Fastest of `repeats` runs of `exePath` on `input`; `output` gets what it
+// printed, and stays empty when a run fails.
+double bestRunMs(const fs::path& exePath, const std::string& input, int repeats, std::string& output) {
+    ProcessOptions runOptions;
+    runOptions.input = input;
+    runOptions.output = ChildStream::Capture;
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < repeats; ++i) {
+        ProcessResult run = runProcess({exePath.string()}, runOptions);
+        output = run.succeeded() ? run.output : std::string();
+        best = std::min(best, run.wallMs);
+    }
+    return best;
+}
+
+}  // namespace
+
+int runPgo(const fs::path& sourcePath,
+           const std::vector<fs::path>& inputPaths,
+           const fs::path& workRoot,
+           CompileCache* compileCache) {
+    Program program;
+    std::vector<std::string> samples;
+    try {
+        program = parseFile(sourcePath);
+        for (const auto& path : inputPaths) {
+            samples.push_back(readAll(path));
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Ошибка: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (samples.empty()) {
+        samples.emplace_back();
+    }
+    std::cout << "Программа: " << sourcePath.string() << ", примеров ввода: " << samples.size() << "\n";
+
+    const std::vector<std::string>& fastFlags = profileFlags(BuildProfile::Fast);
+    std::string cppSource = buildSource(program, CodegenOptions{}, nullptr);
+    JobWorkspace job(workRoot);
+
+    fs::path plainPath = job.file("plain");
+    NativeBuild plain =
+        buildNative(cppSource, fastFlags, job.file("plain.cpp"), plainPath, compileCache);
+    if (!plain.succeeded()) {
+        reportCompileFailure(plain.compile);
+        return 1;
+    }
+    std::cout << "  g++ -O2: " << (plain.fromCache ? "из кэша сборок" : formatTimes(plain.compile)) << "\n";
+
+    std::vector<std::string> generateFlags = fastFlags;
+    generateFlags.push_back("-fprofile-generate");
+    std::vector<std::string> useFlags = fastFlags;
+    useFlags.push_back("-fprofile-use");
+    // Lengths first, so that no two different sets of samples join into the
+    // same text.
+    std::string sampleText;
+    for (const auto& sample : samples) {
+        sampleText += std::to_string(sample.size()) + ":" + sample;
+    }
+    std::string key = buildKey(cppSource, useFlags);
+    // Not cached when -march=native cannot be resolved; see buildKey.
+    CompileCache* cache = key.empty() ? nullptr : compileCache;
+    key += "\nsamples " + fnv1aHex(sampleText);
+    std::string profileKey = key + "\nprofile";
+
+    fs::path pgoPath = job.file("program");
+    fs::path objectPath = job.file("program.o");
+    fs::path profilePath = job.file("program.gcda");
+    if (cache != nullptr && cache->fetch(key, pgoPath)) {
+        std::cout << "  g++ с профилем: из кэша сборок\n";
+    } else {
+        if (cache != nullptr && cache->fetch(profileKey, profilePath)) {
+            std::cout << "  профиль: из кэша сборок\n";
+        } else {
+            ProcessResult instrumented =
+                compileViaObject(cppSource, objectPath, job.file("instrumented"), generateFlags);
+            if (!instrumented.succeeded()) {
+                reportCompileFailure(instrumented);
+                return 1;
+            }
+            auto start = std::chrono::steady_clock::now();
+            ProcessOptions runOptions;
+            runOptions.output = ChildStream::Discard;
+            for (const auto& sample : samples) {
+                runOptions.input = sample;
+                runProcess({job.file("instrumented").string()}, runOptions);
+            }
+            std::error_code error;
+            if (!fs::exists(profilePath, error)) {
+                std::cerr << "Примеры ввода не записали профиль: программа ни разу не завершилась нормально."
+                          << std::endl;
+                return 1;
+            }
+            std::cout << "  g++ -fprofile-generate: " << formatTimes(instrumented) << ", примеры: "
+                      << millisecondsSince(start) << " мс\n";
+            if (cache != nullptr) {
+                cache->store(profileKey, profilePath);
+            }
+        }
+        ProcessResult optimized = compileViaObject(cppSource, objectPath, pgoPath, useFlags);
+        if (!optimized.succeeded()) {
+            reportCompileFailure(optimized);
+            return 1;
+        }
+        std::cout << "  g++ -fprofile-use: " << formatTimes(optimized) << "\n";
+        if (cache != nullptr) {
+            cache->store(key, pgoPath);
+        }
+    }
+
+    // Turn about, so that neither binary runs on a warmer machine.
+    const int repeats = 3;
+    double plainMs = 0.0;
+    double pgoMs = 0.0;
+    bool same = true;
+    for (const auto& sample : samples) {
+        std::string plainOutput;
+        std::string pgoOutput;
+        plainMs += bestRunMs(plainPath, sample, repeats, plainOutput);
+        pgoMs += bestRunMs(pgoPath, sample, repeats, pgoOutput);
+        same = same && plainOutput == pgoOutput;
+    }
+    std::cout << "  -O2: " << plainMs << " мс на все примеры, с профилем: " << pgoMs << " мс, ускорение "
+              << plainMs / pgoMs << "x (лучший из " << repeats << " запусков)\n";
+    if (compileCache != nullptr) {
+        printCacheStats(*compileCache);
+    }
+    if (!same) {
+        std::cout << "Вывод сборки с профилем отличается от -O2.\n";
+        return 1;
+    }
+    std::cout << "Вывод обеих сборок совпадает.\n";
+    return 0;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include "core/process/compile_cache.h"
+
+namespace bearlang {
+
+// --pgo, a profile-guided build for programs graded over and over: the fast
+// profile instrumented with -fprofile-generate runs every sample input, and
+// the counts it writes steer a -fprofile-use rebuild. The binary and its
+// profile go into `compileCache` (when not null) as two entries, keyed by
+// the source, the flags and the samples: an evicted binary is rebuilt from
+// a cached profile without running the samples again. Reports the time of
+// the samples on the plain fast (-O2) binary and on the profile-guided one.
+int runPgo(const std::filesystem::path& sourcePath,
+           const std::vector<std::filesystem::path>& inputPaths,
+           const std::filesystem::path& workRoot,
+           CompileCache* compileCache);
+
+}  // namespace bearlang
@@ -0,0 +1,109 @@
+#include "sessions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/interpreter/value.h"
+#include "core/vm/compiler.h"
+#include "core/vm/scheduler.h"
+#include "core/vm/vm.h"
+#include "tool_support.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+int runSessions(std::size_t count, const fs::path& sourcePath, const fs::path& inputPath) {
+    Program program;
+    std::string input;
+    if (!loadMeasuredProgram(sourcePath, inputPath, program, input)) {
+        return 1;
+    }
+    auto chunk = std::make_shared<const Chunk>(BytecodeCompiler::compile(program));
+
+    std::string expected;
+    {
+        std::istringstream in(input);
+        std::ostringstream out;
+        try {
+            VirtualMachine::execute(*chunk, in, out);
+        } catch (const RuntimeError& ex) {
+            out << "Ошибка выполнения: " << ex.what() << "\n";
+        }
+        expected = out.str();
+    }
+
+    std::vector<std::string> lines;
+    std::istringstream inputLines(input);
+    for (std::string line; std::getline(inputLines, line);) {
+        lines.push_back(line + "\n");
+    }
+
+    Scheduler scheduler;
+    std::vector<Scheduler::TaskId> ids;
+    std::vector<std::size_t> nextLine(count, 0);
+    std::vector<std::string> outputs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ids.push_back(scheduler.spawn(chunk));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t rounds = 0;
+    double longestRound = 0.0;
+    while (true) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (scheduler.state(ids[i]) != TaskState::WaitingForInput) {
+                continue;
+            }
+            if (nextLine[i] < lines.size()) {
+                scheduler.provideInput(ids[i], lines[nextLine[i]++]);
+            } else {
+                scheduler.closeInput(ids[i]);
+            }
+        }
+        if (scheduler.readyCount() == 0) {
+            break;
+        }
+        auto roundStart = std::chrono::steady_clock::now();
+        scheduler.runRound();
+        longestRound = std::max(longestRound, millisecondsSince(roundStart));
+        ++rounds;
+        for (std::size_t i = 0; i < count; ++i) {
+            outputs[i] += scheduler.takeOutput(ids[i]);
+        }
+    }
+    double total = millisecondsSince(start);
+
+    std::uint64_t instructions = 0;
+    std::size_t mismatched = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        instructions += scheduler.executed(ids[i]);
+        if (scheduler.state(ids[i]) == TaskState::Failed) {
+            outputs[i] += "Ошибка выполнения: " + scheduler.error(ids[i]) + "\n";
+        }
+        if (outputs[i] != expected) {
+            ++mismatched;
+        }
+    }
+
+    std::cout << "Программа: " << sourcePath.string() << ", сеансов: " << count << "\n";
+    std::cout << "  всего: " << total << " мс, раундов: " << rounds << "\n";
+    if (rounds > 0) {
+        std::cout << "  раунд: в среднем " << total / static_cast<double>(rounds)
+                  << " мс, самый долгий " << longestRound << " мс\n";
+    }
+    std::cout << "  инструкций: " << instructions << "\n";
+    if (mismatched == 0) {
+        std::cout << "Вывод всех сеансов совпадает с обычным запуском.\n";
+    } else {
+        std::cout << "Вывод отличается в сеансах: " << mismatched << "\n";
+    }
+    return mismatched == 0 ? 0 : 1;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace bearlang {
+
+// --sessions: runs `count` copies of the program as scheduler tasks in this
+// thread. Each session gets its input one line at a time, only once it
+// waits in `ввод`, the way a student types. Reports how long a round over
+// all ready sessions took, which bounds how long any one of them waits, and
+// checks every session's output against a single VM run.
+int runSessions(std::size_t count,
+                const std::filesystem::path& sourcePath,
+                const std::filesystem::path& inputPath);
+
+}  // namespace bearlang
@@ -0,0 +1,75 @@
+#include "tool_support.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "core/lexer/lexer.h"
+#include "core/parser/parser.h"
+#include "core/semantic/checker.h"
+
+namespace fs = std::filesystem;
+
+namespace bearlang {
+
+std::string readAll(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Не удалось открыть файл: " + path.string());
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+std::vector<fs::path> loadExamples(const fs::path& directory) {
+    std::vector<fs::path> files;
+    if (!fs::exists(directory)) {
+        return files;
+    }
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        if (entry.path().extension() == ".txt") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+Program parseFile(const fs::path& sourcePath) {
+    std::string source = readAll(sourcePath);
+    Lexer lexer(source);
+    auto tokens = lexer.tokenize();
+    Parser parser(std::move(tokens));
+    Program program = parser.parseProgram();
+    checkProgram(program);
+    return program;
+}
+
+bool loadMeasuredProgram(const fs::path& sourcePath,
+                         const fs::path& inputPath,
+                         Program& program,
+                         std::string& input) {
+    try {
+        program = parseFile(sourcePath);
+        if (!inputPath.empty()) {
+            input = readAll(inputPath);
+        }
+        return true;
+    } catch (const std::exception& ex) {
+        std::cerr << "Ошибка: " << ex.what() << std::endl;
+        return false;
+    }
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+}  // namespace bearlang
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// The whole file; throws std::runtime_error when it cannot be opened.
+std::string readAll(const std::filesystem::path& path);
+
+// The .txt files of `directory` in name order; none when it does not exist.
+std::vector<std::filesystem::path> loadExamples(const std::filesystem::path& directory);
+
+// Lexes, parses and checks a program; throws on the first error.
+Program parseFile(const std::filesystem::path& sourcePath);
+
+// Program and input file of `--benchmark` / `--opcode-profile` and the
+// other measuring tools. An empty `inputPath` means no input. Prints the
+// error and returns false when either cannot be read.
+bool loadMeasuredProgram(const std::filesystem::path& sourcePath,
+                         const std::filesystem::path& inputPath,
+                         Program& program,
+                         std::string& input);
+
+double millisecondsSince(std::chrono::steady_clock::time_point start);
+
+}  // namespace bearlang
@@ -0,0 +1,69 @@
+#include "bytecode.h"
+
+#include <sstream>
+
+namespace bearlang {
+
+const char* opName(Op op) {
+    switch (op) {
+        case Op::LoadInt: return "LoadInt";
+        case Op::LoadDouble: return "LoadDouble";
+        case Op::LoadString: return "LoadString";
+        case Op::MoveNum: return "MoveNum";
+        case Op::MoveStr: return "MoveStr";
+#define BEARLANG_OP_NAME(name, ...) \
+    case Op::name:                   \
+        return #name;
+        BEARLANG_CONVERSION_OPS(BEARLANG_OP_NAME)
+        BEARLANG_TYPED_BINARY_OPS(BEARLANG_OP_NAME)
+        BEARLANG_TYPED_UNARY_OPS(BEARLANG_OP_NAME)
+#undef BEARLANG_OP_NAME
+        case Op::AppendStr: return "AppendStr";
+        case Op::AppendConst: return "AppendConst";
+        case Op::Jump: return "Jump";
+        case Op::JumpIfFalse: return "JumpIfFalse";
+        case Op::JumpIfTrue: return "JumpIfTrue";
+        case Op::LoopIfTrue: return "LoopIfTrue";
+        case Op::ForInitInt: return "ForInitInt";
+        case Op::ForLoopInt: return "ForLoopInt";
+        case Op::JumpIfLtInt: return "JumpIfLtInt";
+        case Op::JumpIfLeInt: return "JumpIfLeInt";
+        case Op::JumpIfGtInt: return "JumpIfGtInt";
+        case Op::JumpIfGeInt: return "JumpIfGeInt";
+        case Op::JumpIfEqInt: return "JumpIfEqInt";
+        case Op::JumpIfNeInt: return "JumpIfNeInt";
+        case Op::AddIntImm: return "AddIntImm";
+        case Op::PrintInt: return "PrintInt";
+        case Op::PrintDouble: return "PrintDouble";
+        case Op::PrintStr: return "PrintStr";
+        case Op::PrintConst: return "PrintConst";
+        case Op::PrintNewline: return "PrintNewline";
+        case Op::ReadInt: return "ReadInt";
+        case Op::ReadDouble: return "ReadDouble";
+        case Op::ReadStr: return "ReadStr";
+        case Op::ReadBool: return "ReadBool";
+        case Op::Halt: return "Halt";
+    }
+    return "?";
+}
+
+std::string disassemble(const Chunk& chunk) {
+    std::ostringstream out;
+    out << "; numeric slots: " << chunk.numericSlots << ", string slots: " << chunk.stringSlots
+        << "\n";
+    for (std::size_t i = 0; i < chunk.code.size(); ++i) {
+        const Instruction& ins = chunk.code[i];
+        out << i << "\t" << opName(ins.op) << "\t" << ins.a << ", " << ins.b << ", " << ins.c;
+        if (ins.op == Op::LoadDouble) {
+            out << "\t; " << chunk.doubles[ins.b];
+        } else if (ins.op == Op::LoadString || ins.op == Op::AppendConst) {
+            out << "\t; \"" << chunk.strings[ins.b] << "\"";
+        } else if (ins.op == Op::PrintConst) {
+            out << "\t; \"" << chunk.strings[ins.a] << "\"";
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+}  // namespace bearlang
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bearlang {
+
+// Opcodes that exist once per operand type, as X(opcode, from, to) or
+// X(opcode, operator, type). The enum, opName, the VM handlers and the
+// compiler's choice of opcode are all generated from these lists; what each
+// one computes is defined once, by the templates in typed_ops.h.
+//
+// Conversions: n[a] = n[b] converted, the implicit conversions of the
+// generated C++ made explicit (`дробное d = 1` loads 1 and then converts).
+#define BEARLANG_CONVERSION_OPS(X)                                                             \
+    X(IntToDouble, Integer, Double)                                                            \
+    X(DoubleToInt, Double, Integer)                                                            \
+    X(IntToBool, Integer, Boolean)                                                             \
+    X(DoubleToBool, Double, Boolean)
+
+// n[a] = n[b] op n[c]; string comparisons read s[b] and s[c]. Integer
+// arithmetic wraps, `/` and `%` trap on zero; `логика` operands use the
+// Integer forms.
+#define BEARLANG_TYPED_BINARY_OPS(X)                                                           \
+    X(AddInt, Add, Integer) X(SubInt, Sub, Integer) X(MulInt, Mul, Integer)                    \
+    X(DivInt, Div, Integer) X(ModInt, Mod, Integer)                                            \
+    X(AddDouble, Add, Double) X(SubDouble, Sub, Double) X(MulDouble, Mul, Double)              \
+    X(DivDouble, Div, Double) X(PowDouble, Pow, Double)                                        \
+    X(EqInt, Eq, Integer) X(LtInt, Lt, Integer) X(LeInt, Le, Integer)                          \
+    X(GtInt, Gt, Integer) X(GeInt, Ge, Integer)                                                \
+    X(EqDouble, Eq, Double) X(LtDouble, Lt, Double) X(LeDouble, Le, Double)                    \
+    X(GtDouble, Gt, Double) X(GeDouble, Ge, Double)                                            \
+    X(EqStr, Eq, String) X(LtStr, Lt, String) X(LeStr, Le, String)                             \
+    X(GtStr, Gt, String) X(GeStr, Ge, String)
+
+// n[a] = op n[b]; `!` yields int 0 / 1.
+#define BEARLANG_TYPED_UNARY_OPS(X)                                                            \
+    X(NegInt, Negate, Integer) X(NotInt, Not, Integer)                                         \
+    X(NegDouble, Negate, Double) X(NotDouble, Not, Double)
+
+// Register-based bytecode. A frame has two register files: numeric slots
+// (8 bytes, `целое` and `логика` as int 0/1, `дробное` as double) and string
+// slots. Every opcode is typed, so the VM never inspects a value's type.
+//
+// Operand legend: n = numeric register, s = string register, k = constant
+// pool index, imm = immediate int, @ = instruction index.
+enum class Op : std::uint8_t {
+    LoadInt,        // n[a] = imm b
+    LoadDouble,     // n[a] = doubles[b]
+    LoadString,     // s[a] = strings[b]
+    MoveNum,        // n[a] = n[b]
+    MoveStr,        // s[a] = s[b]
+
+#define BEARLANG_OP_ENUMERATOR(name, ...) name,
+    BEARLANG_CONVERSION_OPS(BEARLANG_OP_ENUMERATOR)
+    BEARLANG_TYPED_BINARY_OPS(BEARLANG_OP_ENUMERATOR)
+    BEARLANG_TYPED_UNARY_OPS(BEARLANG_OP_ENUMERATOR)
+#undef BEARLANG_OP_ENUMERATOR
+
+    AppendStr,      // s[a] += s[b]
+    AppendConst,    // s[a] += strings[b]
+
+    Jump,           // goto @a
+    JumpIfFalse,    // if n[a] == 0 goto @b
+    JumpIfTrue,     // if n[a] != 0 goto @b
+    LoopIfTrue,     // backward edge of `пока`: if n[a] != 0 goto @b
+    ForInitInt,     // entry test of `для`: if !(n[a] <= n[b]) goto @c
+    ForLoopInt,     // back edge of `для`: ++n[a]; if n[a] <= n[b] goto @c
+
+    // Superinstructions for the pairs that dominate opcode profiles of
+    // student loops. Compare-and-branch replaces a compare into a temporary
+    // followed by a conditional jump; `если` uses the inverted comparison.
+    JumpIfLtInt,    // if n[a] < n[b] goto @c
+    JumpIfLeInt,
+    JumpIfGtInt,
+    JumpIfGeInt,
+    JumpIfEqInt,
+    JumpIfNeInt,
+    AddIntImm,      // n[a] = n[b] + imm c, wrapping: `счетчик = счетчик + 1`
+
+    PrintInt,       // out << n[a].i
+    PrintDouble,
+    PrintStr,
+    PrintConst,     // out << strings[a]
+    PrintNewline,
+    ReadInt,        // flush out, in >> n[a].i
+    ReadDouble,
+    ReadStr,
+    ReadBool,
+
+    Halt,
+};
+
+constexpr std::size_t kOpCount = static_cast<std::size_t>(Op::Halt) + 1;
+
+const char* opName(Op op);
+
+// One numeric register; the opcode decides which member is live.
+union NumericSlot {
+    int i;
+    double d;
+};
+
+struct Instruction {
+    Op op;
+    std::int32_t a = 0;
+    std::int32_t b = 0;
+    std::int32_t c = 0;
+};
+
+// Source lines spanned by a `пока` / `для` loop, header to last body line.
+struct LoopLines {
+    std::uint32_t first;
+    std::uint32_t last;
+};
+
+// A compiled program. It is immutable once built, so one Chunk can be
+// executed by several frames at the same time.
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<double> doubles;
+    std::vector<std::string> strings;
+    std::size_t numericSlots = 0;
+    std::size_t stringSlots = 0;
+    // Source line of the statement each instruction was compiled from,
+    // parallel to `code`; 0 for the constant loads up front and Halt.
+    std::vector<std::uint32_t> lines;
+    std::vector<LoopLines> loops;
+};
+
+std::string disassemble(const Chunk& chunk);
+
+}  // namespace bearlang
@@ -0,0 +1,745 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "core/interpreter/value.h"
+#include "core/semantic/typing.h"
+#include "typed_ops.h"
+
+namespace bearlang {
+
+namespace {
+
+bool isString(ValueType type) {
+    return type == ValueType::String;
+}
+
+// Where a value lives: a register in the numeric or the string file.
+struct Operand {
+    ValueType type;
+    int reg;
+};
+
+// Numeric literals of a program mapped to the registers that hold them.
+struct Constants {
+    std::map<int, int> ints;
+    std::map<double, int> doubles;
+};
+
+// Names assigned anywhere inside a block, used to decide whether the bound of
+// a `для` loop can be evaluated once.
+void collectAssigned(const std::vector<StmtPtr>& statements, std::unordered_set<std::string>& names) {
+    for (const auto& stmt : statements) {
+        switch (stmt->kind()) {
+            case StatementKind::Assign:
+                names.insert(static_cast<const AssignStmt&>(*stmt).name);
+                break;
+            case StatementKind::Input:
+                names.insert(static_cast<const InputStmt&>(*stmt).name);
+                break;
+            case StatementKind::If: {
+                const auto& ifStmt = static_cast<const IfStmt&>(*stmt);
+                for (const auto& branch : ifStmt.branches) {
+                    collectAssigned(branch.body, names);
+                }
+                collectAssigned(ifStmt.elseBranch, names);
+                break;
+            }
+            case StatementKind::While:
+                collectAssigned(static_cast<const WhileStmt&>(*stmt).body, names);
+                break;
+            case StatementKind::ForRange:
+                collectAssigned(static_cast<const ForRangeStmt&>(*stmt).body, names);
+                break;
+            case StatementKind::VarDecl:
+            case StatementKind::Output:
+                break;
+        }
+    }
+}
+
+bool readsAnyOf(const Expression& expr, const std::unordered_set<std::string>& names) {
+    switch (expr.kind()) {
+        case ExpressionKind::Literal:
+            return false;
+        case ExpressionKind::Variable:
+            return names.count(static_cast<const VariableExpr&>(expr).name) > 0;
+        case ExpressionKind::Unary:
+            return readsAnyOf(*static_cast<const UnaryExpr&>(expr).operand, names);
+        case ExpressionKind::Binary: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            return readsAnyOf(*binary.left, names) || readsAnyOf(*binary.right, names);
+        }
+    }
+    return false;
+}
+
+class Compiler {
+public:
+    // `constants` are the literals found by an earlier pass over the same
+    // program. Each gets a register loaded once at the start, so reading a
+    // literal inside a loop costs no instruction.
+    explicit Compiler(Constants constants) : constants_(std::move(constants)) {
+        scopes_.emplace_back();
+        for (auto& constant : constants_.ints) {
+            constant.second = allocate(ValueType::Integer);
+            emit(Op::LoadInt, constant.second, constant.first);
+        }
+        for (auto& constant : constants_.doubles) {
+            constant.second = allocate(ValueType::Double);
+            emit(Op::LoadDouble, constant.second, addDouble(constant.first));
+        }
+    }
+
+    const Constants& constants() const {
+        return constants_;
+    }
+
+    Chunk finish(const Program& program) {
+        for (const auto& stmt : program.statements) {
+            compileStatement(*stmt);
+        }
+        line_ = 0;
+        emit(Op::Halt);
+        return std::move(chunk_);
+    }
+
+private:
+    struct Mark {
+        int numeric;
+        int string;
+    };
+
+    Mark mark() const {
+        return Mark{nextNumeric_, nextString_};
+    }
+
+    // Registers are handed out like a stack: temporaries die at the end of
+    // their statement and a block's variables at the end of the block.
+    void release(Mark m) {
+        nextNumeric_ = m.numeric;
+        nextString_ = m.string;
+    }
+
+    int allocate(ValueType type) {
+        if (isString(type)) {
+            int reg = nextString_++;
+            chunk_.stringSlots = std::max<std::size_t>(chunk_.stringSlots, nextString_);
+            return reg;
+        }
+        int reg = nextNumeric_++;
+        chunk_.numericSlots = std::max<std::size_t>(chunk_.numericSlots, nextNumeric_);
+        return reg;
+    }
+
+    std::size_t emit(Op op, int a = 0, int b = 0, int c = 0) {
+        chunk_.code.push_back(Instruction{op, a, b, c});
+        chunk_.lines.push_back(line_);
+        return chunk_.code.size() - 1;
+    }
+
+    int here() const {
+        return static_cast<int>(chunk_.code.size());
+    }
+
+    int addDouble(double value) {
+        chunk_.doubles.push_back(value);
+        return static_cast<int>(chunk_.doubles.size() - 1);
+    }
+
+    int addString(const std::string& value) {
+        for (std::size_t i = 0; i < chunk_.strings.size(); ++i) {
+            if (chunk_.strings[i] == value) {
+                return static_cast<int>(i);
+            }
+        }
+        chunk_.strings.push_back(value);
+        return static_cast<int>(chunk_.strings.size() - 1);
+    }
+
+    // A literal not seen by the earlier pass is recorded and loaded into a
+    // temporary; this only happens during that pass.
+    int intConstant(int value) {
+        auto found = constants_.ints.find(value);
+        if (found != constants_.ints.end() && found->second >= 0) {
+            return found->second;
+        }
+        constants_.ints[value] = -1;
+        int reg = allocate(ValueType::Integer);
+        emit(Op::LoadInt, reg, value);
+        return reg;
+    }
+
+    int doubleConstant(double value) {
+        auto found = constants_.doubles.find(value);
+        if (found != constants_.doubles.end() && found->second >= 0) {
+            return found->second;
+        }
+        constants_.doubles[value] = -1;
+        int reg = allocate(ValueType::Double);
+        emit(Op::LoadDouble, reg, addDouble(value));
+        return reg;
+    }
+
+    Operand declare(const std::string& name, ValueType type) {
+        Operand slot{type, allocate(type)};
+        scopes_.back()[name] = slot;
+        return slot;
+    }
+
+    Operand lookup(const std::string& name) const {
+        for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+            auto found = it->find(name);
+            if (found != it->end()) {
+                return found->second;
+            }
+        }
+        return Operand{ValueType::Unknown, 0};
+    }
+
+    ValueType typeOfExpr(const Expression& expr) const {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return static_cast<const LiteralExpr&>(expr).type;
+            case ExpressionKind::Variable:
+                return lookup(static_cast<const VariableExpr&>(expr).name).type;
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                return unaryResultType(unary.op, typeOfExpr(*unary.operand));
+            }
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return binaryResultType(binary.op, typeOfExpr(*binary.left),
+                                        typeOfExpr(*binary.right));
+            }
+        }
+        return ValueType::Unknown;
+    }
+
+    bool readsRegister(const Expression& expr, Operand target) const {
+        switch (expr.kind()) {
+            case ExpressionKind::Literal:
+                return false;
+            case ExpressionKind::Variable: {
+                Operand slot = lookup(static_cast<const VariableExpr&>(expr).name);
+                return slot.reg == target.reg && isString(slot.type) == isString(target.type);
+            }
+            case ExpressionKind::Unary:
+                return readsRegister(*static_cast<const UnaryExpr&>(expr).operand, target);
+            case ExpressionKind::Binary: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return readsRegister(*binary.left, target) || readsRegister(*binary.right, target);
+            }
+        }
+        return false;
+    }
+
+    // Code emitted after the block belongs to the enclosing statement again.
+    void compileBlock(const std::vector<StmtPtr>& statements) {
+        Mark start = mark();
+        std::uint32_t line = line_;
+        scopes_.emplace_back();
+        for (const auto& stmt : statements) {
+            compileStatement(*stmt);
+        }
+        scopes_.pop_back();
+        line_ = line;
+        release(start);
+    }
+
+    void recordLoop(const Statement& loop) {
+        chunk_.loops.push_back(LoopLines{static_cast<std::uint32_t>(loop.line),
+                                         static_cast<std::uint32_t>(lastLine(loop))});
+    }
+
+    void compileStatement(const Statement& statement) {
+        line_ = static_cast<std::uint32_t>(statement.line);
+        switch (statement.kind()) {
+            case StatementKind::VarDecl: {
+                const auto& decl = static_cast<const VarDeclStmt&>(statement);
+                // Declared before the initializer is compiled, as in the
+                // generated C++.
+                Operand slot = declare(decl.name, decl.type);
+                Mark temps = mark();
+                // The register may still hold a value of an earlier block, so
+                // an initializer reading the new variable sees it reset first.
+                if (!decl.initializer || readsRegister(*decl.initializer, slot)) {
+                    loadDefault(slot);
+                }
+                if (decl.initializer) {
+                    compileInto(*decl.initializer, slot);
+                }
+                release(temps);
+                break;
+            }
+            case StatementKind::Assign: {
+                const auto& assign = static_cast<const AssignStmt&>(statement);
+                Mark temps = mark();
+                compileInto(*assign.value, lookup(assign.name));
+                release(temps);
+                break;
+            }
+            case StatementKind::Input: {
+                const auto& input = static_cast<const InputStmt&>(statement);
+                Operand slot = lookup(input.name);
+                switch (slot.type) {
+                    case ValueType::Double: emit(Op::ReadDouble, slot.reg); break;
+                    case ValueType::String: emit(Op::ReadStr, slot.reg); break;
+                    case ValueType::Boolean: emit(Op::ReadBool, slot.reg); break;
+                    case ValueType::Integer:
+                    case ValueType::Unknown:
+                    default: emit(Op::ReadInt, slot.reg); break;
+                }
+                break;
+            }
+            case StatementKind::Output: {
+                const auto& output = static_cast<const OutputStmt&>(statement);
+                Mark temps = mark();
+                compileOutput(*output.value);
+                emit(Op::PrintNewline);
+                release(temps);
+                break;
+            }
+            case StatementKind::If:
+                compileIf(static_cast<const IfStmt&>(statement));
+                break;
+            case StatementKind::While:
+                compileWhile(static_cast<const WhileStmt&>(statement));
+                break;
+            case StatementKind::ForRange:
+                compileFor(static_cast<const ForRangeStmt&>(statement));
+                break;
+        }
+    }
+
+    void loadDefault(Operand slot) {
+        if (isString(slot.type)) {
+            emit(Op::LoadString, slot.reg, addString(""));
+        } else if (slot.type == ValueType::Double) {
+            emit(Op::LoadDouble, slot.reg, addDouble(0.0));
+        } else {
+            emit(Op::LoadInt, slot.reg, 0);
+        }
+    }
+
+    void compileOutput(const Expression& value) {
+        // String chains are printed operand by operand, like the generated C++.
+        std::vector<const Expression*> operands;
+        flattenConcat(value, operands);
+        for (const Expression* operand : operands) {
+            if (operand->kind() == ExpressionKind::Literal &&
+                static_cast<const LiteralExpr*>(operand)->type == ValueType::String) {
+                emit(Op::PrintConst, addString(static_cast<const LiteralExpr*>(operand)->text));
+                continue;
+            }
+            Operand result = compileExpr(*operand);
+            switch (result.type) {
+                case ValueType::Double: emit(Op::PrintDouble, result.reg); break;
+                case ValueType::String: emit(Op::PrintStr, result.reg); break;
+                case ValueType::Integer:
+                case ValueType::Boolean:
+                case ValueType::Unknown:
+                default: emit(Op::PrintInt, result.reg); break;
+            }
+        }
+    }
+
+    void compileIf(const IfStmt& ifStmt) {
+        std::vector<std::size_t> exits;
+        for (std::size_t i = 0; i < ifStmt.branches.size(); ++i) {
+            const auto& branch = ifStmt.branches[i];
+            if (branch.line != 0) {
+                line_ = static_cast<std::uint32_t>(branch.line);
+            }
+            Mark temps = mark();
+            std::size_t skip = emitBranch(*branch.condition, Op::JumpIfFalse);
+            release(temps);
+            compileBlock(branch.body);
+            bool last = i + 1 == ifStmt.branches.size() && !ifStmt.hasElse;
+            if (!last) {
+                exits.push_back(emit(Op::Jump));
+            }
+            patchBranch(skip, here());
+        }
+        if (ifStmt.hasElse) {
+            compileBlock(ifStmt.elseBranch);
+        }
+        for (std::size_t exit : exits) {
+            chunk_.code[exit].a = here();
+        }
+    }
+
+    void compileWhile(const WhileStmt& loop) {
+        // Rotated loop: the condition sits at the bottom, so every iteration
+        // runs a single backward branch.
+        recordLoop(loop);
+        std::size_t entry = emit(Op::Jump);
+        int body = here();
+        compileBlock(loop.body);
+        chunk_.code[entry].a = here();
+        Mark temps = mark();
+        patchBranch(emitBranch(*loop.condition, Op::LoopIfTrue), body);
+        release(temps);
+    }
+
+    void compileFor(const ForRangeStmt& loop) {
+        recordLoop(loop);
+        Mark start = mark();
+        scopes_.emplace_back();
+        Operand counter = declare(loop.name, loop.type);
+        {
+            Mark temps = mark();
+            compileInto(*loop.from, counter);
+            release(temps);
+        }
+
+        std::unordered_set<std::string> assigned{loop.name};
+        collectAssigned(loop.body, assigned);
+        ValueType boundType = typeOfExpr(*loop.to);
+        bool intLoop = loop.type == ValueType::Integer &&
+                       (boundType == ValueType::Integer || boundType == ValueType::Boolean);
+
+        if (intLoop && !readsAnyOf(*loop.to, assigned)) {
+            // The bound cannot change inside the loop, so it is computed once
+            // and the dedicated loop opcodes test and step the counter.
+            Operand limit{ValueType::Integer, allocate(ValueType::Integer)};
+            Mark temps = mark();
+            compileInto(*loop.to, limit);
+            release(temps);
+            std::size_t init = emit(Op::ForInitInt, counter.reg, limit.reg);
+            int body = here();
+            compileBlock(loop.body);
+            emit(Op::ForLoopInt, counter.reg, limit.reg, body);
+            chunk_.code[init].c = here();
+        } else {
+            // General form: `i <= to` is re-evaluated on every iteration.
+            std::size_t entry = emit(Op::Jump);
+            int body = here();
+            compileBlock(loop.body);
+            Mark temps = mark();
+            if (loop.type == ValueType::Double) {
+                emit(Op::AddDouble, counter.reg, counter.reg, doubleConstant(1.0));
+            } else if (loop.type == ValueType::Boolean) {
+                // ++ on a bool always yields true.
+                emit(Op::LoadInt, counter.reg, 1);
+            } else {
+                emit(Op::AddIntImm, counter.reg, counter.reg, 1);
+            }
+            release(temps);
+            chunk_.code[entry].a = here();
+            Mark conditionTemps = mark();
+            Operand limit = compileExpr(*loop.to);
+            if (intLoop) {
+                emit(Op::JumpIfLeInt, counter.reg, limit.reg, body);
+            } else {
+                int condition = compileComparison("<=", counter, limit, -1);
+                emit(Op::LoopIfTrue, condition, body);
+            }
+            release(conditionTemps);
+        }
+
+        scopes_.pop_back();
+        release(start);
+    }
+
+    // Register holding the truth value (int 0/1) of a condition.
+    int compileCondition(const Expression& expr) {
+        Operand value = compileExpr(expr);
+        return truthRegister(value, -1);
+    }
+
+    // Emits a jump taken when the condition holds (fallback LoopIfTrue) or
+    // fails (fallback JumpIfFalse); its target is set with patchBranch. A
+    // comparison of two ints becomes a single compare-and-branch.
+    std::size_t emitBranch(const Expression& condition, Op fallback) {
+        bool jumpWhenTrue = fallback != Op::JumpIfFalse;
+        if (condition.kind() == ExpressionKind::Binary) {
+            const auto& binary = static_cast<const BinaryExpr&>(condition);
+            const std::string& op = binary.op;
+            bool comparison = op == "==" || op == "<" || op == "<=" || op == ">" || op == ">=";
+            if (comparison && isIntLike(typeOfExpr(*binary.left)) &&
+                isIntLike(typeOfExpr(*binary.right))) {
+                Operand left = compileExpr(*binary.left);
+                Operand right = compileExpr(*binary.right);
+                Op code;
+                if (jumpWhenTrue) {
+                    code = op == "==" ? Op::JumpIfEqInt : op == "<" ? Op::JumpIfLtInt
+                         : op == "<=" ? Op::JumpIfLeInt : op == ">" ? Op::JumpIfGtInt : Op::JumpIfGeInt;
+                } else {
+                    code = op == "==" ? Op::JumpIfNeInt : op == "<" ? Op::JumpIfGeInt
+                         : op == "<=" ? Op::JumpIfGtInt : op == ">" ? Op::JumpIfLeInt : Op::JumpIfLtInt;
+                }
+                return emit(code, left.reg, right.reg);
+            }
+        }
+        return emit(fallback, compileCondition(condition));
+    }
+
+    void patchBranch(std::size_t at, int target) {
+        Instruction& jump = chunk_.code[at];
+        if (jump.op == Op::JumpIfFalse || jump.op == Op::JumpIfTrue || jump.op == Op::LoopIfTrue) {
+            jump.b = target;
+        } else {
+            jump.c = target;
+        }
+    }
+
+    static bool isIntLike(ValueType type) {
+        return type == ValueType::Integer || type == ValueType::Boolean;
+    }
+
+    int truthRegister(Operand value, int target) {
+        if (value.type == ValueType::Boolean) {
+            if (target >= 0 && target != value.reg) {
+                emit(Op::MoveNum, target, value.reg);
+                return target;
+            }
+            return value.reg;
+        }
+        int reg = target >= 0 ? target : allocate(ValueType::Boolean);
+        emit(conversionOp(value.type, ValueType::Boolean), reg, value.reg);
+        return reg;
+    }
+
+    // Evaluates expr into a variable's slot, applying the implicit conversion
+    // of a C++ assignment.
+    void compileInto(const Expression& expr, Operand slot) {
+        ValueType type = typeOfExpr(expr);
+        bool sameFile = type == slot.type ||
+                        (slot.type == ValueType::Integer && type == ValueType::Boolean);
+        if (sameFile) {
+            Operand result = compileExpr(expr, slot.reg);
+            if (result.reg != slot.reg) {
+                emit(isString(slot.type) ? Op::MoveStr : Op::MoveNum, slot.reg, result.reg);
+            }
+            return;
+        }
+        Operand value = compileExpr(expr);
+        switch (slot.type) {
+            case ValueType::Double:
+            case ValueType::Integer:
+                emit(conversionOp(value.type, slot.type), slot.reg, value.reg);
+                break;
+            case ValueType::Boolean:
+                truthRegister(value, slot.reg);
+                break;
+            case ValueType::String:
+            case ValueType::Unknown:
+            default:
+                break;
+        }
+    }
+
+    Operand compileAsDouble(const Expression& expr) {
+        if (expr.kind() == ExpressionKind::Literal &&
+            static_cast<const LiteralExpr&>(expr).type == ValueType::Integer) {
+            double value = static_cast<double>(std::stoll(static_cast<const LiteralExpr&>(expr).text));
+            return Operand{ValueType::Double, doubleConstant(value)};
+        }
+        return toDouble(compileExpr(expr));
+    }
+
+    Operand toDouble(Operand value) {
+        if (value.type == ValueType::Double) {
+            return value;
+        }
+        int reg = allocate(ValueType::Double);
+        emit(conversionOp(value.type, ValueType::Double), reg, value.reg);
+        return Operand{ValueType::Double, reg};
+    }
+
+    void flattenConcat(const Expression& expr, std::vector<const Expression*>& operands) const {
+        if (expr.kind() == ExpressionKind::Binary && static_cast<const BinaryExpr&>(expr).op == "+" &&
+            isString(typeOfExpr(expr))) {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            flattenConcat(*binary.left, operands);
+            flattenConcat(*binary.right, operands);
+            return;
+        }
+        operands.push_back(&expr);
+    }
+
+    // Evaluates expr and returns the register holding it. Variables are used
+    // in place; other results go to `target` when given, else to a temporary.
+    Operand compileExpr(const Expression& expr, int target = -1) {
+        ValueType type = typeOfExpr(expr);
+        auto result = [&]() { return target >= 0 ? target : allocate(type); };
+
+        switch (expr.kind()) {
+            case ExpressionKind::Literal: {
+                const auto& literal = static_cast<const LiteralExpr&>(expr);
+                if (literal.type == ValueType::String) {
+                    int reg = result();
+                    emit(Op::LoadString, reg, addString(literal.text));
+                    return Operand{type, reg};
+                }
+                int constant = literal.type == ValueType::Double
+                                   ? doubleConstant(std::stod(literal.text))
+                                   : intConstant(literalInt(literal));
+                if (target >= 0) {
+                    emit(Op::MoveNum, target, constant);
+                    return Operand{type, target};
+                }
+                return Operand{type, constant};
+            }
+            case ExpressionKind::Variable: {
+                Operand slot = lookup(static_cast<const VariableExpr&>(expr).name);
+                if (target >= 0 && target != slot.reg) {
+                    emit(isString(type) ? Op::MoveStr : Op::MoveNum, target, slot.reg);
+                    return Operand{type, target};
+                }
+                return slot;
+            }
+            case ExpressionKind::Unary: {
+                const auto& unary = static_cast<const UnaryExpr&>(expr);
+                Operand operand = compileExpr(*unary.operand);
+                int reg = result();
+                emit(typedUnaryOp(unaryOpFromSpelling(unary.op), operand.type), reg, operand.reg);
+                return Operand{type, reg};
+            }
+            case ExpressionKind::Binary:
+                return compileBinary(static_cast<const BinaryExpr&>(expr), type, target);
+        }
+        return Operand{type, 0};
+    }
+
+    Operand compileBinary(const BinaryExpr& binary, ValueType type, int target) {
+        const std::string& op = binary.op;
+        if (op == "&&" || op == "||") {
+            // The target is written before the right operand runs, so it may
+            // only be used when the expression does not read it.
+            Operand dst{ValueType::Boolean, target};
+            if (target < 0 || readsRegister(binary, dst)) {
+                dst.reg = allocate(ValueType::Boolean);
+            }
+            truthRegister(compileExpr(*binary.left), dst.reg);
+            std::size_t skip = emit(op == "&&" ? Op::JumpIfFalse : Op::JumpIfTrue, dst.reg);
+            truthRegister(compileExpr(*binary.right), dst.reg);
+            chunk_.code[skip].b = here();
+            return dst;
+        }
+        if (isString(type)) {
+            return compileConcat(binary, target);
+        }
+        if (op == "==" || op == "<" || op == "<=" || op == ">" || op == ">=") {
+            ValueType leftType = typeOfExpr(*binary.left);
+            ValueType rightType = typeOfExpr(*binary.right);
+            if (leftType == ValueType::Double || rightType == ValueType::Double) {
+                Operand left = compileAsDouble(*binary.left);
+                Operand right = compileAsDouble(*binary.right);
+                return Operand{ValueType::Boolean, compileComparison(op, left, right, target)};
+            }
+            Operand left = compileExpr(*binary.left);
+            Operand right = compileExpr(*binary.right);
+            return Operand{ValueType::Boolean, compileComparison(op, left, right, target)};
+        }
+
+        if (type == ValueType::Double) {
+            Operand left = compileAsDouble(*binary.left);
+            Operand right = compileAsDouble(*binary.right);
+            int reg = target >= 0 ? target : allocate(type);
+            emit(typedBinaryOp(binaryOpFromSpelling(op), type), reg, left.reg, right.reg);
+            return Operand{type, reg};
+        }
+
+        // `x + 1`, `1 + x` and `x - 1` add an immediate.
+        const Expression* variable = nullptr;
+        const Expression* literal = nullptr;
+        if (isIntLiteral(*binary.right) && (op == "+" || op == "-")) {
+            variable = binary.left.get();
+            literal = binary.right.get();
+        } else if (isIntLiteral(*binary.left) && op == "+") {
+            variable = binary.right.get();
+            literal = binary.left.get();
+        }
+        if (literal) {
+            Operand left = compileExpr(*variable);
+            int value = literalInt(static_cast<const LiteralExpr&>(*literal));
+            int reg = target >= 0 ? target : allocate(type);
+            emit(Op::AddIntImm, reg, left.reg, op == "-" ? wrapNeg(value) : value);
+            return Operand{type, reg};
+        }
+
+        Operand left = compileExpr(*binary.left);
+        Operand right = compileExpr(*binary.right);
+        int reg = target >= 0 ? target : allocate(type);
+        emit(typedBinaryOp(binaryOpFromSpelling(op), type), reg, left.reg, right.reg);
+        return Operand{type, reg};
+    }
+
+    static bool isIntLiteral(const Expression& expr) {
+        return expr.kind() == ExpressionKind::Literal &&
+               static_cast<const LiteralExpr&>(expr).type == ValueType::Integer;
+    }
+
+    // Out-of-range literals wrap, as g++ narrows them to int.
+    static int literalInt(const LiteralExpr& literal) {
+        if (literal.type == ValueType::Boolean) {
+            return literal.boolValue ? 1 : 0;
+        }
+        return static_cast<int>(std::stoll(literal.text));
+    }
+
+    int compileComparison(const std::string& op, Operand left, Operand right, int target) {
+        if (!isString(left.type) && (left.type == ValueType::Double || right.type == ValueType::Double)) {
+            left = toDouble(left);
+            right = toDouble(right);
+        }
+        int reg = target >= 0 ? target : allocate(ValueType::Boolean);
+        emit(typedBinaryOp(binaryOpFromSpelling(op), left.type), reg, left.reg, right.reg);
+        return reg;
+    }
+
+    // `a + b + c` on strings: one buffer, appended in order. `s = s + x`
+    // appends to s in place.
+    Operand compileConcat(const BinaryExpr& binary, int target) {
+        std::vector<const Expression*> operands;
+        flattenConcat(binary, operands);
+
+        Operand dst{ValueType::String, target};
+        bool targetReadLater = false;
+        for (std::size_t i = 1; i < operands.size() && target >= 0; ++i) {
+            targetReadLater = targetReadLater || readsRegister(*operands[i], dst);
+        }
+        if (target < 0 || targetReadLater) {
+            dst.reg = allocate(ValueType::String);
+        }
+
+        compileExpr(*operands.front(), dst.reg);
+        for (std::size_t i = 1; i < operands.size(); ++i) {
+            const Expression& operand = *operands[i];
+            if (operand.kind() == ExpressionKind::Literal) {
+                emit(Op::AppendConst, dst.reg,
+                     addString(static_cast<const LiteralExpr&>(operand).text));
+                continue;
+            }
+            emit(Op::AppendStr, dst.reg, compileExpr(operand).reg);
+        }
+        return dst;
+    }
+
+    Chunk chunk_;
+    Constants constants_;
+    std::vector<std::unordered_map<std::string, Operand>> scopes_;
+    int nextNumeric_ = 0;
+    int nextString_ = 0;
+    // Source line recorded for the instructions being emitted.
+    std::uint32_t line_ = 0;
+};
+
+}  // namespace
+
+Chunk BytecodeCompiler::compile(const Program& program) {
+    // The first pass only collects the numeric literals; the second compiles
+    // with a register reserved for each of them.
+    Compiler discovery{Constants{}};
+    discovery.finish(program);
+    Compiler compiler{discovery.constants()};
+    return compiler.finish(program);
+}
+
+}  // namespace bearlang
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "bytecode.h"
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+class BytecodeCompiler {
+public:
+    // Resolves every variable to a frame slot and picks typed opcodes from the
+    // static types. The program must already have passed checkProgram.
+    static Chunk compile(const Program& program);
+};
+
+}  // namespace bearlang
@@ -0,0 +1,165 @@
+#include "executor.h"
+
+#include <random>
+#include <sstream>
+#include <utility>
+
+#include "core/interpreter/value.h"
+#include "vm.h"
+
+namespace bearlang {
+
+namespace {
+
+// Index of the pool worker running on this thread, if any.
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local std::size_t currentWorker = 0;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads, std::size_t capacity)
+    : capacity_(capacity == 0 ? 1 : capacity) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread([this, i] { work(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    hasWork_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    bool inside = currentPool == this;
+    std::size_t target = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // A task that waited for room would block the worker that has to
+        // make it, so tasks from inside the pool are never held back.
+        if (!inside) {
+            hasRoom_.wait(lock, [this] { return queued_ < capacity_; });
+        }
+        target = inside ? currentWorker : nextWorker_++ % workers_.size();
+        ++unfinished_;
+    }
+    {
+        Worker& worker = *workers_[target];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++queued_;
+    }
+    hasWork_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool WorkStealingPool::take(std::size_t self, std::function<void()>& task) {
+    {
+        Worker& own = *workers_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    std::size_t count = workers_.size();
+    if (count == 1) {
+        return false;
+    }
+    thread_local std::minstd_rand random(std::random_device{}());
+    std::size_t start = random() % count;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t victim = (start + i) % count;
+        if (victim == self) {
+            continue;
+        }
+        Worker& other = *workers_[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            ++stolen_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(std::size_t self) {
+    currentPool = this;
+    currentWorker = self;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            hasWork_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+            if (queued_ == 0) {
+                return;
+            }
+        }
+        std::function<void()> task;
+        if (!take(self, task)) {
+            // Another worker got there first; the counter is still correct.
+            std::this_thread::yield();
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --queued_;
+        }
+        hasRoom_.notify_one();
+        task();
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done = --unfinished_ == 0;
+        }
+        if (done) {
+            idle_.notify_all();
+        }
+    }
+}
+
+std::future<BatchResult> submitRun(WorkStealingPool& pool,
+                                   std::shared_ptr<const Chunk> chunk,
+                                   std::string input) {
+    auto promise = std::make_shared<std::promise<BatchResult>>();
+    std::future<BatchResult> result = promise->get_future();
+    pool.submit([promise, chunk, input] {
+        BatchResult run;
+        auto start = std::chrono::steady_clock::now();
+        std::istringstream in(input);
+        std::ostringstream out;
+        try {
+            VirtualMachine::execute(*chunk, in, out);
+        } catch (const RuntimeError& ex) {
+            run.error = ex.what();
+        }
+        run.output = out.str();
+        run.finished = std::chrono::steady_clock::now();
+        run.runMs = std::chrono::duration<double, std::milli>(run.finished - start).count();
+        promise->set_value(std::move(run));
+    });
+    return result;
+}
+
+}  // namespace bearlang
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bytecode.h"
+
+namespace bearlang {
+
+// Thread pool for many independent runs. Every worker owns a deque: it takes
+// its newest task from the back, and when the deque is empty steals the
+// oldest task from the front of a randomly chosen other worker. Tasks
+// submitted from outside the pool are dealt to the workers in turn, tasks
+// submitted by a task go to its own worker.
+//
+// submit() blocks while `capacity` tasks are waiting, so a producer that is
+// faster than the workers cannot queue unbounded work.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(std::size_t threads, std::size_t capacity = 1024);
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Finishes every submitted task, then stops the workers.
+    ~WorkStealingPool();
+
+    void submit(std::function<void()> task);
+    // Until every task submitted so far has finished.
+    void wait();
+
+    std::size_t threadCount() const { return workers_.size(); }
+    std::size_t stolenCount() const { return stolen_.load(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+
+    void work(std::size_t self);
+    bool take(std::size_t self, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::size_t capacity_;
+
+    // Guards the sleeping, back-pressure and completion conditions below.
+    std::mutex mutex_;
+    std::condition_variable hasWork_;
+    std::condition_variable hasRoom_;
+    std::condition_variable idle_;
+    std::size_t queued_ = 0;
+    std::size_t unfinished_ = 0;
+    std::size_t nextWorker_ = 0;
+    bool stopping_ = false;
+    std::atomic<std::size_t> stolen_{0};
+};
+
+struct BatchResult {
+    std::string output;
+    // RuntimeError message; empty when the run finished.
+    std::string error;
+    // Time on the VM, without the wait in the queue.
+    double runMs = 0.0;
+    std::chrono::steady_clock::time_point finished;
+};
+
+// Runs `chunk` on the VM with `input` as one task of `pool`. The chunk is only
+// read, so any number of runs may share it; each run has its own frame and
+// streams. Output is always buffered.
+std::future<BatchResult> submitRun(WorkStealingPool& pool,
+                                   std::shared_ptr<const Chunk> chunk,
+                                   std::string input);
+
+}  // namespace bearlang
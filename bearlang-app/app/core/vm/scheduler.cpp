@@ -0,0 +1,146 @@
+#include "scheduler.h"
+
+#include <cctype>
+#include <utility>
+
+#include "core/interpreter/value.h"
+
+namespace bearlang {
+
+namespace {
+
+bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+}  // namespace
+
+void TaskInput::append(const std::string& text) {
+    // Drop what has been read so the buffer does not grow with the session.
+    std::size_t consumed = gptr() ? static_cast<std::size_t>(gptr() - eback()) : 0;
+    buffer_.erase(0, consumed);
+    buffer_ += text;
+    char* begin = &buffer_[0];
+    setg(begin, begin, begin + buffer_.size());
+}
+
+void TaskInput::close() {
+    closed_ = true;
+}
+
+bool TaskInput::readable() const {
+    if (closed_) {
+        return true;
+    }
+    const char* p = gptr();
+    const char* end = egptr();
+    while (p != end && isSpace(*p)) {
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+    while (p != end && !isSpace(*p)) {
+        ++p;
+    }
+    return p != end;
+}
+
+TaskInput::int_type TaskInput::underflow() {
+    // Everything appended is already in the get area.
+    return gptr() == egptr() ? traits_type::eof() : traits_type::to_int_type(*gptr());
+}
+
+Scheduler::Task::Task(std::shared_ptr<const Chunk> program)
+    : chunk(std::move(program)), frame(VirtualMachine::newFrame(*chunk)), in(&input) {}
+
+Scheduler::Scheduler(std::uint64_t budget) : budget_(budget == 0 ? 1 : budget) {}
+
+Scheduler::TaskId Scheduler::spawn(std::shared_ptr<const Chunk> chunk) {
+    TaskId id = tasks_.size();
+    tasks_.push_back(std::unique_ptr<Task>(new Task(std::move(chunk))));
+    ready_.push_back(id);
+    return id;
+}
+
+void Scheduler::wake(Task& task, TaskId id) {
+    if (task.state == TaskState::WaitingForInput && task.canRead()) {
+        task.state = TaskState::Ready;
+        ready_.push_back(id);
+    }
+}
+
+void Scheduler::provideInput(TaskId id, const std::string& text) {
+    Task& task = *tasks_.at(id);
+    task.input.append(text);
+    wake(task, id);
+}
+
+void Scheduler::closeInput(TaskId id) {
+    Task& task = *tasks_.at(id);
+    task.input.close();
+    wake(task, id);
+}
+
+std::string Scheduler::takeOutput(TaskId id) {
+    Task& task = *tasks_.at(id);
+    std::string text = task.out.str();
+    task.out.str(std::string());
+    return text;
+}
+
+TaskState Scheduler::state(TaskId id) const {
+    return tasks_.at(id)->state;
+}
+
+const std::string& Scheduler::error(TaskId id) const {
+    return tasks_.at(id)->error;
+}
+
+std::uint64_t Scheduler::executed(TaskId id) const {
+    return tasks_.at(id)->executed;
+}
+
+std::size_t Scheduler::runRound() {
+    std::size_t count = ready_.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        TaskId id = ready_.front();
+        ready_.pop_front();
+        Task& task = *tasks_[id];
+
+        std::uint64_t budget = budget_;
+        VmStop stop = VmStop::Halted;
+        try {
+            stop = VirtualMachine::resume(*task.chunk, task.frame, task.in, task.out, budget,
+                                          [&task] { return task.canRead(); });
+        } catch (const RuntimeError& ex) {
+            task.state = TaskState::Failed;
+            task.error = ex.what();
+        }
+        task.executed += budget_ - budget;
+        if (task.state == TaskState::Failed) {
+            continue;
+        }
+
+        switch (stop) {
+        case VmStop::Halted:
+            task.state = TaskState::Finished;
+            break;
+        case VmStop::OutOfBudget:
+            ready_.push_back(id);
+            break;
+        case VmStop::WaitingForInput:
+            task.state = TaskState::WaitingForInput;
+            break;
+        }
+    }
+    return count;
+}
+
+void Scheduler::runUntilIdle() {
+    while (!ready_.empty()) {
+        runRound();
+    }
+}
+
+}  // namespace bearlang
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "vm.h"
+
+namespace bearlang {
+
+enum class TaskState { Ready, WaitingForInput, Finished, Failed };
+
+// Input of one task: text arrives in pieces while the program runs.
+class TaskInput : public std::streambuf {
+public:
+    void append(const std::string& text);
+    void close();
+
+    // A read could start now without seeing a different token later: a whole
+    // whitespace-terminated token is buffered, or no more input will come.
+    bool readable() const;
+
+protected:
+    int_type underflow() override;
+
+private:
+    std::string buffer_;
+    bool closed_ = false;
+};
+
+// Runs many BearLang programs in one thread as VM tasks, each with its own
+// input and output. Every ready task in turn gets a slice of at most `budget`
+// instructions, so a long loop delays the others by one slice at most. A task
+// that reaches `ввод` with nothing to read waits without being scheduled
+// until provideInput() or closeInput().
+class Scheduler {
+public:
+    using TaskId = std::size_t;
+
+    explicit Scheduler(std::uint64_t budget = 10000);
+
+    // Several tasks may share one chunk.
+    TaskId spawn(std::shared_ptr<const Chunk> chunk);
+
+    void provideInput(TaskId id, const std::string& text);
+    // End of input: reads that find nothing fail as at the end of a stream.
+    void closeInput(TaskId id);
+    // Output written since the previous call.
+    std::string takeOutput(TaskId id);
+
+    TaskState state(TaskId id) const;
+    // The RuntimeError message of a failed task.
+    const std::string& error(TaskId id) const;
+    std::uint64_t executed(TaskId id) const;
+
+    // One slice for each task that was ready when the round began. Returns
+    // how many ran.
+    std::size_t runRound();
+    // Rounds until every task has finished, failed or waits for input.
+    void runUntilIdle();
+
+    std::size_t readyCount() const { return ready_.size(); }
+
+private:
+    struct Task {
+        explicit Task(std::shared_ptr<const Chunk> program);
+
+        // After a failed read the stream ignores further reads, as std::cin
+        // does, so they need no input.
+        bool canRead() const { return in.fail() || input.readable(); }
+
+        std::shared_ptr<const Chunk> chunk;
+        VmFrame frame;
+        TaskInput input;
+        std::istream in;
+        std::ostringstream out;
+        TaskState state = TaskState::Ready;
+        std::string error;
+        std::uint64_t executed = 0;
+    };
+
+    void wake(Task& task, TaskId id);
+
+    std::uint64_t budget_;
+    std::vector<std::unique_ptr<Task>> tasks_;
+    std::deque<TaskId> ready_;
+};
+
+}  // namespace bearlang
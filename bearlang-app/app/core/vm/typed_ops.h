@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+#include "bytecode.h"
+#include "core/interpreter/value.h"
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// What the opcodes of BEARLANG_CONVERSION_OPS, BEARLANG_TYPED_BINARY_OPS and
+// BEARLANG_TYPED_UNARY_OPS compute. Every opcode is one instantiation of the
+// templates below for a static type, so its handler is monomorphic: no type
+// is looked at while it runs.
+
+// C++ type of a register holding a value of type T; `логика` is an int 0 / 1.
+template <ValueType T>
+using Repr = std::conditional_t<T == ValueType::Double,
+                                double,
+                                std::conditional_t<T == ValueType::String, std::string, int>>;
+
+constexpr bool isComparisonOp(BinaryOp op) {
+    return op == BinaryOp::Eq || op == BinaryOp::Lt || op == BinaryOp::Le || op == BinaryOp::Gt ||
+           op == BinaryOp::Ge;
+}
+
+// The pairs that exist after checkProgram: comparisons on every type, `%`
+// only on ints, `^` only on doubles (int operands are converted first).
+// Strings are concatenated by AppendStr instead.
+template <BinaryOp Op, ValueType T>
+concept TypedBinary = isComparisonOp(Op) ||
+                      (T == ValueType::Integer && Op != BinaryOp::Pow) ||
+                      (T == ValueType::Double && Op != BinaryOp::Mod);
+
+template <BinaryOp Op, ValueType T>
+    requires TypedBinary<Op, T>
+inline auto applyTyped(const Repr<T>& a, const Repr<T>& b) {
+    if constexpr (Op == BinaryOp::Eq) {
+        return a == b;
+    } else if constexpr (Op == BinaryOp::Lt) {
+        return a < b;
+    } else if constexpr (Op == BinaryOp::Le) {
+        return a <= b;
+    } else if constexpr (Op == BinaryOp::Gt) {
+        return a > b;
+    } else if constexpr (Op == BinaryOp::Ge) {
+        return a >= b;
+    } else if constexpr (T == ValueType::Integer) {
+        if constexpr (Op == BinaryOp::Add) return wrapAdd(a, b);
+        else if constexpr (Op == BinaryOp::Sub) return wrapSub(a, b);
+        else if constexpr (Op == BinaryOp::Mul) return wrapMul(a, b);
+        else if constexpr (Op == BinaryOp::Div) return divideInts(a, b);
+        else return moduloInts(a, b);
+    } else {
+        if constexpr (Op == BinaryOp::Add) return a + b;
+        else if constexpr (Op == BinaryOp::Sub) return a - b;
+        else if constexpr (Op == BinaryOp::Mul) return a * b;
+        else if constexpr (Op == BinaryOp::Div) return a / b;
+        else return std::pow(a, b);
+    }
+}
+
+template <UnaryOp Op, ValueType T>
+    requires(T == ValueType::Integer || T == ValueType::Double)
+inline auto applyTyped(const Repr<T>& a) {
+    if constexpr (Op == UnaryOp::Not) {
+        return a == 0;
+    } else if constexpr (T == ValueType::Integer) {
+        return wrapNeg(a);
+    } else {
+        return -a;
+    }
+}
+
+template <ValueType From, ValueType To>
+    requires(From != To && From != ValueType::String && To != ValueType::String)
+inline Repr<To> convertTyped(const Repr<From>& value) {
+    if constexpr (To == ValueType::Boolean) {
+        return value != 0;
+    } else {
+        // Double to int truncates, like the static_cast in the generated C++.
+        return static_cast<Repr<To>>(value);
+    }
+}
+
+// The register an operand of type T lives in.
+template <ValueType T>
+inline Repr<T>& typedRegister(NumericSlot* n, std::string* s, int index) {
+    if constexpr (T == ValueType::String) {
+        (void)n;
+        return s[index];
+    } else if constexpr (T == ValueType::Double) {
+        (void)s;
+        return n[index].d;
+    } else {
+        (void)s;
+        return n[index].i;
+    }
+}
+
+inline void storeTyped(NumericSlot& slot, int value) {
+    slot.i = value;
+}
+
+inline void storeTyped(NumericSlot& slot, bool value) {
+    slot.i = value;
+}
+
+inline void storeTyped(NumericSlot& slot, double value) {
+    slot.d = value;
+}
+
+// The opcode for an operator on operands of one type; `логика` uses the
+// Integer forms. Halt when the table has none.
+constexpr Op typedBinaryOp(BinaryOp op, ValueType type) {
+    if (type == ValueType::Boolean) {
+        type = ValueType::Integer;
+    }
+#define BEARLANG_PICK(name, oper, operand)                                 \
+    if (op == BinaryOp::oper && type == ValueType::operand) {              \
+        return Op::name;                                                   \
+    }
+    BEARLANG_TYPED_BINARY_OPS(BEARLANG_PICK)
+#undef BEARLANG_PICK
+    return Op::Halt;
+}
+
+constexpr Op typedUnaryOp(UnaryOp op, ValueType type) {
+    if (type == ValueType::Boolean) {
+        type = ValueType::Integer;
+    }
+#define BEARLANG_PICK(name, oper, operand)                                 \
+    if (op == UnaryOp::oper && type == ValueType::operand) {               \
+        return Op::name;                                                   \
+    }
+    BEARLANG_TYPED_UNARY_OPS(BEARLANG_PICK)
+#undef BEARLANG_PICK
+    return Op::Halt;
+}
+
+// The opcode converting a register of one type into another; a `логика`
+// source is read as an int.
+constexpr Op conversionOp(ValueType from, ValueType to) {
+    if (from == ValueType::Boolean) {
+        from = ValueType::Integer;
+    }
+#define BEARLANG_PICK(name, source, target)                                \
+    if (from == ValueType::source && to == ValueType::target) {            \
+        return Op::name;                                                   \
+    }
+    BEARLANG_CONVERSION_OPS(BEARLANG_PICK)
+#undef BEARLANG_PICK
+    return Op::Halt;
+}
+
+// Runs one opcode of the tables outside the VM loop, e.g. when the JIT calls
+// back into C++. Returns false for any other opcode.
+inline bool executeTyped(const Instruction& ins, NumericSlot* n, std::string* s) {
+    switch (ins.op) {
+#define BEARLANG_CONVERT(name, from, to)                                                      \
+    case Op::name:                                                                           \
+        storeTyped(n[ins.a], convertTyped<ValueType::from, ValueType::to>(                   \
+                                 typedRegister<ValueType::from>(n, s, ins.b)));              \
+        return true;
+#define BEARLANG_BINARY(name, oper, type)                                                     \
+    case Op::name:                                                                           \
+        storeTyped(n[ins.a], applyTyped<BinaryOp::oper, ValueType::type>(                    \
+                                 typedRegister<ValueType::type>(n, s, ins.b),                \
+                                 typedRegister<ValueType::type>(n, s, ins.c)));              \
+        return true;
+#define BEARLANG_UNARY(name, oper, type)                                                      \
+    case Op::name:                                                                           \
+        storeTyped(n[ins.a],                                                                 \
+                   applyTyped<UnaryOp::oper, ValueType::type>(                               \
+                       typedRegister<ValueType::type>(n, s, ins.b)));                        \
+        return true;
+        BEARLANG_CONVERSION_OPS(BEARLANG_CONVERT)
+        BEARLANG_TYPED_BINARY_OPS(BEARLANG_BINARY)
+        BEARLANG_TYPED_UNARY_OPS(BEARLANG_UNARY)
+#undef BEARLANG_CONVERT
+#undef BEARLANG_BINARY
+#undef BEARLANG_UNARY
+        default:
+            return false;
+    }
+}
+
+}  // namespace bearlang
@@ -0,0 +1,609 @@
+#include "vm.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+#include "compiler.h"
+#include "core/interpreter/value.h"
+#include "typed_ops.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(BEARLANG_VM_SWITCH_DISPATCH)
+#define BEARLANG_VM_THREADED 1
+#else
+#define BEARLANG_VM_THREADED 0
+#endif
+
+namespace bearlang {
+
+namespace {
+
+std::uint64_t readTicks() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+#endif
+}
+
+// Charges the ticks between two dispatches to the opcode that ran between
+// them; converted to nanoseconds against steady_clock when the run ends.
+class OpcodeTimer {
+public:
+    explicit OpcodeTimer(VmProfile* profile) : profile_(profile) {
+        if (profile_) {
+            startTime_ = std::chrono::steady_clock::now();
+            startTicks_ = readTicks();
+            lastTicks_ = startTicks_;
+        }
+    }
+
+    void step(Op op) {
+        std::uint64_t now = readTicks();
+        std::size_t index = static_cast<std::size_t>(op);
+        if (running_) {
+            std::size_t last = static_cast<std::size_t>(last_);
+            ticks_[last] += now - lastTicks_;
+            ++profile_->pairs[last * kOpCount + index];
+        }
+        ++profile_->counts[index];
+        last_ = op;
+        lastTicks_ = now;
+        running_ = true;
+    }
+
+    void finish() {
+        std::uint64_t now = readTicks();
+        if (running_) {
+            ticks_[static_cast<std::size_t>(last_)] += now - lastTicks_;
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - startTime_)
+                             .count();
+        double perTick = now > startTicks_ ? elapsed / static_cast<double>(now - startTicks_) : 0.0;
+        for (std::size_t i = 0; i < kOpCount; ++i) {
+            profile_->nanoseconds[i] += static_cast<double>(ticks_[i]) * perTick;
+        }
+    }
+
+private:
+    VmProfile* profile_;
+    std::array<std::uint64_t, kOpCount> ticks_{};
+    std::chrono::steady_clock::time_point startTime_;
+    std::uint64_t startTicks_ = 0;
+    std::uint64_t lastTicks_ = 0;
+    Op last_ = Op::Halt;
+    bool running_ = false;
+};
+
+// Thrown out of a line-profiled run once VmLineProfile::limit has passed.
+struct LineLimitReached {};
+
+// Counts every instruction and folds the counts into source lines when the
+// run stops, however it stops. Reading the clock on every line change would
+// cost more than the instructions themselves, so time is sampled instead: a
+// thread wakes every kLineSamplePeriod and notes the running instruction,
+// and each line gets its share of the samples of the wall time. The same
+// thread watches the time limit.
+constexpr std::chrono::microseconds kLineSamplePeriod{100};
+
+class LineTimer {
+public:
+    LineTimer(VmLineProfile* profile, const Chunk& chunk) : profile_(profile), chunk_(chunk) {
+        if (!profile_) {
+            return;
+        }
+        counts_.assign(chunk.code.size(), 0);
+        samples_.assign(chunk.code.size(), 0);
+        start_ = std::chrono::steady_clock::now();
+        sampler_ = std::thread([this] {
+            auto deadline = start_ + profile_->limit;
+            while (!stop_.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(kLineSamplePeriod);
+                ++samples_[current_.load(std::memory_order_relaxed)];
+                if (profile_->limit.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+                    expired_.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    LineTimer(const LineTimer&) = delete;
+    LineTimer& operator=(const LineTimer&) = delete;
+
+    ~LineTimer() {
+        if (!profile_) {
+            return;
+        }
+        stop_.store(true, std::memory_order_relaxed);
+        sampler_.join();
+        double elapsed = std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count();
+        std::size_t lineCount = 1;
+        for (std::uint32_t line : chunk_.lines) {
+            lineCount = std::max<std::size_t>(lineCount, line + 1);
+        }
+        profile_->hits.assign(lineCount, 0);
+        profile_->operations.assign(lineCount, 0);
+        profile_->nanoseconds.assign(lineCount, 0.0);
+
+        // A line runs as often as its most frequent instruction: the
+        // condition of a rotated `пока` runs once more than its entry jump.
+        // A loop header thus counts every test of its condition, as the
+        // native build's heatmap does. The test of a `для` with a fixed
+        // bound is split: ForInitInt makes the first, ForLoopInt the rest.
+        std::uint64_t totalSamples = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            std::uint32_t line = chunk_.lines[i];
+            std::uint64_t runs = counts_[i];
+            const Instruction& ins = chunk_.code[i];
+            if (ins.op == Op::ForLoopInt && ins.c > 0 &&
+                chunk_.code[ins.c - 1].op == Op::ForInitInt) {
+                runs += counts_[ins.c - 1];
+            }
+            profile_->operations[line] += counts_[i];
+            profile_->hits[line] = std::max(profile_->hits[line], runs);
+            totalSamples += samples_[i];
+        }
+        std::size_t last = current_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < samples_.size(); ++i) {
+            double share = totalSamples == 0 ? (i == last ? 1.0 : 0.0)
+                                             : static_cast<double>(samples_[i]) /
+                                                   static_cast<double>(totalSamples);
+            profile_->nanoseconds[chunk_.lines[i]] += elapsed * share;
+        }
+    }
+
+    void step(std::ptrdiff_t index) {
+        if (expired_.load(std::memory_order_relaxed)) {
+            throw LineLimitReached{};
+        }
+        ++counts_[index];
+        current_.store(static_cast<std::size_t>(index), std::memory_order_relaxed);
+    }
+
+private:
+    VmLineProfile* profile_;
+    const Chunk& chunk_;
+    std::vector<std::uint64_t> counts_;
+    // Written by the running VM, read by the sampler.
+    std::atomic<std::size_t> current_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> expired_{false};
+    // Only touched by the sampler until it is joined.
+    std::vector<std::uint64_t> samples_;
+    std::chrono::steady_clock::time_point start_;
+    std::thread sampler_;
+};
+
+enum class Profiling { Off, Opcodes, Lines };
+
+#if BEARLANG_VM_THREADED
+struct ThreadedInstruction {
+    const void* handler;
+    Op op;
+    std::int32_t a;
+    std::int32_t b;
+    std::int32_t c;
+};
+#endif
+
+// Every opcode outside the typed tables of bytecode.h, for building the
+// handler table of the threaded loop.
+#define BEARLANG_VM_OPCODES(X)                                                                   \
+    X(LoadInt) X(LoadDouble) X(LoadString) X(MoveNum) X(MoveStr) X(AppendStr) X(AppendConst)     \
+    X(Jump) X(JumpIfFalse) X(JumpIfTrue) X(LoopIfTrue) X(ForInitInt) X(ForLoopInt)               \
+    X(JumpIfLtInt) X(JumpIfLeInt) X(JumpIfGtInt) X(JumpIfGeInt) X(JumpIfEqInt) X(JumpIfNeInt)    \
+    X(AddIntImm) X(PrintInt) X(PrintDouble) X(PrintStr) X(PrintConst) X(PrintNewline)            \
+    X(ReadInt) X(ReadDouble) X(ReadStr) X(ReadBool) X(Halt)
+
+// Budget and input check of a resumed frame (Sliced executions only).
+struct Slice {
+    std::uint64_t& budget;
+    const std::function<bool()>& inputReady;
+};
+
+template <Profiling Mode, bool Sliced>
+VmStop executeChunk(const Chunk& chunk,
+                    VmFrame& frame,
+                    std::istream& in,
+                    std::ostream& out,
+                    const VmOptions& options,
+                    const Slice* slice) {
+    // The frame is allocated up front; the loop below never allocates
+    // except inside std::string.
+    NumericSlot* n = frame.numeric.data();
+    std::string* s = frame.strings.data();
+    const double* doubles = chunk.doubles.data();
+    const std::string* constants = chunk.strings.data();
+    OpcodeTimer timer(Mode == Profiling::Opcodes ? options.profile : nullptr);
+    LineTimer lineTimer(Mode == Profiling::Lines ? options.lineProfile : nullptr, chunk);
+
+    // A sliced run stops in front of the instruction that would exceed the
+    // budget, or in front of a read with no input yet, and resumes there.
+#define VM_SUSPEND(reason)                                   \
+    do {                                                     \
+        frame.ip = static_cast<std::size_t>(ins - base);     \
+        return reason;                                       \
+    } while (false)
+#define VM_COUNT()                                           \
+    do {                                                     \
+        if constexpr (Sliced) {                              \
+            if (slice->budget == 0) {                        \
+                VM_SUSPEND(VmStop::OutOfBudget);             \
+            }                                                \
+            --slice->budget;                                 \
+        }                                                    \
+        if constexpr (Mode == Profiling::Opcodes) {          \
+            timer.step(ins->op);                             \
+        } else if constexpr (Mode == Profiling::Lines) {     \
+            lineTimer.step(ins - base);                      \
+        }                                                    \
+    } while (false)
+#define VM_AWAIT_INPUT()                                     \
+    do {                                                     \
+        if constexpr (Sliced) {                              \
+            if (!slice->inputReady()) {                      \
+                ++slice->budget;                             \
+                VM_SUSPEND(VmStop::WaitingForInput);         \
+            }                                                \
+        }                                                    \
+        out.flush();                                         \
+    } while (false)
+
+#if BEARLANG_VM_THREADED
+    const void* handlers[kOpCount] = {};
+#define BEARLANG_VM_LABEL(name, ...) handlers[static_cast<std::size_t>(Op::name)] = &&op_##name;
+    BEARLANG_VM_OPCODES(BEARLANG_VM_LABEL)
+    BEARLANG_CONVERSION_OPS(BEARLANG_VM_LABEL)
+    BEARLANG_TYPED_BINARY_OPS(BEARLANG_VM_LABEL)
+    BEARLANG_TYPED_UNARY_OPS(BEARLANG_VM_LABEL)
+#undef BEARLANG_VM_LABEL
+    // Chunks stay immutable and shareable; the handler addresses are
+    // attached to a private copy of the code.
+    std::vector<ThreadedInstruction> code;
+    code.reserve(chunk.code.size());
+    for (const Instruction& instruction : chunk.code) {
+        code.push_back(ThreadedInstruction{handlers[static_cast<std::size_t>(instruction.op)],
+                                           instruction.op, instruction.a, instruction.b,
+                                           instruction.c});
+    }
+    const ThreadedInstruction* base = code.data();
+    const ThreadedInstruction* ip = base + frame.ip;
+    const ThreadedInstruction* ins = nullptr;
+
+#define VM_OP(name) op_##name:
+#define VM_NEXT()                   \
+    do {                            \
+        ins = ip++;                 \
+        VM_COUNT();                 \
+        goto* ins->handler;         \
+    } while (false)
+
+    VM_NEXT();
+#else
+    const Instruction* base = chunk.code.data();
+    const Instruction* ip = base + frame.ip;
+    const Instruction* ins = nullptr;
+
+#define VM_OP(name) case Op::name:
+#define VM_NEXT() break
+
+    for (;;) {
+        ins = ip++;
+        VM_COUNT();
+        switch (ins->op) {
+#endif
+
+    VM_OP(LoadInt) n[ins->a].i = ins->b; VM_NEXT();
+    VM_OP(LoadDouble) n[ins->a].d = doubles[ins->b]; VM_NEXT();
+    VM_OP(LoadString) s[ins->a] = constants[ins->b]; VM_NEXT();
+    VM_OP(MoveNum) n[ins->a] = n[ins->b]; VM_NEXT();
+    VM_OP(MoveStr) s[ins->a] = s[ins->b]; VM_NEXT();
+
+    // One instantiation of the typed_ops.h templates per table entry.
+#define VM_CONVERT(name, from, to)                                                         \
+    VM_OP(name)                                                                            \
+    storeTyped(n[ins->a], convertTyped<ValueType::from, ValueType::to>(                    \
+                              typedRegister<ValueType::from>(n, s, ins->b)));              \
+    VM_NEXT();
+#define VM_BINARY(name, oper, type)                                                        \
+    VM_OP(name)                                                                            \
+    storeTyped(n[ins->a], applyTyped<BinaryOp::oper, ValueType::type>(                     \
+                              typedRegister<ValueType::type>(n, s, ins->b),                \
+                              typedRegister<ValueType::type>(n, s, ins->c)));              \
+    VM_NEXT();
+#define VM_UNARY(name, oper, type)                                                         \
+    VM_OP(name)                                                                            \
+    storeTyped(n[ins->a], applyTyped<UnaryOp::oper, ValueType::type>(                      \
+                              typedRegister<ValueType::type>(n, s, ins->b)));              \
+    VM_NEXT();
+    BEARLANG_CONVERSION_OPS(VM_CONVERT)
+    BEARLANG_TYPED_BINARY_OPS(VM_BINARY)
+    BEARLANG_TYPED_UNARY_OPS(VM_UNARY)
+#undef VM_CONVERT
+#undef VM_BINARY
+#undef VM_UNARY
+
+    VM_OP(AppendStr) s[ins->a] += s[ins->b]; VM_NEXT();
+    VM_OP(AppendConst) s[ins->a] += constants[ins->b]; VM_NEXT();
+
+    VM_OP(Jump) ip = base + ins->a; VM_NEXT();
+    VM_OP(JumpIfFalse) if (n[ins->a].i == 0) ip = base + ins->b; VM_NEXT();
+    VM_OP(JumpIfTrue) if (n[ins->a].i != 0) ip = base + ins->b; VM_NEXT();
+    VM_OP(LoopIfTrue) if (n[ins->a].i != 0) ip = base + ins->b; VM_NEXT();
+    VM_OP(ForInitInt) if (!(n[ins->a].i <= n[ins->b].i)) ip = base + ins->c; VM_NEXT();
+    VM_OP(ForLoopInt)
+        n[ins->a].i = wrapAdd(n[ins->a].i, 1);
+        if (n[ins->a].i <= n[ins->b].i) ip = base + ins->c;
+        VM_NEXT();
+
+    VM_OP(JumpIfLtInt) if (n[ins->a].i < n[ins->b].i) ip = base + ins->c; VM_NEXT();
+    VM_OP(JumpIfLeInt) if (n[ins->a].i <= n[ins->b].i) ip = base + ins->c; VM_NEXT();
+    VM_OP(JumpIfGtInt) if (n[ins->a].i > n[ins->b].i) ip = base + ins->c; VM_NEXT();
+    VM_OP(JumpIfGeInt) if (n[ins->a].i >= n[ins->b].i) ip = base + ins->c; VM_NEXT();
+    VM_OP(JumpIfEqInt) if (n[ins->a].i == n[ins->b].i) ip = base + ins->c; VM_NEXT();
+    VM_OP(JumpIfNeInt) if (n[ins->a].i != n[ins->b].i) ip = base + ins->c; VM_NEXT();
+    VM_OP(AddIntImm) n[ins->a].i = wrapAdd(n[ins->b].i, ins->c); VM_NEXT();
+
+    VM_OP(PrintInt) out << n[ins->a].i; VM_NEXT();
+    VM_OP(PrintDouble) out << n[ins->a].d; VM_NEXT();
+    VM_OP(PrintStr) out << s[ins->a]; VM_NEXT();
+    VM_OP(PrintConst) out << constants[ins->a]; VM_NEXT();
+    VM_OP(PrintNewline)
+        if (options.bufferedOutput) {
+            out << '\n';
+        } else {
+            out << std::endl;
+        }
+        VM_NEXT();
+    VM_OP(ReadInt)
+        VM_AWAIT_INPUT();
+        in >> n[ins->a].i;
+        VM_NEXT();
+    VM_OP(ReadDouble)
+        VM_AWAIT_INPUT();
+        in >> n[ins->a].d;
+        VM_NEXT();
+    VM_OP(ReadStr)
+        VM_AWAIT_INPUT();
+        in >> s[ins->a];
+        VM_NEXT();
+    VM_OP(ReadBool) {
+        VM_AWAIT_INPUT();
+        bool value = n[ins->a].i != 0;
+        in >> value;
+        n[ins->a].i = value;
+        VM_NEXT();
+    }
+
+    VM_OP(Halt)
+        if constexpr (Mode == Profiling::Opcodes) {
+            timer.finish();
+        }
+        out.flush();
+        // Resuming a finished frame halts again.
+        frame.ip = static_cast<std::size_t>(ins - base);
+        return VmStop::Halted;
+
+#if !BEARLANG_VM_THREADED
+        }
+    }
+#endif
+#undef VM_OP
+#undef VM_NEXT
+#undef VM_COUNT
+#undef VM_SUSPEND
+#undef VM_AWAIT_INPUT
+}
+
+}  // namespace
+
+void VirtualMachine::run(const Program& program,
+                         std::istream& in,
+                         std::ostream& out,
+                         const VmOptions& options) {
+    execute(BytecodeCompiler::compile(program), in, out, options);
+}
+
+void VirtualMachine::execute(const Chunk& chunk,
+                             std::istream& in,
+                             std::ostream& out,
+                             const VmOptions& options) {
+    VmFrame frame = newFrame(chunk);
+    if (options.profile) {
+        executeChunk<Profiling::Opcodes, false>(chunk, frame, in, out, options, nullptr);
+    } else if (options.lineProfile) {
+        try {
+            executeChunk<Profiling::Lines, false>(chunk, frame, in, out, options, nullptr);
+        } catch (const LineLimitReached&) {
+            options.lineProfile->stopped = true;
+        }
+    } else {
+        executeChunk<Profiling::Off, false>(chunk, frame, in, out, options, nullptr);
+    }
+}
+
+VmFrame VirtualMachine::newFrame(const Chunk& chunk) {
+    VmFrame frame;
+    frame.numeric.resize(chunk.numericSlots + 1);
+    frame.strings.resize(chunk.stringSlots + 1);
+    return frame;
+}
+
+VmStop VirtualMachine::resume(const Chunk& chunk,
+                              VmFrame& frame,
+                              std::istream& in,
+                              std::ostream& out,
+                              std::uint64_t& budget,
+                              const std::function<bool()>& inputReady) {
+    Slice slice{budget, inputReady};
+    return executeChunk<Profiling::Off, true>(chunk, frame, in, out, VmOptions{}, &slice);
+}
+
+const char* VirtualMachine::dispatchName() {
+    return BEARLANG_VM_THREADED ? "threaded" : "switch";
+}
+
+std::string formatProfile(const VmProfile& profile) {
+    double total = 0.0;
+    std::vector<std::size_t> ops;
+    for (std::size_t i = 0; i < kOpCount; ++i) {
+        total += profile.nanoseconds[i];
+        if (profile.counts[i] > 0) {
+            ops.push_back(i);
+        }
+    }
+    std::sort(ops.begin(), ops.end(), [&profile](std::size_t a, std::size_t b) {
+        return profile.nanoseconds[a] > profile.nanoseconds[b];
+    });
+
+    std::ostringstream report;
+    report.setf(std::ios::fixed);
+    report.precision(1);
+    // The header is padded by hand: setw counts bytes, not Cyrillic letters.
+    report << "опкод             выполнений       мс    нс/оп   доля\n";
+    for (std::size_t i : ops) {
+        std::string name = opName(static_cast<Op>(i));
+        name.resize(std::max<std::size_t>(name.size(), 16), ' ');
+        double share = total > 0.0 ? 100.0 * profile.nanoseconds[i] / total : 0.0;
+        report << name << std::setw(12) << profile.counts[i] << std::setw(9)
+               << profile.nanoseconds[i] / 1e6 << std::setw(9)
+               << profile.nanoseconds[i] / static_cast<double>(profile.counts[i]) << std::setw(6)
+               << share << "%\n";
+    }
+
+    std::vector<std::size_t> pairs;
+    for (std::size_t i = 0; i < profile.pairs.size(); ++i) {
+        if (profile.pairs[i] > 0) {
+            pairs.push_back(i);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [&profile](std::size_t a, std::size_t b) {
+        return profile.pairs[a] > profile.pairs[b];
+    });
+    if (pairs.size() > 10) {
+        pairs.resize(10);
+    }
+    report << "частые пары опкодов:\n";
+    for (std::size_t pair : pairs) {
+        report << "  " << opName(static_cast<Op>(pair / kOpCount)) << " -> "
+               << opName(static_cast<Op>(pair % kOpCount)) << "  " << profile.pairs[pair] << "\n";
+    }
+    return report.str();
+}
+
+std::string formatLineProfile(const VmLineProfile& profile,
+                              const Chunk& chunk,
+                              const std::string& source) {
+    std::vector<std::string> text;
+    std::istringstream lines(source);
+    for (std::string line; std::getline(lines, line);) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        text.push_back(line);
+    }
+    auto sourceLine = [&text](std::size_t line) {
+        std::string shown = line >= 1 && line <= text.size() ? text[line - 1] : std::string();
+        shown.erase(0, std::min(shown.find_first_not_of(' '), shown.size()));
+        return shown;
+    };
+    double total = 0.0;
+    for (double nanoseconds : profile.nanoseconds) {
+        total += nanoseconds;
+    }
+    auto share = [total](double nanoseconds) {
+        return total > 0.0 ? 100.0 * nanoseconds / total : 0.0;
+    };
+
+    std::ostringstream report;
+    report.setf(std::ios::fixed);
+    report.precision(1);
+
+    // Line 0 is the prologue, not a line of the program.
+    std::vector<std::size_t> hot;
+    for (std::size_t line = 1; line < profile.operations.size(); ++line) {
+        if (profile.operations[line] > 0) {
+            hot.push_back(line);
+        }
+    }
+    std::sort(hot.begin(), hot.end(), [&profile](std::size_t a, std::size_t b) {
+        return profile.nanoseconds[a] > profile.nanoseconds[b];
+    });
+    if (hot.size() > 10) {
+        hot.resize(10);
+    }
+    report << "горячие строки:\n";
+    for (std::size_t line : hot) {
+        report << "  " << std::setw(4) << line << std::setw(7) << share(profile.nanoseconds[line])
+               << "%" << std::setw(12) << profile.hits[line] << " проходов  " << sourceLine(line)
+               << "\n";
+    }
+
+    struct LoopRow {
+        LoopLines lines;
+        std::uint64_t operations;
+        double nanoseconds;
+    };
+    std::vector<LoopRow> loops;
+    for (const LoopLines& loop : chunk.loops) {
+        LoopRow row{loop, 0, 0.0};
+        for (std::size_t line = loop.first;
+             line <= loop.last && line < profile.operations.size(); ++line) {
+            row.operations += profile.operations[line];
+            row.nanoseconds += profile.nanoseconds[line];
+        }
+        if (row.operations > 0) {
+            loops.push_back(row);
+        }
+    }
+    std::sort(loops.begin(), loops.end(), [](const LoopRow& a, const LoopRow& b) {
+        return a.nanoseconds > b.nanoseconds;
+    });
+    if (!loops.empty()) {
+        report << "циклы (вместе с вложенными строками):\n";
+    }
+    for (const LoopRow& loop : loops) {
+        report << "  " << std::setw(4) << loop.lines.first << "-" << std::setw(4) << std::left
+               << loop.lines.last << std::right << std::setw(7) << share(loop.nanoseconds)
+               << "%" << std::setw(12) << loop.operations << " операций  "
+               << sourceLine(loop.lines.first) << "\n";
+    }
+
+    // Counts in front of the source; setw counts bytes, so the Cyrillic
+    // header is padded by hand.
+    report << "строка    проходы    операции        мс   доля | текст\n";
+    for (std::size_t line = 1; line <= text.size(); ++line) {
+        report << std::setw(6) << line;
+        if (line < profile.operations.size() && profile.operations[line] > 0) {
+            report << std::setw(11) << profile.hits[line] << std::setw(12)
+                   << profile.operations[line] << std::setw(10)
+                   << profile.nanoseconds[line] / 1e6 << std::setw(6)
+                   << share(profile.nanoseconds[line]) << "%";
+        } else {
+            report << std::string(40, ' ');
+        }
+        report << " | " << text[line - 1] << "\n";
+    }
+    return report.str();
+}
+
+}  // namespace bearlang
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "core/parser/ast.h"
+
+namespace bearlang {
+
+// Filled by a profiled run: how often each opcode ran and how long it took
+// including its dispatch, plus how often each opcode followed another. The
+// pair counts are what superinstructions are chosen from.
+struct VmProfile {
+    std::array<std::uint64_t, kOpCount> counts{};
+    std::array<double, kOpCount> nanoseconds{};
+    std::vector<std::uint64_t> pairs = std::vector<std::uint64_t>(kOpCount * kOpCount);
+};
+
+// Filled by a line-profiled run, indexed by source line (Chunk::lines): how
+// often each line ran, how many instructions it executed and its wall time.
+// Time is sampled, so a line that ran for less than a few hundred
+// microseconds in total may show none.
+struct VmLineProfile {
+    std::vector<std::uint64_t> hits;
+    std::vector<std::uint64_t> operations;
+    std::vector<double> nanoseconds;
+    // When non-zero, a run still going after this long is cut off, as a
+    // grading timeout would, and `stopped` is set; the counts cover the part
+    // that ran.
+    std::chrono::milliseconds limit{0};
+    bool stopped = false;
+};
+
+struct VmOptions {
+    // Same meaning as InterpreterOptions::bufferedOutput.
+    bool bufferedOutput = true;
+    // When set, execution is timed per opcode. Slower; for measurements only.
+    VmProfile* profile = nullptr;
+    // When set (and profile is not), execution is counted and timed per
+    // source line.
+    VmLineProfile* lineProfile = nullptr;
+};
+
+// Registers and position of a run that can be suspended and resumed.
+struct VmFrame {
+    std::vector<NumericSlot> numeric;
+    std::vector<std::string> strings;
+    // Index of the next instruction.
+    std::size_t ip = 0;
+};
+
+enum class VmStop { Halted, OutOfBudget, WaitingForInput };
+
+// Executes BearLang as register bytecode. Results, input handling and
+// RuntimeError conditions are the same as in Interpreter, and the program
+// must likewise have passed checkProgram. BytecodeCompiler fixes every type
+// ahead of time, so the VM never inspects a value's type.
+//
+// With GCC or Clang the loop is direct-threaded: each instruction carries the
+// address of its handler (labels as values) and every handler jumps straight
+// to the next one. Other compilers, or BEARLANG_VM_SWITCH_DISPATCH, use a
+// portable switch.
+class VirtualMachine {
+public:
+    static void run(const Program& program,
+                    std::istream& in,
+                    std::ostream& out,
+                    const VmOptions& options = {});
+
+    static void execute(const Chunk& chunk,
+                        std::istream& in,
+                        std::ostream& out,
+                        const VmOptions& options = {});
+
+    // A zeroed frame positioned at the first instruction.
+    static VmFrame newFrame(const Chunk& chunk);
+
+    // Continues `frame` for at most `budget` instructions, decrementing it.
+    // Before each `ввод` it asks `inputReady`; on false the frame stops in
+    // front of the read and can be resumed once input has arrived.
+    // RuntimeError propagates as from execute().
+    static VmStop resume(const Chunk& chunk,
+                         VmFrame& frame,
+                         std::istream& in,
+                         std::ostream& out,
+                         std::uint64_t& budget,
+                         const std::function<bool()>& inputReady);
+
+    // "threaded" or "switch".
+    static const char* dispatchName();
+};
+
+// Opcodes by share of time, then the most frequent adjacent pairs.
+std::string formatProfile(const VmProfile& profile);
+
+// The hottest lines and loops, then `source` with the counts and time of
+// every line in front of it.
+std::string formatLineProfile(const VmLineProfile& profile,
+                              const Chunk& chunk,
+                              const std::string& source);
+
+}  // namespace bearlang